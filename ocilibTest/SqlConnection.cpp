@@ -1,8 +1,62 @@
-// -----------------------------------------------------------------------------	
+// -----------------------------------------------------------------------------
 #include "SqlConnection.h"
-// -----------------------------------------------------------------------------	
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <atomic>
+// -----------------------------------------------------------------------------
+void SqlConnectionLease::Release()
+{
+	if (m_pool && m_sql)
+	{
+		m_pool->Release(m_sql);
+	}
+	m_pool = nullptr;
+	m_sql = nullptr;
+}
+// -----------------------------------------------------------------------------
+struct SqlConnection::ThreadPins
+{
+	struct Pin
+	{
+		uint64_t pool_id;
+		std::weak_ptr<SqlConnection*> pool;
+		TMyOracle* sql;
+	};
+	std::vector<Pin> pins;
+
+	// The connections of a thread that did not unpin go back to their pools
+	~ThreadPins()
+	{
+		for (const Pin& pin : pins)
+		{
+			if (std::shared_ptr<SqlConnection*> pool = pin.pool.lock())
+			{
+				pin.sql->UnbindThread();
+				(*pool)->Release(pin.sql);
+			}
+		}
+	}
+};
+// -----------------------------------------------------------------------------
+SqlConnection::ThreadPins& SqlConnection::Pins()
+{
+	thread_local ThreadPins pins;
+	return pins;
+}
+// -----------------------------------------------------------------------------
+uint64_t SqlConnection::NextId()
+{
+	static std::atomic<uint64_t> next{ 0 };
+	return ++next;
+}
+// -----------------------------------------------------------------------------
 void SqlConnection::Disconnect()
 {
+	JoinWarmup();
+	StopHealthCheck();
+
+	std::lock_guard<std::mutex> lock(m_pool_mutex);
+
 	for (auto& sql : m_sqls)
 	{
 		if (sql)
@@ -11,41 +65,490 @@ void SqlConnection::Disconnect()
 		}
 	}
 
+	m_free.clear();
 	m_sqls.clear();
+
+	m_session_pool.reset();
 }
-// -----------------------------------------------------------------------------	
-bool SqlConnection::Build()
+// -----------------------------------------------------------------------------
+bool SqlConnection::CreateSessionPool()
+{
+	const unsigned int min_sessions = static_cast<unsigned int>(m_min_connections);
+	const unsigned int max_sessions = static_cast<unsigned int>(m_max_connections);
+	const unsigned int increment = static_cast<unsigned int>(m_pool_increment);
+
+	m_session_pool = TMyOracleDriver::CreatePool(m_type, m_db, m_user, m_password, min_sessions, max_sessions, increment, m_statement_cache_size);
+	if (!m_session_pool)
+	{
+		TMYORACLE_LOG_FATAL("SqlConnection::CreateSessionPool(): Failed to create the session pool on ", m_db);
+		return false;
+	}
+
+	TMYORACLE_LOG_INFO("Session pool created on ", m_db, " (", min_sessions, "..", max_sessions, " sessions)");
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool SqlConnection::Attach(TMyOracle* sql)
+{
+	return m_session_pool && sql->Connect(*m_session_pool);
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracle> SqlConnection::Open()
 {
 	try
 	{
-		for (int i = 0; i < m_max_connections; ++i)
+		std::unique_ptr<TMyOracle> sql(new TMyOracle(m_type));
+		sql->SetResultCache(m_result_cache);
+		sql->SetCallTimeout(m_call_timeout);
+		if (m_pool_type == SQL_POOL_TYPE::SESSION_POOL)
+		{
+			return sql;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const bool connected = sql->Connect(m_user, m_password, m_db);
+		const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+		if (connected)
+		{
+			TMYORACLE_LOG_INFO("[", sql->GetConnInstanceCounter(), "] Logon took ", latency.count() / 1000.0, " ms");
+
+			std::lock_guard<std::mutex> lock(m_pool_mutex);
+			m_logon_latencies.push_back(latency);
+			return sql;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] SqlConnection::Open(): ", ex.what());
+	}
+	return nullptr;
+}
+// -----------------------------------------------------------------------------
+bool SqlConnection::OpenFree()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		if (m_sqls.size() + m_opening >= m_max_connections)
+		{
+			return true;
+		}
+		++m_opening;
+	}
+
+	std::unique_ptr<TMyOracle> sql = Open();
+	const bool opened = sql != nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		--m_opening;
+		if (opened)
 		{
-			std::unique_ptr<TMyOracle> sql(new TMyOracle(m_type));
-			if (!sql->Connect(m_user, m_password, m_db))
+			m_free.push_back({ sql.get(), std::chrono::steady_clock::now() });
+			m_sqls.emplace_back(std::move(sql));
+		}
+	}
+
+	// Wake a waiter either for the new connection or to grow the pool itself
+	m_pool_cv.notify_one();
+	return opened;
+}
+// -----------------------------------------------------------------------------
+bool SqlConnection::Warmup(size_t count)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::atomic<size_t> next{ 0 };
+	std::atomic<bool> success{ true };
+
+	auto Connector = [this, count, &next, &success]()
+	{
+		while (next++ < count)
+		{
+			if (!OpenFree())
 			{
-				return false;
+				success = false;
 			}
+		}
+	};
+
+	// Logons are network bound, keep several in flight at once
+	const size_t threads = std::min(count, m_warmup_threads);
+	std::vector<std::thread> connectors;
+	for (size_t i = 1; i < threads; ++i)
+	{
+		connectors.emplace_back(Connector);
+	}
+	Connector();
+	for (auto& connector : connectors)
+	{
+		connector.join();
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	TMYORACLE_LOG_INFO("SqlConnection: ", count, " connection(s) opened on ", std::max<size_t>(threads, 1), " thread(s) in ", elapsed.count(), " ms");
+
+	return success;
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::JoinWarmup()
+{
+	if (m_warmup.joinable())
+	{
+		m_warmup.join();
+	}
+}
+// -----------------------------------------------------------------------------
+bool SqlConnection::Build()
+{
+	if (m_pool_type == SQL_POOL_TYPE::SESSION_POOL)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		if (!CreateSessionPool())
+		{
+			return false;
+		}
 
+		// The pool opened its sessions, TMyOracle objects are only wrappers
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		m_logon_latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+		for (size_t i = 0; i < m_min_connections; ++i)
+		{
+			std::unique_ptr<TMyOracle> sql = Open();
+			if (!sql)
+			{
+				TMYORACLE_LOG_FATAL("SqlConnection::Build(): Failed to create a pooled connection");
+				return false;
+			}
+			m_free.push_back({ sql.get(), std::chrono::steady_clock::now() });
 			m_sqls.emplace_back(std::move(sql));
 		}
+		return true;
+	}
 
+	if (m_lazy_build && m_min_connections > 1)
+	{
+		// Ready as soon as one connection works, the rest follow in background
+		if (!OpenFree())
+		{
+			return false;
+		}
+
+		JoinWarmup();
+		m_warmup = std::thread([this]()
+		{
+			if (!Warmup(m_min_connections - 1))
+			{
+				TMYORACLE_LOG_WARN("SqlConnection::Build(): Background warm-up could not open every connection");
+			}
+		});
 		return true;
 	}
-	catch (const std::exception& ex)
+
+	return Warmup(m_min_connections);
+}
+// -----------------------------------------------------------------------------
+SqlConnectionLease SqlConnection::Acquire(std::chrono::milliseconds timeout)
+{
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	TMyOracle* sql = nullptr;
+
+	std::unique_lock<std::mutex> lock(m_pool_mutex);
+	while (!sql)
 	{
-		std::cerr << "[EXCEPTION] SqlConnection::Build(): " << ex.what() << std::endl;
+		// Lost connections log on again and the pool grows only once the
+		// backoff of the failed logons allows it
+		const auto now = std::chrono::steady_clock::now();
+		const bool logon = m_pool_type != SQL_POOL_TYPE::DEDICATED || now >= m_next_logon;
+
+		// The most recently released connection usable now
+		auto free = std::find_if(m_free.rbegin(), m_free.rend(), [logon](const FreeConnection& connection) { return logon || connection.sql->IsConnected(); });
+		if (free != m_free.rend())
+		{
+			sql = free->sql;
+			m_free.erase(std::next(free).base());
+
+			// Never hand out a connection known to be lost: log it on again
+			// outside the lock, or take the next one
+			if (m_pool_type == SQL_POOL_TYPE::DEDICATED && !sql->IsConnected())
+			{
+				lock.unlock();
+				const bool revived = Revive(sql);
+				lock.lock();
+				if (!revived)
+				{
+					sql = nullptr;
+					continue;
+				}
+			}
+			break;
+		}
+
+		// Grow on demand, connecting outside the lock
+		if (logon && m_sqls.size() + m_opening < m_max_connections)
+		{
+			++m_opening;
+			lock.unlock();
+			std::unique_ptr<TMyOracle> opened = Open();
+			lock.lock();
+			--m_opening;
+
+			// A session pool connection has no session yet, no logon was made
+			if (m_pool_type == SQL_POOL_TYPE::DEDICATED)
+			{
+				LogonDone(opened != nullptr);
+			}
+
+			if (!opened)
+			{
+				// Let another waiter try its luck
+				m_pool_cv.notify_one();
+				TMYORACLE_LOG_WARN("SqlConnection::Acquire(): Failed to open a new connection");
+				return {};
+			}
+
+			sql = opened.get();
+			m_sqls.emplace_back(std::move(opened));
+			break;
+		}
+
+		if (now >= deadline)
+		{
+			TMYORACLE_LOG_WARN("SqlConnection::Acquire(): No connection available after ", timeout.count(), " ms");
+			return {};
+		}
+
+		// Until a release, or the end of the backoff when a logon could
+		// provide a connection
+		m_pool_cv.wait_until(lock, logon ? deadline : std::min(deadline, m_next_logon));
 	}
-	return false;
+	lock.unlock();
+
+	// A session pool lease needs a session for its duration
+	if (m_pool_type == SQL_POOL_TYPE::SESSION_POOL && !Attach(sql))
+	{
+		Release(sql);
+		return {};
+	}
+
+	return SqlConnectionLease(this, sql);
 }
 // -----------------------------------------------------------------------------
-TMyOracle* SqlConnection::GetConnection()
+TMyOracle* SqlConnection::Pin(std::chrono::milliseconds timeout)
 {
-	if (m_sqls.empty())
+	ThreadPins& pins = Pins();
+	for (const ThreadPins::Pin& pin : pins.pins)
+	{
+		if (pin.pool_id == m_id)
+		{
+			return pin.sql;
+		}
+	}
+
+	SqlConnectionLease lease = Acquire(timeout);
+	if (!lease)
 	{
-		std::cerr << "[WARN] SqlConnection::GetConnection(): No available connections" << std::endl;
 		return nullptr;
 	}
-	m_curr_conn_index = (m_curr_conn_index + 1) % m_sqls.size();
-	return m_sqls[m_curr_conn_index].get();
+
+	TMyOracle* sql = lease.Detach();
+	sql->BindThread();
+	pins.pins.push_back({ m_id, m_alive, sql });
+	return sql;
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::Unpin()
+{
+	std::vector<ThreadPins::Pin>& pins = Pins().pins;
+	auto it = std::find_if(pins.begin(), pins.end(), [this](const ThreadPins::Pin& pin) { return pin.pool_id == m_id; });
+	if (it == pins.end())
+	{
+		return;
+	}
+
+	TMyOracle* sql = it->sql;
+	pins.erase(it);
+	sql->UnbindThread();
+	Release(sql);
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::Release(TMyOracle* sql)
+{
+	// Give the session back to the session pool
+	if (m_pool_type == SQL_POOL_TYPE::SESSION_POOL)
+	{
+		sql->Disconnect();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		m_free.push_back({ sql, std::chrono::steady_clock::now() });
+	}
+	m_pool_cv.notify_one();
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::StartHealthCheck(std::chrono::milliseconds interval)
+{
+	StopHealthCheck();
+
+	if (m_pool_type != SQL_POOL_TYPE::DEDICATED || interval.count() <= 0)
+	{
+		return;
+	}
+
+	m_health_stop = false;
+	m_health_check = std::thread([this, interval]()
+	{
+		std::unique_lock<std::mutex> lock(m_health_mutex);
+		while (!m_health_cv.wait_for(lock, interval, [this]() { return m_health_stop; }))
+		{
+			lock.unlock();
+			CheckHealth(interval);
+			lock.lock();
+		}
+	});
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::StopHealthCheck()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_health_mutex);
+		m_health_stop = true;
+	}
+	m_health_cv.notify_all();
+
+	if (m_health_check.joinable())
+	{
+		m_health_check.join();
+	}
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::CheckHealth(std::chrono::milliseconds interval)
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	// The connections idle for interval leave the free list while pinged,
+	// the others keep their order
+	std::vector<TMyOracle*> idle;
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		auto it = std::stable_partition(m_free.begin(), m_free.end(), [now, interval](const FreeConnection& free) { return now - free.since < interval; });
+		for (auto idle_it = it; idle_it != m_free.end(); ++idle_it)
+		{
+			idle.push_back(idle_it->sql);
+		}
+		m_free.erase(it, m_free.end());
+	}
+
+	for (TMyOracle* sql : idle)
+	{
+		// A ping failing on anything but a lost session leaves it alive, a
+		// connection already known lost is not pinged again
+		bool alive = false;
+		if (sql->IsConnected())
+		{
+			alive = sql->Ping() || sql->IsConnected();
+
+			std::lock_guard<std::mutex> lock(m_pool_mutex);
+			++m_health.pings;
+		}
+
+		if (alive || Revive(sql))
+		{
+			// Back at the bottom of the free list, the busy connections
+			// stay on top
+			{
+				std::lock_guard<std::mutex> lock(m_pool_mutex);
+				m_free.insert(m_free.begin(), { sql, std::chrono::steady_clock::now() });
+			}
+			m_pool_cv.notify_one();
+		}
+	}
+
+	// Back to min_connections once the database answers again
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pool_mutex);
+			if (m_sqls.size() + m_opening >= m_min_connections || std::chrono::steady_clock::now() < m_next_logon)
+			{
+				break;
+			}
+		}
+
+		const bool opened = OpenFree();
+
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		LogonDone(opened);
+		if (!opened)
+		{
+			++m_health.failed_opens;
+			break;
+		}
+	}
 }
-// -----------------------------------------------------------------------------
\ No newline at end of file
+// -----------------------------------------------------------------------------
+bool SqlConnection::Revive(TMyOracle* sql)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		++m_health.dead;
+		if (std::chrono::steady_clock::now() < m_next_logon)
+		{
+			// Kept for a try once the backoff ends, below the live ones
+			m_free.insert(m_free.begin(), { sql, std::chrono::steady_clock::now() });
+			return false;
+		}
+	}
+
+	const bool reconnected = sql->Reconnect();
+
+	std::unique_ptr<TMyOracle> evicted;
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		LogonDone(reconnected);
+		if (reconnected)
+		{
+			++m_health.reconnects;
+			return true;
+		}
+
+		TMYORACLE_LOG_WARN("SqlConnection: Connection [", sql->GetConnInstanceCounter(), "] is lost and dropped from the pool");
+		evicted = Evict(sql);
+	}
+
+	// Closing the dead session can take a network timeout, out of the lock
+	evicted.reset();
+
+	// Wake a waiter to open a connection in its place
+	m_pool_cv.notify_one();
+	return false;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracle> SqlConnection::Evict(TMyOracle* sql)
+{
+	std::unique_ptr<TMyOracle> evicted;
+	auto it = std::find_if(m_sqls.begin(), m_sqls.end(), [sql](const std::unique_ptr<TMyOracle>& owned) { return owned.get() == sql; });
+	if (it != m_sqls.end())
+	{
+		evicted = std::move(*it);
+		m_sqls.erase(it);
+		++m_health.evictions;
+	}
+	return evicted;
+}
+// -----------------------------------------------------------------------------
+void SqlConnection::LogonDone(bool success)
+{
+	if (success)
+	{
+		m_logon_backoff = std::chrono::milliseconds(0);
+		m_next_logon = std::chrono::steady_clock::time_point();
+		return;
+	}
+
+	m_logon_backoff = m_logon_backoff.count() == 0 ? FIRST_LOGON_RETRY : std::min(m_logon_backoff * 2, LAST_LOGON_RETRY);
+	m_next_logon = std::chrono::steady_clock::now() + m_logon_backoff;
+}
+// -----------------------------------------------------------------------------
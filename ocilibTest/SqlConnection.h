@@ -3,29 +3,141 @@
 // -----------------------------------------------------------------------------
 #include "utils.h"
 #include "TMyOracle.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+// -----------------------------------------------------------------------------
+class SqlConnection;
+// -----------------------------------------------------------------------------
+enum class SQL_POOL_TYPE
+{
+	DEDICATED = 1,		// one dedicated session per TMyOracle, opened by SqlConnection
+	SESSION_POOL = 2	// driver session pool, TMyOracle takes a session per lease
+};
 // -----------------------------------------------------------------------------
 
-class SqlConnection
+// Exclusive use of one pooled connection. The connection goes back to the
+// pool when the lease is released or destroyed.
+class SqlConnectionLease
 {
+	friend class SqlConnection;
+
 public:
-	explicit SqlConnection(const std::string& user, const std::string& password, const std::string& db, OCI_TYPE type = OCI_TYPE::OCI_C_API)
-		: m_user(user), m_password(password), m_db(db), m_type(type)
+	SqlConnectionLease() = default;
+	SqlConnectionLease(SqlConnection* pool, TMyOracle* sql) : m_pool(pool), m_sql(sql) {}
+	~SqlConnectionLease() { Release(); }
+
+	// Prevent copying
+	SqlConnectionLease(const SqlConnectionLease&) = delete;
+	SqlConnectionLease& operator=(const SqlConnectionLease&) = delete;
+
+	// Allow moving
+	SqlConnectionLease(SqlConnectionLease&& other) noexcept : m_pool(other.m_pool), m_sql(other.m_sql)
+	{
+		other.m_pool = nullptr;
+		other.m_sql = nullptr;
+	}
+	SqlConnectionLease& operator=(SqlConnectionLease&& other) noexcept
 	{
-		if (m_type == OCI_TYPE::OCI_C_API)
+		if (this != &other)
 		{
-			// Initialize OCI C API
-			OCI_Initialize(nullptr, nullptr, OCI_ENV_THREADED | OCI_ENV_CONTEXT);
-			OCI_EnableWarnings(true);
+			Release();
+			m_pool = other.m_pool;
+			m_sql = other.m_sql;
+			other.m_pool = nullptr;
+			other.m_sql = nullptr;
 		}
+		return *this;
+	}
+
+	void Release();
+
+	TMyOracle* get() const { return m_sql; }
+	TMyOracle* operator->() const { return m_sql; }
+	explicit operator bool() const { return m_sql != nullptr; }
+
+private:
+	// Gives up the connection without releasing it
+	TMyOracle* Detach()
+	{
+		TMyOracle* sql = m_sql;
+		m_pool = nullptr;
+		m_sql = nullptr;
+		return sql;
+	}
+
+	SqlConnection* m_pool = nullptr;
+	TMyOracle* m_sql = nullptr;
+};
+
+// Counters of SqlConnection::StartHealthCheck() and of the liveness check of
+// Acquire()
+struct SqlConnectionHealthStats
+{
+	// Idle connections pinged
+	uint64_t pings = 0;
+	// Connections found lost, by a ping or by Acquire()
+	uint64_t dead = 0;
+	// Lost connections logged on again by the pool
+	uint64_t reconnects = 0;
+	// Lost connections that could not log on again and left the pool
+	uint64_t evictions = 0;
+	// Failed logons of the refill back to min_connections
+	uint64_t failed_opens = 0;
+};
+
+// Pool of TMyOracle connections handed out one caller at a time.
+//
+// Build() opens min_connections. Acquire() takes a free connection, opens a
+// new one while fewer than max_connections exist, or waits for a release.
+// All leases must be released before Disconnect().
+//
+// With SQL_POOL_TYPE::SESSION_POOL, Build() creates a driver session pool of
+// min_connections..max_connections sessions instead, and every lease gets a
+// session from it for its duration. Prepared statements then only live as
+// long as a lease; the pool statement cache keeps the parses.
+//
+// Build() logs on up to SetWarmupThreads() connections at once. With
+// SetLazyBuild(true) it returns after the first connection and the others
+// are opened in the background.
+//
+// Workers that keep to one connection use Pin() instead of Acquire(), see
+// there.
+//
+// Acquire() never hands out a connection known to be lost, see
+// TMyOracle::IsConnected(): it reconnects it first, or drops it. After a
+// failed logon, lost connections stay in the pool untried and the pool does
+// not grow until the backoff described at StartHealthCheck() ends; Acquire()
+// waits for it within its timeout. A server restart is otherwise only found
+// by the next call of every connection; StartHealthCheck() finds it on the
+// idle ones in the background.
+class SqlConnection
+{
+	friend class SqlConnectionLease;
+
+public:
+	explicit SqlConnection(const std::string& user, const std::string& password, const std::string& db, OCI_TYPE type = OCI_TYPE::OCI_C_API,
+		size_t min_connections = 2, size_t max_connections = 10, SQL_POOL_TYPE pool_type = SQL_POOL_TYPE::DEDICATED)
+		: m_type(type), m_pool_type(pool_type), m_user(user), m_password(password), m_db(db),
+		m_min_connections(min_connections), m_max_connections(std::max<size_t>(max_connections, 1)),
+		m_id(NextId()), m_alive(std::make_shared<SqlConnection*>(this))
+	{
+		m_min_connections = std::min(m_min_connections, m_max_connections);
+
+		// Initialize the client library of the driver
+		TMyOracleDriver::Initialize(m_type);
 	}
 
 	virtual ~SqlConnection()
-	{	
-		if (m_type == OCI_TYPE::OCI_C_API)
-		{
-			// Cleanup OCI C API
-			OCI_Cleanup();
-		}
+	{
+		// Threads exiting from now on leave their pins alone
+		m_alive.reset();
+		JoinWarmup();
+
+		// Sessions and the pool must be gone before the client library
+		Disconnect();
+		TMyOracleDriver::Cleanup(m_type);
 	}
 
 	void Disconnect();
@@ -35,30 +147,191 @@ private:
 	SqlConnection& operator=(const SqlConnection&) = delete;
 	SqlConnection(SqlConnection&&) = delete;
 	SqlConnection& operator=(SqlConnection&&) = delete;
-	
+
 
 public:
 	bool Build();
 	bool IsConnected() const
 	{
-		return !m_sqls.empty();
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		return !m_sqls.empty() || m_session_pool;
+	}
+
+	// Session pool settings, used by Build()
+	void SetPoolIncrement(size_t increment) { m_pool_increment = std::max<size_t>(increment, 1); }
+	void SetStatementCacheSize(unsigned int size) { m_statement_cache_size = size; }
+	SQL_POOL_TYPE GetPoolType() const { return m_pool_type; }
+
+	// Result cache given to every connection opened afterwards, so set it
+	// before Build()
+	void SetResultCache(std::shared_ptr<TMyOracleResultCache> cache) { m_result_cache = std::move(cache); }
+	const std::shared_ptr<TMyOracleResultCache>& GetResultCache() const { return m_result_cache; }
+
+	// Call timeout of every connection opened afterwards, see
+	// TMyOracle::SetCallTimeout()
+	void SetCallTimeout(std::chrono::milliseconds timeout) { m_call_timeout = timeout; }
+	std::chrono::milliseconds GetCallTimeout() const { return m_call_timeout; }
+
+	// Health checker: every interval, pings the connections idle for at
+	// least interval, reconnects the lost ones or drops them, and opens new
+	// ones back to min_connections. After a failed logon the pool makes no
+	// other for a while, 100 ms doubling up to 10 s, until one succeeds.
+	// Dedicated connections only, a session pool checks its own sessions.
+	void StartHealthCheck(std::chrono::milliseconds interval);
+	void StopHealthCheck();
+	SqlConnectionHealthStats GetHealthStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		return m_health;
+	}
+
+	// Warm-up settings, used by Build()
+	void SetWarmupThreads(size_t threads) { m_warmup_threads = std::max<size_t>(threads, 1); }
+	void SetLazyBuild(bool lazy) { m_lazy_build = lazy; }
+
+	// Logon time of every connection opened so far, in opening order
+	std::vector<std::chrono::microseconds> GetLogonLatencies() const
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		return m_logon_latencies;
+	}
+
+	// Takes a connection for exclusive use. Waits up to timeout for one to be
+	// released when max_connections are all in use; the lease is empty if
+	// none became available or a new connection could not be opened.
+	SqlConnectionLease Acquire(std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+	// Thread-affine mode. Returns the connection pinned to the calling
+	// thread: leased from the pool on the first call of the thread and bound
+	// to it (see TMyOracle::BindThread()), then found again in a thread
+	// local slot without taking any lock. The connection is used without its
+	// mutex, so the thread must not hand it to another one.
+	//
+	// A pin is a lease held until Unpin() or the exit of the thread, every
+	// thread must let go of it before Disconnect(). Needs a connection per
+	// pinning thread; nullptr if none became available within timeout.
+	TMyOracle* Pin(std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+	void Unpin();
+
+	size_t Size() const
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		return m_sqls.size();
+	}
+	size_t MaxConnections() const { return m_max_connections; }
+
+	// Metrics of every connection opened so far, labelled conn="N" for
+	// TMyOracleMetrics::WritePrometheus()
+	std::vector<std::pair<std::string, TMyOracleMetricsSnapshot>> GetMetrics() const
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		std::vector<std::pair<std::string, TMyOracleMetricsSnapshot>> metrics;
+		for (const auto& sql : m_sqls)
+		{
+			metrics.emplace_back("conn=\"" + std::to_string(sql->GetConnInstanceCounter()) + "\"", sql->GetMetrics().Snapshot());
+		}
+		return metrics;
+	}
+	// Clears the metrics of every connection and the global ones
+	void ResetMetrics()
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		for (const auto& sql : m_sqls)
+		{
+			sql->GetMetrics().Reset();
+		}
+		TMyOracleMetrics::Global().Reset();
+	}
+	size_t Available() const
+	{
+		std::lock_guard<std::mutex> lock(m_pool_mutex);
+		return m_free.size();
 	}
-	TMyOracle* GetConnection();
 
 private:
+	// Opens one more connection, nullptr on failure. With a session pool
+	// the connection only gets a session in Attach().
+	std::unique_ptr<TMyOracle> Open();
+	bool Attach(TMyOracle* sql);
+	// Opens one connection into the free list unless the pool is full
+	bool OpenFree();
+	// Opens count connections on up to m_warmup_threads threads
+	bool Warmup(size_t count);
+	void JoinWarmup();
+	bool CreateSessionPool();
+	void Release(TMyOracle* sql);
+
+	// One pass of the health checker
+	void CheckHealth(std::chrono::milliseconds interval);
+	// Logs a lost connection on again, or takes it out of the pool if that
+	// fails. While the backoff holds the logons back, the connection goes
+	// back to the bottom of the free list untried. The connection is not
+	// free, true if it is usable again.
+	bool Revive(TMyOracle* sql);
+	// Takes a connection that is not free out of the pool, the caller holds
+	// m_pool_mutex and destroys it once the lock is released
+	std::unique_ptr<TMyOracle> Evict(TMyOracle* sql);
+	// Backoff of the logons, the caller holds m_pool_mutex
+	void LogonDone(bool success);
+
+	// Pins of the calling thread, one per pool
+	struct ThreadPins;
+	static ThreadPins& Pins();
+	static uint64_t NextId();
+
 	std::vector<std::unique_ptr<TMyOracle>> m_sqls;
 
-	int m_max_connections = 10;
-	int m_curr_conn_index = 0;
+	// Connections not leased, the most recently released one is reused first
+	struct FreeConnection
+	{
+		TMyOracle* sql;
+		// Released at, the health checker pings the long idle ones
+		std::chrono::steady_clock::time_point since;
+	};
+	std::vector<FreeConnection> m_free;
+	// Connects in flight, counted against m_max_connections
+	size_t m_opening = 0;
+	mutable std::mutex m_pool_mutex;
+	std::condition_variable m_pool_cv;
+
 	OCI_TYPE m_type;
+	SQL_POOL_TYPE m_pool_type;
+	std::unique_ptr<TMyOracleDriverPool> m_session_pool;
+	size_t m_pool_increment = 1;
+	unsigned int m_statement_cache_size = 10;
+	std::shared_ptr<TMyOracleResultCache> m_result_cache;
+	std::chrono::milliseconds m_call_timeout{ 0 };
+
 	std::string m_user;
 	std::string m_password;
 	std::string m_db;
 
+	size_t m_min_connections;
+	size_t m_max_connections;
 
+	size_t m_warmup_threads = 4;
+	bool m_lazy_build = false;
+	std::thread m_warmup;
+	std::vector<std::chrono::microseconds> m_logon_latencies;
+
+	std::thread m_health_check;
+	std::mutex m_health_mutex;
+	std::condition_variable m_health_cv;
+	bool m_health_stop = false;
+	// Guarded by m_pool_mutex
+	SqlConnectionHealthStats m_health;
+	// No logon to revive a connection or grow the pool before m_next_logon,
+	// Build() excepted
+	static constexpr std::chrono::milliseconds FIRST_LOGON_RETRY{ 100 };
+	static constexpr std::chrono::milliseconds LAST_LOGON_RETRY{ 10000 };
+	std::chrono::steady_clock::time_point m_next_logon;
+	std::chrono::milliseconds m_logon_backoff{ 0 };
+
+	// Identifies the pool in the pins of the threads, never reused
+	const uint64_t m_id;
+	// Expires with the pool, a thread exiting only unpins if it has not
+	std::shared_ptr<SqlConnection*> m_alive;
 };
 
 //------------------------------------------------------------------------------
 #endif
-
-
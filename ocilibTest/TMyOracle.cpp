@@ -1,25 +1,33 @@
 // -----------------------------------------------------------------------------
 #include "TMyOracle.h"	
-#include "ocilib.hpp"
 #include "TMyOracleResultSet.h"
+#include "TMyOracleCursor.h"
+#include "TMyOraclePreparedStatement.h"
+#include "TMyOracleResultCache.h"
 #include "utils.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 // -----------------------------------------------------------------------------
 static std::atomic<int> g_conn_instance_counter{ 0 };
+// Statements ExecuteQuery(query, binds) keeps prepared per connection. Past
+// that, new SQL texts are prepared for a single execution.
+static constexpr size_t MAX_PREPARED_STATEMENTS = 64;
 // -----------------------------------------------------------------------------
 
 TMyOracle::TMyOracle(OCI_TYPE type)
-	: m_Connection{ nullptr }, m_type{ type }, m_lst_query{}, m_lst_error{}
+	: m_lst_query{}, m_lst_error{}, m_type{ type }, m_driver{ TMyOracleDriver::Create(type) }
 {
-	m_mutex = OCI_MutexCreate();
 }
 
 // -----------------------------------------------------------------------------
 TMyOracle::~TMyOracle()
 {
 	Disconnect();	
-	
-	OCI_MutexFree(m_mutex);	
 }
 // -----------------------------------------------------------------------------
 
@@ -28,247 +36,1089 @@ bool TMyOracle::Connect(const std::string& user, const std::string& password, co
 	// Disconnect if already connected
 	Disconnect();
 
-	try
-	{		
-		if (m_type == OCI_TYPE::OCI_CXX_API)
-		{
-			// Create a new OCI C++ environment
-			m_conn = std::make_unique<Connection>(db, user, password, Environment::SessionDefault);
-			if (!m_conn || m_conn->IsNull())
-			{
-				std::cerr << "[FATAL] TMyOracle::Connect: Failed to connect [" << m_conn_instance_counter << "] to database: " << std::endl;
-				return false;
-			}
-			
-			m_conn->SetAutoCommit(true);
-			m_conn->SetStatementCacheSize(10);
+	return Logon(user, password, db);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Connect(TMyOracleDriverPool& pool)
+{
+	Disconnect();
 
-			m_conn_instance_counter = ++g_conn_instance_counter;
-			std::cout << "[" << m_conn_instance_counter << "] Connected to database: " << db << std::endl;
-			return true;
-		}
-		else if (m_type == OCI_TYPE::OCI_C_API)
-		{
-			// Create a new OCI environment
-			m_Connection = OCI_ConnectionCreate(db.c_str(), user.c_str(), password.c_str(), OCI_SESSION_DEFAULT);
-			if (!m_Connection)
-			{
-				std::cerr << "[FATAL] TMyOracle::Connect: Failed to connect [" << m_conn_instance_counter << "] to database: " << std::string(OCI_ErrorGetString(OCI_GetLastError())) << std::endl;
-				return false;
-			}
+	return Logon(pool);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Logon(const std::string& user, const std::string& password, const std::string& db)
+{
+	CloseSession();
 
-			// Set auto-commit mode
-			OCI_SetAutoCommit(m_Connection, true);
+	if (!m_driver)
+	{
+		TMYORACLE_LOG_FATAL("TMyOracle::Connect: Driver type ", static_cast<int>(m_type), " is not available in this build");
+		return false;
+	}
 
-			// Set the statement cache size
-			OCI_SetStatementCacheSize(m_Connection, 10);
+	m_user = user;
+	m_password = password;
+	m_db = db;
+	m_driver_pool = nullptr;
 
-			std::cout << "[" << m_conn_instance_counter << "] Connected to database: " << db << std::endl;
+	if (!m_driver->Connect(user, password, db))
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_FATAL("TMyOracle::Connect: Failed to connect [", m_conn_instance_counter, "] to database: ", m_lst_error);
+		return false;
+	}
 
-			return true;
-		}
+	// Commits are issued by EndStatement() and TMyOracleTransaction
+	m_driver->SetAutoCommit(false);
+
+	// Set the statement cache size
+	m_driver->SetStatementCacheSize(10);
+
+	if (m_conn_instance_counter == 0)
+	{
+		m_conn_instance_counter = ++g_conn_instance_counter;
+	}
+	TMYORACLE_LOG_INFO("[", m_conn_instance_counter, "] Connected to database: ", db);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Logon(TMyOracleDriverPool& pool)
+{
+	CloseSession();
+
+	if (!m_driver)
+	{
+		TMYORACLE_LOG_FATAL("TMyOracle::Connect: Driver type ", static_cast<int>(m_type), " is not available in this build");
+		return false;
+	}
 
-	}	
-	catch (const std::exception& ex)
+	m_driver_pool = &pool;
+
+	if (!m_driver->Connect(pool))
 	{
-		std::cerr << "[EXCEPTION] TMyOracle::Connect: " << ex.what() << std::endl;
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_FATAL("TMyOracle::Connect: Failed to get a pooled session [", m_conn_instance_counter, "]: ", m_lst_error);
+		return false;
 	}
 
-	return false;
-	
+	// Commits are issued by EndStatement() and TMyOracleTransaction, the
+	// statement cache size is set on the pool
+	m_driver->SetAutoCommit(false);
+
+	if (m_conn_instance_counter == 0)
+	{
+		m_conn_instance_counter = ++g_conn_instance_counter;
+	}
+	m_pooled = true;
+	return true;
 }
 // -----------------------------------------------------------------------------
 void TMyOracle::Disconnect()
 {
-	if (m_type == OCI_TYPE::OCI_CXX_API)
+	CloseSession();
+	m_prepared.clear();
+}
+// -----------------------------------------------------------------------------
+void TMyOracle::CloseSession()
+{
+	// The driver statements must go before the session they belong to, the
+	// prepared statements prepare again on their next execution
+	for (auto& prepared : m_prepared)
 	{
-		if (m_conn)
-		{
-			if (!m_conn->IsNull())
-			{
-				// Disconnect from the database
-				m_conn->Close();
-				m_conn.reset();
-				std::cout << "[" << m_conn_instance_counter << "] Disconnected from database" << std::endl;
-			}
-		}
+		prepared.second->Release();
 	}
-	else if (m_type == OCI_TYPE::OCI_C_API)
+
+	// Nothing of an open transaction is kept, a pooled session must not go
+	// back with it
+	if (m_in_transaction)
 	{
-		if (m_Connection)
+		if (m_driver && m_driver->IsConnected())
 		{
-			if (OCI_IsConnected(m_Connection))
-			{
-				// Disconnect from the database
-				OCI_ConnectionFree(m_Connection);
-				m_Connection = nullptr;
-				std::cout << "[" << m_conn_instance_counter << "] Disconnected from database" << std::endl;
-			}
+			m_driver->Rollback();
 		}
+		m_in_transaction = false;
+		m_transaction_tables.clear();
+	}
+
+	// Disconnect from the database, or give the session back to its pool
+	if (m_driver && m_driver->Disconnect() && !m_pooled)
+	{
+		TMYORACLE_LOG_INFO("[", m_conn_instance_counter, "] Disconnected from database");
+	}
+
+	m_pooled = false;
+}
+// -----------------------------------------------------------------------------
+void TMyOracle::CheckThread() const
+{
+	if (m_owner != std::this_thread::get_id())
+	{
+		TMYORACLE_LOG_FATAL("TMyOracle::CheckThread: Connection [", m_conn_instance_counter, "] is bound to another thread");
+		std::abort();
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleCancellationToken* TMyOracle::BeginCall() const
+{
+	m_interrupt.store(TMyOracleInterrupt::None, std::memory_order_relaxed);
+
+	std::chrono::steady_clock::time_point deadline = m_scope_deadline;
+	if (m_call_timeout.count() > 0)
+	{
+		deadline = std::min(deadline, std::chrono::steady_clock::now() + m_call_timeout);
 	}
+	TMyOracleWatchdog::Open(this, deadline);
+
+	TMyOracleCancellationToken* token = m_scope_token;
+	if (token && !token->Attach(this))
+	{
+		// Cancelled before the call started
+		Interrupt(TMyOracleInterrupt::Cancel);
+		TMyOracleWatchdog::Arm(this, std::chrono::steady_clock::now());
+		token = nullptr;
+	}
+	return token;
+}
+// -----------------------------------------------------------------------------
+void TMyOracle::EndCall(TMyOracleCancellationToken* token) const
+{
+	// Once detached the token cannot arm the watchdog again
+	if (token)
+	{
+		token->Detach(this);
+	}
+	TMyOracleWatchdog::Close(this);
+
+	m_last_interrupt = m_interrupt.exchange(TMyOracleInterrupt::None, std::memory_order_relaxed);
+	if (m_last_interrupt == TMyOracleInterrupt::Timeout)
+	{
+		TMYORACLE_LOG_WARN("[", m_conn_instance_counter, "] Call interrupted, its deadline passed");
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Interrupt(TMyOracleInterrupt reason) const
+{
+	TMyOracleInterrupt none = TMyOracleInterrupt::None;
+	const bool recorded = m_interrupt.compare_exchange_strong(none, reason, std::memory_order_relaxed);
+	// Runs beside the call, the failure is logged rather than stored
+	std::string error;
+	if (m_driver && !m_driver->Break(error))
+	{
+		TMYORACLE_LOG_WARN("[", m_conn_instance_counter, "] Failed to interrupt the call: ", error);
+	}
+	return recorded;
+}
+// -----------------------------------------------------------------------------
+void TMyOracle::LogCallError(const char* action) const
+{
+	if (m_interrupt.load(std::memory_order_relaxed) == TMyOracleInterrupt::Cancel)
+	{
+		TMYORACLE_LOG_DEBUG("[", m_conn_instance_counter, "] Cancelled, failed to ", action, ": ", m_lst_error);
+	}
+	else
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to ", action, ": ", m_lst_error);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::RollbackCall()
+{
+	if (IsCallLimited())
+	{
+		TMyOracleWatchdog::Close(this);
+	}
+	return m_driver->Rollback();
 }
 // -----------------------------------------------------------------------------
 bool TMyOracle::IsConnected() const
 {
-	OCI_MutexAcquire(m_mutex);
+	CallLock lock(*this);
+
+	return m_driver && m_driver->IsConnected();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Ping()
+{
+	CallLock lock(*this);
 
-	bool result = false;
+	if (!m_driver)
+	{
+		return false;
+	}
+	if (!m_driver->Ping())
+	{
+		m_lst_error = m_driver->GetLastError();
+		return false;
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Reconnect()
+{
+	CallLock lock(*this);
 
-	if (m_type == OCI_TYPE::OCI_C_API)
+	return Reopen();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::Reopen()
+{
+	// Out of reach of the deadline and token of the call: a break would
+	// race the log-off freeing the session it goes to
+	if (IsCallLimited())
 	{
-		if (m_Connection)
-		{
-			result = OCI_IsConnected(m_Connection);
-		}
+		TMyOracleWatchdog::Close(this);
 	}
-	else if (m_type == OCI_TYPE::OCI_CXX_API)
+
+	bool connected = false;
+	if (m_driver_pool)
 	{
-		if (m_conn)
-		{
-			result = (!m_conn->IsNull() && m_conn->IsServerAlive());
-		}
+		connected = Logon(*m_driver_pool);
 	}
-	
-	OCI_MutexRelease(m_mutex);
-	return result;
+	else if (!m_db.empty())
+	{
+		connected = Logon(m_user, m_password, m_db);
+	}
+
+	if (connected)
+	{
+		m_reconnects.fetch_add(1, std::memory_order_relaxed);
+	}
+	return connected;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::ReconnectForRetry(const std::string& query)
+{
+	CallLock lock(*this);
+
+	// The statements of an open transaction are gone with the session, an
+	// interrupted call was not lost
+	if (!m_reconnect_retry || m_in_transaction || !m_driver || !m_driver->IsLost()
+		|| m_last_interrupt != TMyOracleInterrupt::None || !IsReadOnly(query))
+	{
+		return false;
+	}
+
+	TMYORACLE_LOG_WARN("[", m_conn_instance_counter, "] Connection lost (", m_lst_error, "), reconnecting to run the query again");
+	return Reopen();
 }
 // -----------------------------------------------------------------------------
 TMyOracleResultSet* TMyOracle::ExecuteQuery(const std::string& query)
+{
+	return ExecuteQuery(query, m_fetch_size, m_prefetch_size);
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracle::ExecuteQuery(const std::string& query, unsigned int fetch_size, unsigned int prefetch_size)
+{
+	TMyOracleResultSet* result = RunQuery(query, fetch_size, prefetch_size);
+	if (!result && ReconnectForRetry(query))
+	{
+		result = RunQuery(query, fetch_size, prefetch_size);
+	}
+	return result;
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracle::RunQuery(const std::string& query, unsigned int fetch_size, unsigned int prefetch_size)
 {	
 	if (query.empty())
 	{
-		std::cerr << "Query is empty" << std::endl;
+		TMYORACLE_LOG_ERROR("Query is empty");
+		return nullptr;
+	}
+
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+
+	if (!m_driver || !m_driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Not connected to database");
+		timer.Fail();
+		return nullptr;
+	}
+
+	// Create a new statement
+	std::unique_ptr<TMyOracleDriverStatement> stmt = m_driver->CreateStatement();
+	timer.Lap(TMyOraclePhase::CREATE);
+	if (!stmt)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to create statement: ", m_lst_error);
+		timer.Fail();
+		return nullptr;
+	}
+
+	// Rows per fetch round trip and rows prefetched by the client
+	if (fetch_size > 0)
+	{
+		stmt->SetFetchSize(fetch_size);
+	}
+	if (prefetch_size > 0)
+	{
+		stmt->SetPrefetchSize(prefetch_size);
+	}
+
+	// Prepare and execute the statement
+	const bool prepared = stmt->Prepare(query);
+	timer.Lap(TMyOraclePhase::PREPARE);
+	if (!prepared)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to prepare statement: ", m_lst_error);
+		timer.Fail();
+		return nullptr;
+	}
+	const bool read_only = IsReadOnly(query);
+	const bool executed = stmt->Execute();
+	timer.Lap(TMyOraclePhase::EXECUTE);
+	timer.AddRoundTrips(1);
+	if (!executed)
+	{
+		m_lst_error = m_driver->GetLastError();
+		LogCallError("execute statement");
+		timer.Fail();
+		EndStatement(query, read_only, false, timer);
+		return nullptr;
+	}
+
+	m_lst_query = stmt->GetSql();
+	if (!EndStatement(query, read_only, true, timer))
+	{
+		return nullptr;
+	}
+
+	// Get the result set
+	TMyOracleResultSet* result_set = TMyOracleResultSet::ExtractResultSet(*stmt, stmt->GetFetchSize(), &timer);
+	if (!result_set && stmt->FetchFailed())
+	{
+		m_lst_error = m_driver->GetLastError();
+		LogCallError("fetch");
+	}
+
+	return result_set;
+}
+// -----------------------------------------------------------------------------
+TMyOraclePreparedStatement* TMyOracle::Prepare(const std::string& query)
+{
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
+		return nullptr;
+	}
+
+	CallLock lock(*this);
+
+	auto& prepared = m_prepared[query];
+	if (!prepared)
+	{
+		prepared.reset(new TMyOraclePreparedStatement(this, query));
+	}
+	return prepared.get();
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracle::ExecuteQuery(const std::string& query, const TMyOracleBinds& binds)
+{
+	TMyOracleResultSet* result = RunQuery(query, binds);
+	if (!result && ReconnectForRetry(query))
+	{
+		result = RunQuery(query, binds);
+	}
+	return result;
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracle::RunQuery(const std::string& query, const TMyOracleBinds& binds)
+{
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
 		return nullptr;
 	}
-	
-	auto FetchRecords = [this](const std::string& query) -> TMyOracleResultSet*
+
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+
+	auto it = m_prepared.find(query);
+	if (it == m_prepared.end() && m_prepared.size() < MAX_PREPARED_STATEMENTS)
+	{
+		it = m_prepared.emplace(query, std::unique_ptr<TMyOraclePreparedStatement>(new TMyOraclePreparedStatement(this, query))).first;
+	}
+
+	if (it != m_prepared.end())
+	{
+		return it->second->Execute(binds, m_fetch_size, m_prefetch_size, timer);
+	}
+
+	TMyOraclePreparedStatement once(this, query);
+	return once.Execute(binds, m_fetch_size, m_prefetch_size, timer);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::ExecuteRows(const std::string& query, const TMyOracleBinds& binds, TMyOracleRowReader& reader)
+{
+	// The reader starts over with Begin()
+	if (RunRows(query, binds, reader))
+	{
+		return true;
+	}
+	return ReconnectForRetry(query) && RunRows(query, binds, reader);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::RunRows(const std::string& query, const TMyOracleBinds& binds, TMyOracleRowReader& reader)
+{
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
+		return false;
+	}
+
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+
+	auto it = m_prepared.find(query);
+	if (it == m_prepared.end() && m_prepared.size() < MAX_PREPARED_STATEMENTS)
+	{
+		it = m_prepared.emplace(query, std::unique_ptr<TMyOraclePreparedStatement>(new TMyOraclePreparedStatement(this, query))).first;
+	}
+
+	if (it != m_prepared.end())
+	{
+		return it->second->Execute(binds, reader, m_fetch_size, m_prefetch_size, timer);
+	}
+
+	TMyOraclePreparedStatement once(this, query);
+	return once.Execute(binds, reader, m_fetch_size, m_prefetch_size, timer);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::ExecuteStatement(const std::string& query, const TMyOracleBinds& binds, size_t* affected)
+{
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
+		return false;
+	}
+
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+
+	auto it = m_prepared.find(query);
+	if (it == m_prepared.end() && m_prepared.size() < MAX_PREPARED_STATEMENTS)
+	{
+		it = m_prepared.emplace(query, std::unique_ptr<TMyOraclePreparedStatement>(new TMyOraclePreparedStatement(this, query))).first;
+	}
+
+	size_t rows = 0;
+	bool success = false;
+	if (it != m_prepared.end())
+	{
+		success = it->second->Execute(binds, rows, timer);
+	}
+	else
+	{
+		TMyOraclePreparedStatement once(this, query);
+		success = once.Execute(binds, rows, timer);
+	}
+
+	if (affected)
+	{
+		*affected = rows;
+	}
+	return success;
+}
+// -----------------------------------------------------------------------------
+std::shared_ptr<const TMyOracleResultSet> TMyOracle::ExecuteCachedQuery(const std::string& query, const TMyOracleBinds& binds, std::chrono::milliseconds ttl)
+{
+	auto Execute = [this, &query, &binds]() -> std::shared_ptr<const TMyOracleResultSet>
+	{
+		return std::shared_ptr<const TMyOracleResultSet>(binds.empty() ? ExecuteQuery(query) : ExecuteQuery(query, binds));
+	};
+
+	// Inside a transaction the connection sees its own uncommitted writes,
+	// which must not reach the other connections, and the cache does not
+	if (!m_cache || TMyOracleResultCache::IsWrite(query) || InTransaction())
+	{
+		return Execute();
+	}
+
+	const std::string key = TMyOracleResultCache::MakeKey(query, binds);
+	if (auto cached = m_cache->Get(key))
+	{
+		return cached;
+	}
+
+	const uint64_t epoch = m_cache->Epoch();
+	std::shared_ptr<const TMyOracleResultSet> result = Execute();
+	if (result)
+	{
+		m_cache->Put(key, result, TMyOracleResultCache::Tables(query), ttl, epoch);
+	}
+	return result;
+}
+// -----------------------------------------------------------------------------
+void TMyOracle::InvalidateCache(const std::string& query)
+{
+	if (m_cache && TMyOracleResultCache::IsWrite(query))
+	{
+		m_cache->Invalidate(TMyOracleResultCache::Tables(query));
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::IsReadOnly(const std::string& query)
+{
+	size_t start = 0;
+	while (start < query.size() && (std::isspace(static_cast<unsigned char>(query[start])) || query[start] == '('))
+	{
+		++start;
+	}
+	size_t end = start;
+	while (end < query.size() && std::isalpha(static_cast<unsigned char>(query[end])))
+	{
+		++end;
+	}
+
+	const std::string verb = std::to_upper(query.substr(start, end - start));
+	if (verb != "SELECT" && verb != "WITH")
+	{
+		return false;
+	}
+
+	// SELECT ... FOR UPDATE locks rows until the transaction ends
+	static const char FOR_UPDATE[] = "FOR UPDATE";
+	auto found = std::search(query.begin() + end, query.end(), FOR_UPDATE, FOR_UPDATE + sizeof(FOR_UPDATE) - 1,
+		[](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; });
+	return found == query.end();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::InTransaction() const
+{
+	CallLock lock(*this);
+
+	return m_in_transaction;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::EndStatement(const std::string& query, bool read_only, bool success, TMyOracleQueryTimer& timer)
+{
+	if (read_only)
+	{
+		return true;
+	}
+
+	// The transaction commits or rolls back the statement with the others. A
+	// statement that failed was already undone by the server.
+	if (m_in_transaction)
 	{
-		try
+		m_transaction_writes += success ? 1 : 0;
+		if (success && m_cache && TMyOracleResultCache::IsWrite(query))
 		{
-			if (m_type == OCI_TYPE::OCI_C_API)
+			for (std::string& table : TMyOracleResultCache::Tables(query))
 			{
-				if (!m_Connection)
+				if (std::find(m_transaction_tables.begin(), m_transaction_tables.end(), table) == m_transaction_tables.end())
 				{
-					std::cerr << "[" << m_conn_instance_counter << "] Not connected to database" << std::endl;
-
-					return nullptr;
+					m_transaction_tables.push_back(std::move(table));
 				}
-				// Create a new statement
-				TMyOracleStatement stmt(m_Connection);
-				if (!stmt)
-				{
-					std::cerr << "[" << m_conn_instance_counter << "] Failed to create statement" << std::endl;
+			}
+		}
+		return true;
+	}
 
-					return nullptr;
-				}
-				// Prepare and execute the statement
-				if (!OCI_Prepare(stmt, query.c_str()))
-				{
-					m_lst_error = OCI_ErrorGetString(OCI_GetLastError());
-					std::cerr << "[" << m_conn_instance_counter << "] Failed to prepare statement: " << m_lst_error << std::endl;
+	if (!success)
+	{
+		RollbackCall();
+		timer.Lap(TMyOraclePhase::COMMIT);
+		timer.AddRoundTrips(1);
+		return true;
+	}
 
-					return nullptr;
-				}
-				// Execute the statement
-				if (!OCI_Execute(stmt))
-				{
-					m_lst_error = OCI_ErrorGetString(OCI_GetLastError());
-					std::cerr << "[" << m_conn_instance_counter << "] Failed to execute statement: " << m_lst_error << std::endl;					
-					return nullptr;
-				}
+	const bool committed = m_driver->Commit(TMyOracleCommitMode::Wait);
+	timer.Lap(TMyOraclePhase::COMMIT);
+	timer.AddRoundTrips(1);
+	if (!committed)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to commit: ", m_lst_error);
+		// An interrupted commit leaves the write pending, the next commit
+		// would take it along
+		RollbackCall();
+		timer.AddRoundTrips(1);
+		timer.Fail();
+		return false;
+	}
+
+	// Once committed, so that no reader caches the rows before the change
+	InvalidateCache(query);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::BeginTransaction()
+{
+	CallLock lock(*this);
+
+	if (!m_driver || !m_driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Not connected to database");
+		return false;
+	}
+	if (m_in_transaction)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracle::BeginTransaction: A transaction is already open on connection [", m_conn_instance_counter, "]");
+		return false;
+	}
 
-				m_lst_query = OCI_GetSql(stmt);
+	// The server starts the transaction with its first write
+	m_in_transaction = true;
+	m_transaction_writes = 0;
+	m_transaction_tables.clear();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::EndTransaction(bool commit, TMyOracleCommitMode mode)
+{
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
 
-				// Commit the transaction
-				OCI_Commit(m_Connection);
+	if (!m_in_transaction)
+	{
+		return false;
+	}
+	m_in_transaction = false;
 
-				// Get the result set
-				TMyOracleResultSet* result_set = TMyOracleResultSet::ExtractResultSet(OCI_GetResultset(stmt));
+	if (!m_driver || !m_driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Not connected to database");
+		m_transaction_tables.clear();
+		timer.Fail();
+		return false;
+	}
 
-				// Check if the result set is valid and return it
-				if (result_set)
-				{
+	// Only reads, or writes the server already undid: nothing to end
+	if (m_transaction_writes == 0)
+	{
+		return true;
+	}
 
-					return result_set;
-				}
-			}
-			else if (m_type == OCI_TYPE::OCI_CXX_API)
-			{
-				if (!m_conn || m_conn->IsNull() || !m_conn->IsServerAlive())
-				{
-					std::cerr << "[" << m_conn_instance_counter << "] Not connected to database" << std::endl;
+	const bool ended = commit ? m_driver->Commit(mode) : RollbackCall();
+	timer.Lap(TMyOraclePhase::COMMIT);
+	timer.AddRoundTrips(1);
+	if (!ended)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to ", (commit ? "commit" : "roll back"), ": ", m_lst_error);
+		if (commit)
+		{
+			RollbackCall();
+			timer.AddRoundTrips(1);
+		}
+		timer.Fail();
+	}
 
-					return nullptr;
-				}
+	if (ended && commit && m_cache && !m_transaction_tables.empty())
+	{
+		m_cache->Invalidate(m_transaction_tables);
+	}
+	m_transaction_tables.clear();
+	return ended;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::ExecuteBatch(const std::string& query, const std::string& key_column, const std::vector<int64_t>& keys, TMyOracleBatchResult& results, size_t chunk_size)
+{
+	static const std::string KEYS_PLACEHOLDER = ":KEYS";
 
-				// Create a new statement
-				Statement stmt(*m_conn);
-				if (stmt.IsNull())
-				{
-					std::cerr << "[" << m_conn_instance_counter << "] Failed to create statement" << std::endl;
+	const size_t placeholder = query.find(KEYS_PLACEHOLDER);
+	if (placeholder == std::string::npos)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracle::ExecuteBatch: Query has no ", KEYS_PLACEHOLDER, " placeholder");
+		return false;
+	}
 
-					return nullptr;
-				}
+	if (chunk_size == 0)
+	{
+		chunk_size = m_batch_chunk_size;
+	}
 
-				stmt.Prepare(query);
+	std::vector<int64_t> unique_keys(keys);
+	std::sort(unique_keys.begin(), unique_keys.end());
+	unique_keys.erase(std::unique(unique_keys.begin(), unique_keys.end()), unique_keys.end());
 
-				// Execute the statement
-				stmt.ExecutePrepared();
+	// Full chunks bind chunk_size keys. A smaller chunk is rounded up to a
+	// power of two and padded with its last key, so only a handful of SQL
+	// texts (and prepared statements) exist per query.
+	auto BindCount = [chunk_size](size_t count) -> size_t
+	{
+		size_t binds = 1;
+		while (binds < count)
+		{
+			binds <<= 1;
+		}
+		return std::min(binds, chunk_size);
+	};
 
-				m_lst_query = stmt.GetSql();
+	auto BuildSql = [&query, placeholder](size_t binds) -> std::string
+	{
+		std::string in_list;
+		for (size_t i = 1; i <= binds; ++i)
+		{
+			in_list += (i > 1 ? ", :k" : ":k") + std::to_string(i);
+		}
+		return query.substr(0, placeholder) + in_list + query.substr(placeholder + KEYS_PLACEHOLDER.size());
+	};
 
-				// Commit the transaction
-				m_conn->Commit();
+	bool success = true;
 
-				ocilib::Resultset rs = stmt.GetResultset();
-				if (rs.IsNull())
-				{
-					std::cerr << "[" << m_conn_instance_counter << "] Failed to get result set" << std::endl;
+	for (size_t first = 0; first < unique_keys.size(); first += chunk_size)
+	{
+		const size_t count = std::min(chunk_size, unique_keys.size() - first);
+		const size_t bind_count = BindCount(count);
 
-					return nullptr;
-				}
+		TMyOracleBinds binds;
+		binds.reserve(bind_count);
+		for (size_t i = 0; i < bind_count; ++i)
+		{
+			binds.emplace_back(unique_keys[first + std::min(i, count - 1)]);
+		}
 
-				// Get the result set
-				TMyOracleResultSet* result_set = TMyOracleResultSet::ExtractResultSet(&rs);
+		std::unique_ptr<TMyOracleResultSet> rs(ExecuteQuery(BuildSql(bind_count), binds));
+		if (!rs)
+		{
+			success = false;
+			continue;
+		}
 
-				// Check if the result set is valid and return it
-				if (result_set)
-				{
-					return result_set;
-				}
+		const size_t key_index = rs->FindColumn(key_column);
+		if (key_index >= rs->Columns())
+		{
+			TMYORACLE_LOG_ERROR("TMyOracle::ExecuteBatch: Column ", key_column, " is not selected");
+			return false;
+		}
+
+		for (size_t row = 0; row < rs->Rows(); ++row)
+		{
+			auto& group = results[rs->m_columns[key_index].GetInt64(row)];
+			if (!group)
+			{
+				group.reset(TMyOracleResultSet::Create());
+				group->DescribeLike(*rs);
+			}
+			group->AppendRow(*rs, row);
+		}
+	}
+
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::ExecuteArray(const std::string& query, const std::vector<TMyOracleBinds>& rows, TMyOracleArrayResult& result, size_t array_size)
+{
+	result = TMyOracleArrayResult();
+
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
+		return false;
+	}
+	if (rows.empty())
+	{
+		return true;
+	}
+
+	if (array_size == 0)
+	{
+		array_size = m_array_size;
+	}
+	array_size = std::min(array_size, rows.size());
+
+	// One array per placeholder. The bind type is the widest value index of
+	// the column: NULL < int64 < double < string.
+	struct Column
+	{
+		std::string name;
+		size_t type = 0;
+		// Longest string, arrays hold length + 1 chars per row
+		size_t length = 0;
+
+		std::vector<int64_t> numbers;
+		std::vector<double> reals;
+		std::vector<char> text;
+	};
+
+	const size_t column_count = rows.front().size();
+	std::vector<Column> columns(column_count);
+	bool by_position = false;
+	for (size_t i = 0; i < column_count; ++i)
+	{
+		by_position |= rows.front()[i].name.empty();
+		columns[i].name = rows.front()[i].name.empty() ? ":" + std::to_string(i + 1) : rows.front()[i].name;
+	}
+
+	for (size_t row = 0; row < rows.size(); ++row)
+	{
+		if (rows[row].size() != column_count)
+		{
+			TMYORACLE_LOG_ERROR("TMyOracle::ExecuteArray: Row ", row, " has ", rows[row].size(), " binds, expected ", column_count);
+			return false;
+		}
+		for (size_t i = 0; i < column_count; ++i)
+		{
+			const TMyOracleValue& value = rows[row][i].value;
+			columns[i].type = std::max(columns[i].type, value.index());
+			if (value.index() == 3)
+			{
+				columns[i].length = std::max(columns[i].length, std::get<std::string>(value).size());
 			}
 		}
-		catch (const std::exception& ex)
+	}
+
+	for (Column& column : columns)
+	{
+		switch (column.type)
 		{
-			m_lst_error = OCI_ErrorGetString(OCI_GetLastError());
+		case 1:
+			column.numbers.resize(array_size);
+			break;
+		case 2:
+			column.reals.resize(array_size);
+			break;
+		default:
+			// All NULL columns bind as strings too. Numbers in a string
+			// column are written out, up to 24 chars.
+			column.type = 3;
+			column.length = std::max<size_t>(column.length, 24);
+			column.text.resize(array_size * (column.length + 1));
+			break;
+		}
+	}
+
+	TMyOracleQueryTimer timer(&m_metrics);
+	CallLock lock(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
 
-			std::cerr << "[EXCEPTION] TMyOracle::ExecuteQuery[" << m_conn_instance_counter << "]: " << ex.what() << std::endl;
+	if (!m_driver || !m_driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Not connected to database");
+		timer.Fail();
+		return false;
+	}
+
+	std::unique_ptr<TMyOracleDriverStatement> stmt = m_driver->CreateStatement();
+	timer.Lap(TMyOraclePhase::CREATE);
+	if (!stmt)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to create statement: ", m_lst_error);
+		timer.Fail();
+		return false;
+	}
+
+	if (by_position)
+	{
+		stmt->SetBindByPosition();
+	}
+
+	bool bound = stmt->Prepare(query) && stmt->SetBindArraySize(static_cast<unsigned int>(array_size));
+	for (size_t i = 0; bound && i < column_count; ++i)
+	{
+		Column& column = columns[i];
+		switch (column.type)
+		{
+		case 1:
+			bound = stmt->BindInt64Array(column.name, column.numbers.data());
+			break;
+		case 2:
+			bound = stmt->BindDoubleArray(column.name, column.reals.data());
+			break;
+		default:
+			bound = stmt->BindStringArray(column.name, column.text.data(), static_cast<unsigned int>(column.length));
+			break;
 		}
-		catch (...)
+	}
+	timer.Lap(TMyOraclePhase::PREPARE);
+	if (!bound)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to prepare statement: ", m_lst_error);
+		timer.Fail();
+		return false;
+	}
+
+	bool success = true;
+	char number[32];
+
+	for (size_t first = 0; first < rows.size(); first += array_size)
+	{
+		const size_t count = std::min(array_size, rows.size() - first);
+
+		// Copy the chunk into the bound arrays
+		for (size_t i = 0; i < column_count; ++i)
 		{
-			m_lst_error = OCI_ErrorGetString(OCI_GetLastError());
-			std::cerr << "[EXCEPTION] TMyOracle::ExecuteQuery[" << m_conn_instance_counter << "]: Unknown error: " << m_lst_error << std::endl;
+			Column& column = columns[i];
+			for (size_t row = 0; row < count; ++row)
+			{
+				const TMyOracleValue& value = rows[first + row][i].value;
+				stmt->SetBindNullAt(column.name, static_cast<unsigned int>(row), value.index() == 0);
+				if (value.index() == 0)
+				{
+					continue;
+				}
+
+				if (column.type == 1)
+				{
+					column.numbers[row] = std::get<int64_t>(value);
+				}
+				else if (column.type == 2)
+				{
+					column.reals[row] = value.index() == 1 ? static_cast<double>(std::get<int64_t>(value)) : std::get<double>(value);
+				}
+				else
+				{
+					const char* str = number;
+					if (value.index() == 1)
+					{
+						std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(std::get<int64_t>(value)));
+					}
+					else if (value.index() == 2)
+					{
+						std::snprintf(number, sizeof(number), "%.17g", std::get<double>(value));
+					}
+					else
+					{
+						str = std::get<std::string>(value).c_str();
+					}
+
+					char* dest = column.text.data() + row * (column.length + 1);
+					std::strncpy(dest, str, column.length);
+					dest[column.length] = '\0';
+				}
+			}
 		}
+		timer.Lap(TMyOraclePhase::CONVERT);
 
-		if (m_type == OCI_TYPE::OCI_C_API)
+		const bool executed = stmt->ExecuteArray(static_cast<unsigned int>(count));
+		timer.Lap(TMyOraclePhase::EXECUTE);
+		timer.AddRoundTrips(1);
+		++result.round_trips;
+		if (!executed)
 		{
-			// Rollback in case of error
-			OCI_Rollback(m_Connection);
+			m_lst_error = m_driver->GetLastError();
+			TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to execute array of ", count, " row(s): ", m_lst_error);
+			timer.Fail();
+			success = false;
+			break;
 		}
-		else if (m_type == OCI_TYPE::OCI_CXX_API)
+
+		result.affected += stmt->GetAffectedRows();
+		for (const TMyOracleBatchError& error : stmt->GetBatchErrors())
 		{
-			m_conn->Rollback();
+			result.errors.push_back({ first + error.row, error.code, error.message });
 		}
-		
+	}
+
+	m_lst_query = query;
+
+	// The arrays that went through are committed even when a later one failed
+	if (!m_in_transaction)
+	{
+		++result.round_trips;
+	}
+	if (!EndStatement(query, false, true, timer))
+	{
+		success = false;
+	}
+
+	return success;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleCursor> TMyOracle::OpenCursor(const std::string& query, unsigned int fetch_size, unsigned int prefetch_size)
+{
+	if (query.empty())
+	{
+		TMYORACLE_LOG_ERROR("Query is empty");
 		return nullptr;
-	};
-	
-	
-	TMyOracleResultSet* result_set = nullptr;
+	}
 
-	OCI_MutexAcquire(m_mutex);
-	result_set = FetchRecords(query);
-	OCI_MutexRelease(m_mutex);
+	if (fetch_size == 0)
+	{
+		fetch_size = m_fetch_size;
+	}
+	if (prefetch_size == 0)
+	{
+		prefetch_size = m_prefetch_size;
+	}
 
-	return result_set;
-}
\ No newline at end of file
+	// The cursor releases the connection when it is destroyed. Its timer
+	// starts before the lock is taken and runs until then.
+	std::unique_ptr<TMyOracleCursor> cursor(new TMyOracleCursor(this));
+	TMyOracleQueryTimer& timer = cursor->m_timer;
+	cursor->m_lock.emplace(*this);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+
+	if (!m_driver || !m_driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Not connected to database");
+		timer.Fail();
+		return nullptr;
+	}
+
+	cursor->m_stmt = m_driver->CreateStatement();
+	TMyOracleDriverStatement* stmt = cursor->m_stmt.get();
+	timer.Lap(TMyOraclePhase::CREATE);
+	if (!stmt)
+	{
+		m_lst_error = m_driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to create statement: ", m_lst_error);
+		timer.Fail();
+		return nullptr;
+	}
+
+	if (fetch_size > 0)
+	{
+		stmt->SetFetchSize(fetch_size);
+	}
+	if (prefetch_size > 0)
+	{
+		stmt->SetPrefetchSize(prefetch_size);
+	}
+
+	const bool prepared = stmt->Prepare(query);
+	timer.Lap(TMyOraclePhase::PREPARE);
+	if (!prepared || !stmt->Execute())
+	{
+		m_lst_error = m_driver->GetLastError();
+		LogCallError("execute statement");
+		timer.Fail();
+		return nullptr;
+	}
+	timer.Lap(TMyOraclePhase::EXECUTE);
+	timer.AddRoundTrips(1);
+
+	m_lst_query = stmt->GetSql();
+
+	if (stmt->GetColumnCount() == 0)
+	{
+		TMYORACLE_LOG_ERROR("[", m_conn_instance_counter, "] Failed to get result set");
+		timer.Fail();
+		return nullptr;
+	}
+	cursor->m_fetch_size = stmt->GetFetchSize();
+	cursor->m_row.Describe(*stmt);
+
+	return cursor;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracle::StreamQuery(const std::string& query, const std::function<bool(const TMyOracleCursor&)>& onRow, unsigned int fetch_size, unsigned int prefetch_size)
+{
+	std::unique_ptr<TMyOracleCursor> cursor = OpenCursor(query, fetch_size, prefetch_size);
+	if (!cursor)
+	{
+		return false;
+	}
+
+	while (cursor->Next())
+	{
+		if (!onRow(*cursor))
+		{
+			break;
+		}
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
@@ -2,92 +2,381 @@
 #ifndef __TMYORACLE_H__
 #define __TMYORACLE_H__
 // -----------------------------------------------------------------------------
-#include "ocilib.hpp"
+#include "TMyOracleCancellation.h"
+#include "TMyOracleDriver.h"
+#include "TMyOracleMetrics.h"
+#include "TMyOracleRowMapping.h"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
-// -----------------------------------------------------------------------------
-using namespace ocilib;
-// -----------------------------------------------------------------------------
-enum class OCI_TYPE
-{
-	OCI_C_API = 1,
-	OCI_CXX_API = 2
-};
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 // -----------------------------------------------------------------------------
 class TMyOracle;
-class TMyOracleStatement;
 class TMyOracleResultSet;
+class TMyOracleCursor;
+class TMyOraclePreparedStatement;
+class TMyOracleResultCache;
+class TMyOracleTransaction;
 // -----------------------------------------------------------------------------
 
-class TMyOracleStatement
+// A bind value. Without a name the value binds by position (:1, :2, ...),
+// with a name it binds to that placeholder (":id"). A statement cannot mix
+// positional and named binds.
+using TMyOracleValue = std::variant<std::nullptr_t, int64_t, double, std::string>;
+
+struct TMyOracleBind
 {
-	OCI_Statement* stmt = nullptr;
-public:
-	explicit TMyOracleStatement(OCI_Connection* conn) 
-	{
-		if (conn && OCI_IsConnected(conn))
-		{
-			stmt = OCI_StatementCreate(conn);
-			if (!stmt)
-			{
-				stmt = nullptr;
-			}
-		}
-	}
-	~TMyOracleStatement() { if (stmt) OCI_StatementFree(stmt); }
+	TMyOracleBind(std::nullptr_t) : value(nullptr) {}
+	TMyOracleBind(int v) : value(static_cast<int64_t>(v)) {}
+	TMyOracleBind(int64_t v) : value(v) {}
+	TMyOracleBind(double v) : value(v) {}
+	TMyOracleBind(const char* v) : value(std::string(v)) {}
+	TMyOracleBind(const std::string& v) : value(v) {}
 
-	// Prevent copying
-	TMyOracleStatement(const TMyOracleStatement&) = delete;
-	TMyOracleStatement& operator=(const TMyOracleStatement&) = delete;
+	template<typename T>
+	TMyOracleBind(const std::string& bind_name, T v) : TMyOracleBind(v) { name = bind_name; }
 
-	// Allow moving
-	TMyOracleStatement(TMyOracleStatement&& other) noexcept : stmt(other.stmt) { other.stmt = nullptr; }
+	std::string name;
+	TMyOracleValue value;
+};
+using TMyOracleBinds = std::vector<TMyOracleBind>;
 
-	operator OCI_Statement* () const { return stmt; }
-	
+// Result of TMyOracle::ExecuteBatch: the rows of each key found
+using TMyOracleBatchResult = std::unordered_map<int64_t, std::unique_ptr<TMyOracleResultSet>>;
+
+// Result of TMyOracle::ExecuteArray
+struct TMyOracleArrayResult
+{
+	// Rows inserted / updated / merged
+	size_t affected = 0;
+	size_t round_trips = 0;
+	// Rows that failed, row being the index in the rows passed
+	std::vector<TMyOracleBatchError> errors;
 };
 
 class TMyOracle
 {
+	friend class TMyOracleCursor;
+	friend class TMyOraclePreparedStatement;
+	friend class TMyOracleTransaction;
+	friend class TMyOracleCallScope;
+	friend class TMyOracleCancellationToken;
+	friend class TMyOracleWatchdog;
+
 public:
 	
 	explicit TMyOracle(OCI_TYPE type = OCI_TYPE::OCI_C_API);
 	virtual ~TMyOracle();
 	bool Connect(const std::string& user, const std::string& password, const std::string& db);
+	// Takes a session from a pool of the same driver type; Disconnect() gives
+	// it back
+	bool Connect(TMyOracleDriverPool& pool);
+	bool IsPooled() const { return m_pooled; }
 	void Disconnect();
+	// Liveness cached from the errors of the calls, no round trip: false
+	// once a call failed because the session was lost (see
+	// TMyOracleDriver::IsLost()). Ping() makes a round trip and updates it.
 	bool IsConnected() const;
+	bool Ping();
+	// Logs on again with the credentials, or the session pool, of the last
+	// Connect(). An open transaction is dropped; the statements returned by
+	// Prepare() stay valid and prepare again on their next execution.
+	bool Reconnect();
+	uint64_t GetReconnects() const { return m_reconnects.load(std::memory_order_relaxed); }
 
-	template<typename T>
-	T* GetConnection()
-	{
-		if (m_type == OCI_TYPE::OCI_CXX_API)
-		{
-			return m_conn.get();
-		}
-		else
-		{
-			return reinterpret_cast<T*>(m_Connection);
-		}
-	}
+	// A read-only query (see IsReadOnly()) that fails because the session
+	// was lost reconnects and runs once more, unless a transaction is open.
+	// ExecuteQuery(), ExecuteAs(), ExecuteRows() and what runs through them:
+	// ExecuteCachedQuery() and every chunk of ExecuteBatch(), each on its
+	// own. Not writes nor cursors. On by default.
+	void SetReconnectRetry(bool enabled) { m_reconnect_retry = enabled; }
+	bool GetReconnectRetry() const { return m_reconnect_retry; }
+
+	// Thread-affine mode: the connection belongs to the calling thread and
+	// its calls no longer lock it. No other thread may use it until
+	// UnbindThread() is called, by the owner; debug builds abort on a call
+	// from another thread. See SqlConnection::Pin().
+	void BindThread() { m_owner = std::this_thread::get_id(); }
+	void UnbindThread() { m_owner = std::thread::id(); }
+	bool IsThreadBound() const { return m_owner != std::thread::id(); }
+
+	// Deadline of every call on the connection, from its start: past it the
+	// call in progress is interrupted (driver Break) and fails with
+	// ORA-01013. 0 for none, the default. See TMyOracleCallScope for a
+	// deadline over several calls and for cancellation.
+	void SetCallTimeout(std::chrono::milliseconds timeout) { m_call_timeout = timeout; }
+	std::chrono::milliseconds GetCallTimeout() const { return m_call_timeout; }
+	// Why the last call was interrupted, None if it was not. A call
+	// interrupted after its last round trip succeeds all the same.
+	TMyOracleInterrupt GetLastInterrupt() const { return m_last_interrupt; }
+
+	OCI_TYPE GetType() const { return m_type; }
+	// nullptr when the driver type is not compiled in
+	TMyOracleDriver* GetDriver() const { return m_driver.get(); }
 
 	int GetConnInstanceCounter() const { return m_conn_instance_counter; }
 
 	std::string GetLastError() const { return m_lst_error; }
 	std::string GetLastQuery() const { return m_lst_query; }
 
+	// Phase timings and counters of the queries run on this connection, see
+	// TMyOracleMetrics::SetEnabled()
+	const TMyOracleMetrics& GetMetrics() const { return m_metrics; }
+	TMyOracleMetrics& GetMetrics() { return m_metrics; }
+
+	// Fetch array / prefetch sizes used by ExecuteQuery when the caller does not
+	// pass its own. 0 keeps the driver default (20 rows).
+	void SetFetchSize(unsigned int size) { m_fetch_size = size; }
+	void SetPrefetchSize(unsigned int size) { m_prefetch_size = size; }
+	unsigned int GetFetchSize() const { return m_fetch_size; }
+	unsigned int GetPrefetchSize() const { return m_prefetch_size; }
+
 	TMyOracleResultSet* ExecuteQuery(const std::string& query);
+	TMyOracleResultSet* ExecuteQuery(const std::string& query, unsigned int fetch_size, unsigned int prefetch_size);
+
+	// Parameterized query. The statement is prepared once per connection and
+	// re-executed with the new bind values on later calls with the same SQL.
+	TMyOracleResultSet* ExecuteQuery(const std::string& query, const TMyOracleBinds& binds);
+
+	// DML or PL/SQL through the same prepared statements as ExecuteQuery().
+	// affected receives the rows inserted / updated / deleted. Returns false
+	// if the statement or its commit failed.
+	bool ExecuteStatement(const std::string& query, const TMyOracleBinds& binds = {}, size_t* affected = nullptr);
+
+	// Commits. Sessions do not auto-commit: a statement that can write is
+	// committed by the call that runs it, or rolled back if it fails, unless
+	// a TMyOracleTransaction is open on the connection, which then commits
+	// or rolls back all of them at once. SELECT and WITH queries without
+	// FOR UPDATE are read-only and never commit nor roll back.
+	static bool IsReadOnly(const std::string& query);
+	bool InTransaction() const;
+
+	// Typed query: decodes the rows of the prepared statement straight into
+	// rows, one T per row, with the column mapping of T::Fields() (see
+	// TMyOracleField). The column positions are resolved on the first
+	// execution of the statement, the rows are read with the typed getters
+	// of the driver with no result set in between. rows is overwritten,
+	// reusing it keeps its buffers. False if the query failed or does not
+	// select a column of the mapping.
+	template<typename T>
+	bool ExecuteAs(const std::string& query, const TMyOracleBinds& binds, std::vector<T>& rows)
+	{
+		TMyOracleRowMapper<T> mapper(rows);
+		return ExecuteRows(query, binds, mapper);
+	}
+
+	// Same as ExecuteAs() with any row reader
+	bool ExecuteRows(const std::string& query, const TMyOracleBinds& binds, TMyOracleRowReader& reader);
+
+	// Result cache shared by the connections of a pool, nullptr for none
+	void SetResultCache(std::shared_ptr<TMyOracleResultCache> cache) { m_cache = std::move(cache); }
+	const std::shared_ptr<TMyOracleResultCache>& GetResultCache() const { return m_cache; }
+
+	// Read-through query: returns the cached result of the same query and
+	// binds while it is fresh, otherwise executes it and caches the result
+	// for ttl (0 uses the cache default). The result is shared with other
+	// readers and must not be changed: read it by row, see
+	// TMyOracleResultSet::Get(row, column). Without a cache, or inside a
+	// transaction, executes every time and caches nothing.
+	std::shared_ptr<const TMyOracleResultSet> ExecuteCachedQuery(const std::string& query, const TMyOracleBinds& binds = {}, std::chrono::milliseconds ttl = std::chrono::milliseconds(0));
+
+	// Returns the prepared statement for query, creating it on first use. It
+	// is owned by this connection and stays valid until Disconnect().
+	TMyOraclePreparedStatement* Prepare(const std::string& query);
+
+	// Batch key lookup. query holds the :KEYS placeholder where the IN list
+	// goes ("... WHERE e.id IN (:KEYS)") and selects key_column. Keys are
+	// bound chunk_size at a time (0 uses the connection default) and the rows
+	// are grouped by key_column into results. Keys without rows get no entry.
+	// A chunk that fails on a lost session is retried on its own, see
+	// SetReconnectRetry(). Returns false if any chunk fails.
+	bool ExecuteBatch(const std::string& query, const std::string& key_column, const std::vector<int64_t>& keys, TMyOracleBatchResult& results, size_t chunk_size = 0);
+
+	void SetBatchChunkSize(size_t size) { m_batch_chunk_size = size > 0 ? size : 1; }
+	size_t GetBatchChunkSize() const { return m_batch_chunk_size; }
+
+	// Array DML: executes an INSERT / UPDATE / MERGE once per entry of rows,
+	// array_size rows per round trip (0 uses the connection default). Every
+	// row binds the same placeholders, named or by position, in the same
+	// order. A column is bound as a string if any row holds a string, else
+	// as a double if any holds a double, else as an int64.
+	//
+	// Rows rejected by the server (constraint violations, conversions, ...)
+	// do not stop the others and are listed in result.errors. Commits once
+	// at the end, or with the open transaction. Returns false if a whole
+	// round trip fails, the rows sent before it stay written.
+	bool ExecuteArray(const std::string& query, const std::vector<TMyOracleBinds>& rows, TMyOracleArrayResult& result, size_t array_size = 0);
+
+	void SetArraySize(size_t size) { m_array_size = size > 0 ? size : 1; }
+	size_t GetArraySize() const { return m_array_size; }
+
+	// Streaming mode: rows are handed out while the statement is still
+	// fetching and memory stays bounded by the fetch array size. The cursor
+	// keeps this connection locked until it is destroyed. Returns nullptr on
+	// failure. 0 sizes use the connection defaults.
+	std::unique_ptr<TMyOracleCursor> OpenCursor(const std::string& query, unsigned int fetch_size = 0, unsigned int prefetch_size = 0);
+
+	// Calls onRow for every row of the query until it returns false.
+	// Returns false if the query could not be executed.
+	bool StreamQuery(const std::string& query, const std::function<bool(const TMyOracleCursor&)>& onRow, unsigned int fetch_size = 0, unsigned int prefetch_size = 0);
 
 private:
 	std::string m_lst_query;
 	std::string m_lst_error;
 	OCI_TYPE m_type;
-	ocilib::MutexHandle m_mutex;
+	// Held for the length of every call, and by an open cursor, unless the
+	// connection is bound to a thread
+	mutable std::mutex m_mutex;
+	std::thread::id m_owner;
+
+	// Taken for the length of a call: m_mutex, or in thread-affine mode
+	// only the check of the calling thread. Arms the deadline and token of
+	// the call, if any.
+	class CallLock
+	{
+	public:
+		explicit CallLock(const TMyOracle& sql) : m_sql(sql), m_mutex(sql.IsThreadBound() ? nullptr : &sql.m_mutex)
+		{
+			if (m_mutex)
+			{
+				m_mutex->lock();
+			}
+#ifndef NDEBUG
+			else
+			{
+				sql.CheckThread();
+			}
+#endif
+			m_limited = sql.IsCallLimited();
+			if (m_limited)
+			{
+				m_token = sql.BeginCall();
+			}
+			else
+			{
+				sql.m_last_interrupt = TMyOracleInterrupt::None;
+			}
+		}
+		~CallLock()
+		{
+			if (m_limited)
+			{
+				m_sql.EndCall(m_token);
+			}
+			if (m_mutex)
+			{
+				m_mutex->unlock();
+			}
+		}
+
+		CallLock(const CallLock&) = delete;
+		CallLock& operator=(const CallLock&) = delete;
+
+	private:
+		const TMyOracle& m_sql;
+		std::mutex* m_mutex;
+		bool m_limited = false;
+		TMyOracleCancellationToken* m_token = nullptr;
+	};
+	// Aborts when the calling thread is not the owner
+	void CheckThread() const;
+
+	// Deadline and token of the calls, see SetCallTimeout() and
+	// TMyOracleCallScope
+	std::chrono::milliseconds m_call_timeout{ 0 };
+	std::chrono::steady_clock::time_point m_scope_deadline{ std::chrono::steady_clock::time_point::max() };
+	TMyOracleCancellationToken* m_scope_token{ nullptr };
+	bool IsCallLimited() const
+	{
+		return m_call_timeout.count() > 0 || m_scope_token || m_scope_deadline != std::chrono::steady_clock::time_point::max();
+	}
+	// Arms the watchdog for the call starting, returns the token it is
+	// attached to
+	TMyOracleCancellationToken* BeginCall() const;
+	void EndCall(TMyOracleCancellationToken* token) const;
+	// Records why the call is interrupted, unless it already was, and
+	// breaks it. True if reason was recorded.
+	bool Interrupt(TMyOracleInterrupt reason) const;
+	// Logs the failure of a round trip of the call, as an error unless the
+	// call was cancelled on purpose
+	void LogCallError(const char* action) const;
+	// Rolls back out of reach of the deadline and token of the call, which
+	// may have interrupted the statement being undone
+	bool RollbackCall();
+
+	// Set while the call in progress is interrupted
+	mutable std::atomic<TMyOracleInterrupt> m_interrupt{ TMyOracleInterrupt::None };
+	mutable TMyOracleInterrupt m_last_interrupt{ TMyOracleInterrupt::None };
+	// Entry of the call in TMyOracleWatchdog, guarded by its mutex
+	mutable std::chrono::steady_clock::time_point m_watch_time;
+	mutable std::chrono::milliseconds m_watch_retry{ 0 };
+	mutable bool m_watched{ false };
+	mutable bool m_watch_open{ false };
+
+	std::unique_ptr<TMyOracleDriver> m_driver;
 
-	OCI_Connection* m_Connection;
-	
 	int m_conn_instance_counter{ 0 };
+	bool m_pooled{ false };
+
+	// What Reconnect() logs on with
+	std::string m_user;
+	std::string m_password;
+	std::string m_db;
+	TMyOracleDriverPool* m_driver_pool{ nullptr };
+	bool m_reconnect_retry{ true };
+	std::atomic<uint64_t> m_reconnects{ 0 };
+	// Reconnect(), the caller holds m_mutex. Closes the watchdog of the call,
+	// the session is not interrupted while it is replaced
+	bool Reopen();
+	// Connect() and Reopen(): closes the session, keeping m_prepared, and
+	// opens a new one
+	bool Logon(const std::string& user, const std::string& password, const std::string& db);
+	bool Logon(TMyOracleDriverPool& pool);
+	// Disconnect() without dropping m_prepared
+	void CloseSession();
+	// After a failed call of query: reconnects when the call may run again,
+	// see SetReconnectRetry()
+	bool ReconnectForRetry(const std::string& query);
+
+	// The calls ExecuteQuery() and ExecuteRows() retry
+	TMyOracleResultSet* RunQuery(const std::string& query, unsigned int fetch_size, unsigned int prefetch_size);
+	TMyOracleResultSet* RunQuery(const std::string& query, const TMyOracleBinds& binds);
+	bool RunRows(const std::string& query, const TMyOracleBinds& binds, TMyOracleRowReader& reader);
+
+	unsigned int m_fetch_size{ 0 };
+	unsigned int m_prefetch_size{ 0 };
+	size_t m_batch_chunk_size{ 100 };
+	size_t m_array_size{ 1000 };
+
+	// Statements kept prepared on this connection, by SQL text
+	std::unordered_map<std::string, std::unique_ptr<TMyOraclePreparedStatement>> m_prepared;
+
+	TMyOracleMetrics m_metrics;
+
+	std::shared_ptr<TMyOracleResultCache> m_cache;
+	// Drops the cached results of the tables a DML statement writes to
+	void InvalidateCache(const std::string& query);
+
+	// Open TMyOracleTransaction, the writes that succeeded in it and the
+	// tables they wrote to, invalidated in the cache once it commits
+	bool m_in_transaction{ false };
+	size_t m_transaction_writes{ 0 };
+	std::vector<std::string> m_transaction_tables;
 
-	std::unique_ptr<Connection> m_conn = nullptr;
+	// Commit policy after a statement ran, the caller holds m_mutex. Outside
+	// of a transaction a write is committed if it succeeded and rolled back
+	// otherwise. Returns false if the commit failed.
+	bool EndStatement(const std::string& query, bool read_only, bool success, TMyOracleQueryTimer& timer);
+	// TMyOracleTransaction
+	bool BeginTransaction();
+	bool EndTransaction(bool commit, TMyOracleCommitMode mode);
 };
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,237 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleArena.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+// -----------------------------------------------------------------------------
+// First block taken after the inline one, each next block is twice the size
+static constexpr size_t FIRST_BLOCK_SIZE = 8 * 1024;
+static constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+// Bound of the blocks a thread keeps
+static constexpr size_t MAX_CACHED_BLOCKS = 8;
+static constexpr size_t MAX_CACHED_BYTES = 4 * 1024 * 1024;
+// -----------------------------------------------------------------------------
+static std::atomic<bool> s_enabled{ true };
+// -----------------------------------------------------------------------------
+// Process wide counters, see TMyOracleAllocationStats
+static std::atomic<uint64_t> s_arenas{ 0 };
+static std::atomic<uint64_t> s_allocations{ 0 };
+static std::atomic<uint64_t> s_bytes{ 0 };
+static std::atomic<uint64_t> s_heap_allocations{ 0 };
+static std::atomic<uint64_t> s_heap_bytes{ 0 };
+static std::atomic<uint64_t> s_reused_blocks{ 0 };
+// -----------------------------------------------------------------------------
+// The heap, counted. Every buffer is a call to operator new.
+class TMyOracleCountingHeap : public std::pmr::memory_resource
+{
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		s_allocations.fetch_add(1, std::memory_order_relaxed);
+		s_bytes.fetch_add(bytes, std::memory_order_relaxed);
+		s_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+		s_heap_bytes.fetch_add(bytes, std::memory_order_relaxed);
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+// -----------------------------------------------------------------------------
+// Cleared when the thread cache is destroyed: arenas that outlive it (results
+// held by statics) free their blocks
+static thread_local bool t_cache_alive = false;
+// -----------------------------------------------------------------------------
+struct TMyOracleArena::ThreadCache
+{
+	Block* blocks = nullptr;
+	size_t count = 0;
+	size_t bytes = 0;
+
+	ThreadCache()
+	{
+		t_cache_alive = true;
+	}
+
+	~ThreadCache()
+	{
+		t_cache_alive = false;
+		while (blocks)
+		{
+			Block* next = blocks->next;
+			::operator delete(blocks);
+			blocks = next;
+		}
+	}
+
+	// A block of at least size bytes, nullptr if none is kept
+	Block* Take(size_t size)
+	{
+		for (Block** it = &blocks; *it; it = &(*it)->next)
+		{
+			if ((*it)->size >= size)
+			{
+				Block* block = *it;
+				*it = block->next;
+				--count;
+				bytes -= block->size;
+				return block;
+			}
+		}
+		return nullptr;
+	}
+
+	// False if the cache is full, the block is then the caller's to free
+	bool Give(Block* block)
+	{
+		if (count >= MAX_CACHED_BLOCKS || bytes + block->size > MAX_CACHED_BYTES)
+		{
+			return false;
+		}
+		block->next = blocks;
+		blocks = block;
+		++count;
+		bytes += block->size;
+		return true;
+	}
+};
+// -----------------------------------------------------------------------------
+TMyOracleArena::ThreadCache* TMyOracleArena::Cache()
+{
+	static thread_local bool created = false;
+	if (created && !t_cache_alive)
+	{
+		return nullptr;
+	}
+	created = true;
+
+	thread_local ThreadCache cache;
+	return &cache;
+}
+// -----------------------------------------------------------------------------
+TMyOracleArena::~TMyOracleArena()
+{
+	ThreadCache* cache = Cache();
+	while (m_blocks)
+	{
+		Block* next = m_blocks->next;
+		if (!cache || !cache->Give(m_blocks))
+		{
+			::operator delete(m_blocks);
+		}
+		m_blocks = next;
+	}
+
+	s_arenas.fetch_add(1, std::memory_order_relaxed);
+	s_allocations.fetch_add(m_allocations, std::memory_order_relaxed);
+	s_bytes.fetch_add(m_used, std::memory_order_relaxed);
+	// The arena itself is one more
+	s_heap_allocations.fetch_add(m_heap_allocations + 1, std::memory_order_relaxed);
+	s_heap_bytes.fetch_add(m_heap_bytes + sizeof(*this), std::memory_order_relaxed);
+	s_reused_blocks.fetch_add(m_reused_blocks, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleArena::Grow(size_t bytes, size_t alignment)
+{
+	const size_t needed = bytes + alignment;
+	const size_t size = std::max(needed, m_next_block > 0 ? m_next_block : FIRST_BLOCK_SIZE);
+
+	ThreadCache* cache = Cache();
+	Block* block = cache ? cache->Take(needed) : nullptr;
+	if (block)
+	{
+		++m_reused_blocks;
+	}
+	else
+	{
+		block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+		block->size = size;
+		++m_heap_allocations;
+		m_heap_bytes += sizeof(Block) + size;
+	}
+
+	block->next = m_blocks;
+	m_blocks = block;
+	m_top = reinterpret_cast<std::byte*>(block + 1);
+	m_end = m_top + block->size;
+	m_last = nullptr;
+	m_reserved += block->size;
+	m_next_block = std::min(std::max(size, block->size) * 2, MAX_BLOCK_SIZE);
+}
+// -----------------------------------------------------------------------------
+void* TMyOracleArena::do_allocate(size_t bytes, size_t alignment)
+{
+	auto Align = [alignment](std::byte* p)
+	{
+		const uintptr_t address = reinterpret_cast<uintptr_t>(p);
+		return p + ((alignment - address % alignment) % alignment);
+	};
+
+	std::byte* p = Align(m_top);
+	if (p > m_end || static_cast<size_t>(m_end - p) < bytes)
+	{
+		Grow(bytes, alignment);
+		p = Align(m_top);
+	}
+
+	m_last = p;
+	m_top = p + bytes;
+	m_used += bytes;
+	++m_allocations;
+	return p;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleArena::do_deallocate(void* p, size_t bytes, size_t)
+{
+	// Only the last allocation can be taken back, the rest goes with the arena
+	if (p == m_last && m_last + bytes == m_top)
+	{
+		m_top = m_last;
+		m_last = nullptr;
+		m_used -= bytes;
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleArena::SetEnabled(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleArena::IsEnabled()
+{
+	return s_enabled.load(std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+const std::shared_ptr<std::pmr::memory_resource>& TMyOracleArena::Heap()
+{
+	static const std::shared_ptr<std::pmr::memory_resource> heap = std::make_shared<TMyOracleCountingHeap>();
+	return heap;
+}
+// -----------------------------------------------------------------------------
+TMyOracleAllocationStats TMyOracleArena::Stats()
+{
+	TMyOracleAllocationStats stats;
+	stats.arenas = s_arenas.load(std::memory_order_relaxed);
+	stats.allocations = s_allocations.load(std::memory_order_relaxed);
+	stats.bytes = s_bytes.load(std::memory_order_relaxed);
+	stats.heap_allocations = s_heap_allocations.load(std::memory_order_relaxed);
+	stats.heap_bytes = s_heap_bytes.load(std::memory_order_relaxed);
+	stats.reused_blocks = s_reused_blocks.load(std::memory_order_relaxed);
+	return stats;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleArena::ResetStats()
+{
+	s_arenas.store(0, std::memory_order_relaxed);
+	s_allocations.store(0, std::memory_order_relaxed);
+	s_bytes.store(0, std::memory_order_relaxed);
+	s_heap_allocations.store(0, std::memory_order_relaxed);
+	s_heap_bytes.store(0, std::memory_order_relaxed);
+	s_reused_blocks.store(0, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
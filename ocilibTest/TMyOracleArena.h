@@ -0,0 +1,105 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEARENA_H__
+#define __TMYORACLEARENA_H__
+// -----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+// -----------------------------------------------------------------------------
+
+// Counters of the memory behind client result sets, process wide. An arena
+// adds its counts when it is destroyed.
+struct TMyOracleAllocationStats
+{
+	// Result sets built in an arena
+	uint64_t arenas = 0;
+	// Buffers the columns asked for
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+	// Calls to the heap: the arenas and their blocks, or every buffer
+	// without arenas
+	uint64_t heap_allocations = 0;
+	uint64_t heap_bytes = 0;
+	// Arena blocks taken back from the thread instead of the heap
+	uint64_t reused_blocks = 0;
+};
+
+// Monotonic (bump) allocator of one result set.
+//
+// The columns of a result set allocate their buffers here instead of on the
+// heap: a whole result takes a handful of blocks, and is freed in one step
+// when its last column goes. Freeing a buffer only gives memory back when it
+// was the last one allocated, which is what growing a column does.
+//
+// The first block lives inside the arena object. Later blocks come from a
+// per-thread cache of the blocks of destroyed arenas before the heap, so a
+// thread that keeps building results of similar size stops calling malloc.
+// An arena is used by one thread at a time; it may be destroyed on another
+// thread, the blocks then go to that thread's cache.
+class TMyOracleArena : public std::pmr::memory_resource
+{
+public:
+	TMyOracleArena() = default;
+	~TMyOracleArena() override;
+
+	// Prevent copying
+	TMyOracleArena(const TMyOracleArena&) = delete;
+	TMyOracleArena& operator=(const TMyOracleArena&) = delete;
+
+	// Bytes handed out, and held in blocks
+	size_t Used() const { return m_used; }
+	size_t Reserved() const { return m_reserved; }
+
+	// Whether TMyOracleResultSet::Create() builds results in an arena (the
+	// default) or on the heap through Heap(), to compare the two
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	// The heap behind the same counters, for result sets without an arena
+	static const std::shared_ptr<std::pmr::memory_resource>& Heap();
+
+	static TMyOracleAllocationStats Stats();
+	static void ResetStats();
+
+private:
+	struct Block
+	{
+		Block* next;
+		size_t size;	// bytes after the header
+	};
+	// Blocks kept by a thread for its next arenas, nullptr once the thread
+	// is exiting
+	struct ThreadCache;
+	static ThreadCache* Cache();
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	// Makes room for bytes at alignment in a new block
+	void Grow(size_t bytes, size_t alignment);
+
+	static constexpr size_t INLINE_SIZE = 1024;
+
+	alignas(std::max_align_t) std::byte m_inline[INLINE_SIZE];
+	std::byte* m_top = m_inline;
+	std::byte* m_end = m_inline + INLINE_SIZE;
+	// Start of the last allocation, which deallocate can take back
+	std::byte* m_last = nullptr;
+
+	Block* m_blocks = nullptr;
+	size_t m_next_block = 0;
+
+	size_t m_used = 0;
+	size_t m_reserved = INLINE_SIZE;
+
+	uint64_t m_allocations = 0;
+	uint64_t m_heap_allocations = 0;
+	uint64_t m_heap_bytes = 0;
+	uint64_t m_reused_blocks = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
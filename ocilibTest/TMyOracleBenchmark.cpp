@@ -0,0 +1,690 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleBenchmark.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+// -----------------------------------------------------------------------------
+// Percentiles every report shows, and their JSON names
+static const std::pair<double, const char*> REPORT_PERCENTILES[] =
+{
+	{ 50.0, "p50" },
+	{ 90.0, "p90" },
+	{ 99.0, "p99" },
+	{ 99.9, "p99_9" }
+};
+// -----------------------------------------------------------------------------
+static bool ParseUnsigned(const std::string& text, size_t& value)
+{
+	char* end = nullptr;
+	const unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+	if (text.empty() || *end != '\0' || text[0] == '-')
+	{
+		return false;
+	}
+	value = static_cast<size_t>(parsed);
+	return true;
+}
+// -----------------------------------------------------------------------------
+static bool ParseDouble(const std::string& text, double& value)
+{
+	char* end = nullptr;
+	value = std::strtod(text.c_str(), &end);
+	return !text.empty() && *end == '\0' && value >= 0.0;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleBenchmarkConfig::Parse(int argc, const char* argv[], std::string& error)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+
+		// --simulated takes an optional directory
+		if (option == "--simulated")
+		{
+			simulated = true;
+			if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+			{
+				sql_dir = argv[++i];
+			}
+			continue;
+		}
+
+		if (option == "--help")
+		{
+			error.clear();
+			return false;
+		}
+
+		if (i + 1 >= argc)
+		{
+			error = "Missing value for " + option;
+			return false;
+		}
+		const std::string value = argv[++i];
+
+		size_t number = 0;
+		double real = 0.0;
+		bool valid = true;
+
+		if (option == "--threads")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			threads = number;
+		}
+		else if (option == "--connections")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			connections = number;
+		}
+		else if (option == "--pool")
+		{
+			valid = value == "dedicated" || value == "session";
+			pool_type = value == "session" ? SQL_POOL_TYPE::SESSION_POOL : SQL_POOL_TYPE::DEDICATED;
+		}
+		else if (option == "--duration")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			duration = std::chrono::seconds(number);
+		}
+		else if (option == "--warmup")
+		{
+			valid = ParseUnsigned(value, number);
+			warmup = std::chrono::seconds(number);
+		}
+		else if (option == "--mix")
+		{
+			// name=weight,name=weight,...
+			mix.clear();
+			std::istringstream entries(value);
+			std::string entry;
+			while (valid && std::getline(entries, entry, ','))
+			{
+				const size_t equal = entry.find('=');
+				valid = equal != std::string::npos && equal > 0 && ParseUnsigned(entry.substr(equal + 1), number);
+				if (valid && number > 0)
+				{
+					mix.emplace_back(entry.substr(0, equal), static_cast<unsigned int>(number));
+				}
+			}
+			valid = valid && !mix.empty();
+		}
+		else if (option == "--keys")
+		{
+			// N for 1..N, or MIN-MAX
+			const size_t dash = value.find('-');
+			size_t low = 1;
+			valid = dash == std::string::npos
+				? ParseUnsigned(value, number)
+				: ParseUnsigned(value.substr(0, dash), low) && ParseUnsigned(value.substr(dash + 1), number);
+			valid = valid && number >= low && low > 0;
+			key_min = static_cast<int64_t>(low);
+			key_max = static_cast<int64_t>(number);
+		}
+		else if (option == "--dist")
+		{
+			// uniform, zipf or zipf:theta
+			if (value == "uniform")
+			{
+				distribution = TMyOracleKeyDistribution::UNIFORM;
+			}
+			else if (value.rfind("zipf", 0) == 0)
+			{
+				distribution = TMyOracleKeyDistribution::ZIPF;
+				if (value.size() > 4)
+				{
+					valid = value[4] == ':' && ParseDouble(value.substr(5), zipf_theta);
+				}
+			}
+			else
+			{
+				valid = false;
+			}
+		}
+		else if (option == "--batch-size")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			batch_size = number;
+		}
+		else if (option == "--commit")
+		{
+			if (value == "statement")
+			{
+				commit = TMyOracleCommitPolicy::STATEMENT;
+			}
+			else if (value == "group")
+			{
+				commit = TMyOracleCommitPolicy::GROUP;
+			}
+			else if (value == "nowait")
+			{
+				commit = TMyOracleCommitPolicy::NOWAIT;
+			}
+			else
+			{
+				valid = false;
+			}
+		}
+		else if (option == "--qps")
+		{
+			valid = ParseDouble(value, real);
+			target_qps = real;
+		}
+		else if (option == "--json")
+		{
+			json_path = value;
+		}
+		else if (option == "--join")
+		{
+			valid = value == "client" || value == "server";
+			client_join = value == "client";
+		}
+		else if (option == "--cache")
+		{
+			valid = ParseUnsigned(value, number);
+			cache_mb = number;
+		}
+		else if (option == "--arena")
+		{
+			valid = value == "on" || value == "off";
+			arena = value == "on";
+		}
+		else if (option == "--affine")
+		{
+			valid = value == "on" || value == "off";
+			thread_affine = value == "on";
+		}
+		else if (option == "--timeout")
+		{
+			valid = ParseUnsigned(value, number);
+			call_timeout = std::chrono::milliseconds(number);
+		}
+		else if (option == "--hedge")
+		{
+			valid = ParseUnsigned(value, number);
+			hedge_threads = number;
+		}
+		else if (option == "--health")
+		{
+			valid = ParseUnsigned(value, number);
+			health_interval = std::chrono::milliseconds(number);
+		}
+		else if (option == "--spikes")
+		{
+			valid = ParseDouble(value, real) && real <= 1.0;
+			spike_rate = real;
+		}
+		else if (option == "--disconnects")
+		{
+			valid = ParseDouble(value, real) && real <= 1.0;
+			disconnect_rate = real;
+		}
+		else if (option == "--log")
+		{
+			static const char* LEVELS[] = { "trace", "debug", "info", "warn", "error", "fatal", "off" };
+			valid = false;
+			for (size_t level = 0; level < sizeof(LEVELS) / sizeof(LEVELS[0]); ++level)
+			{
+				if (value == LEVELS[level])
+				{
+					log_level = static_cast<TMyOracleLogLevel>(level);
+					valid = true;
+				}
+			}
+		}
+		else if (option == "--cache-ttl")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			cache_ttl = std::chrono::milliseconds(number);
+		}
+		else if (option == "--metrics")
+		{
+			metrics_path = value;
+		}
+		else if (option == "--load")
+		{
+			// FILE or FILE:TABLE, a ':' right after a drive letter is part of
+			// the path
+			const size_t colon = value.rfind(':');
+			load_path = colon != std::string::npos && colon > 1 ? value.substr(0, colon) : value;
+			load_table = colon != std::string::npos && colon > 1 ? value.substr(colon + 1) : std::string();
+			valid = !load_path.empty();
+		}
+		else if (option == "--array-size")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			array_size = number;
+		}
+		else if (option == "--direct")
+		{
+			valid = ParseUnsigned(value, number) && number > 0;
+			direct_path = true;
+			load_streams = number;
+		}
+		else
+		{
+			error = "Unknown option " + option;
+			return false;
+		}
+
+		if (!valid)
+		{
+			error = "Invalid value for " + option + ": " + value;
+			return false;
+		}
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
+std::string TMyOracleBenchmarkConfig::Usage()
+{
+	return
+		"Usage: ocilibTest [options]\n"
+		"  --threads N             load threads (20)\n"
+		"  --connections N         pooled connections (10)\n"
+		"  --pool dedicated|session  pool type (dedicated)\n"
+		"  --duration S            measured seconds (10)\n"
+		"  --warmup S              seconds run before measuring (2)\n"
+		"  --mix name=w,...        operations by weight (point=90,batch=10)\n"
+		"                          operations: point, batch, scan, write, hedged\n"
+		"  --keys N | MIN-MAX      employee ids drawn (1-1000)\n"
+		"  --dist uniform|zipf[:theta]  key distribution (uniform, theta 0.99)\n"
+		"  --batch-size N          ids per batch operation, rows per write operation (100)\n"
+		"  --commit statement|group|nowait  write commits per row, per operation or per\n"
+		"                          operation without waiting for the redo (statement)\n"
+		"  --qps N                 open loop at N operations/s, 0 for closed loop (0)\n"
+		"  --join client|server    department joined from a replicated copy or by the server (client)\n"
+		"  --cache MB              result cache of MB for the point lookups, 0 for none (0)\n"
+		"  --cache-ttl MS          lifetime of a cached result (60000)\n"
+		"  --arena on|off          build result sets in per-result arenas (on)\n"
+		"  --affine on|off         pin a connection per thread, needs --connections >= --threads (off)\n"
+		"  --timeout MS            deadline of every call, 0 for none (0)\n"
+		"  --hedge N               N workers more for the hedged operation, a point lookup\n"
+		"                          run again on a second connection past the p95 (0)\n"
+		"  --health MS             ping the connections idle for MS every MS, 0 for none (0)\n"
+		"  --log LEVEL             trace, debug, info, warn, error, fatal or off (info)\n"
+		"  --load FILE[:TABLE]     bulk load a SQL script, or a CSV into TABLE, before the run\n"
+		"  --array-size N          rows per round trip of the load (1000)\n"
+		"  --direct N              load the CSV in direct path on N connections\n"
+		"  --json PATH             write the report as JSON\n"
+		"  --metrics PATH          time query phases, write them in Prometheus text format\n"
+		"  --simulated [DIR]       in-process database loaded from DIR (../SQL_Tables)\n"
+		"  --spikes RATE           simulated round trips taking 50 ms, 0.01 for 1% (0)\n"
+		"  --disconnects RATE      simulated round trips losing their session (0)\n";
+}
+// -----------------------------------------------------------------------------
+TMyOracleKeyGenerator::TMyOracleKeyGenerator(const TMyOracleBenchmarkConfig& config, std::shared_ptr<const std::vector<double>> zipf_cdf, uint64_t seed)
+	: m_key_min(config.key_min), m_key_max(config.key_max), m_zipf_cdf(std::move(zipf_cdf)), m_random(seed)
+{
+}
+// -----------------------------------------------------------------------------
+std::shared_ptr<const std::vector<double>> TMyOracleKeyGenerator::ZipfCdf(size_t keys, double theta)
+{
+	auto cdf = std::make_shared<std::vector<double>>(keys);
+
+	double sum = 0.0;
+	for (size_t rank = 1; rank <= keys; ++rank)
+	{
+		sum += 1.0 / std::pow(static_cast<double>(rank), theta);
+		(*cdf)[rank - 1] = sum;
+	}
+	for (double& value : *cdf)
+	{
+		value /= sum;
+	}
+	return cdf;
+}
+// -----------------------------------------------------------------------------
+int64_t TMyOracleKeyGenerator::Next()
+{
+	if (!m_zipf_cdf)
+	{
+		return std::uniform_int_distribution<int64_t>(m_key_min, m_key_max)(m_random);
+	}
+
+	const double draw = std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+	const auto rank = std::lower_bound(m_zipf_cdf->begin(), m_zipf_cdf->end(), draw);
+	return m_key_min + std::min<int64_t>(rank - m_zipf_cdf->begin(), m_key_max - m_key_min);
+}
+// -----------------------------------------------------------------------------
+std::vector<int64_t> TMyOracleKeyGenerator::Next(size_t count)
+{
+	std::vector<int64_t> keys;
+	keys.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		keys.push_back(Next());
+	}
+	return keys;
+}
+// -----------------------------------------------------------------------------
+static void PrintLine(std::ostream& out, const TMyOracleBenchmarkResult& result, double seconds)
+{
+	const TMyOracleHistogram& latency = result.latency;
+	auto Ms = [](double us) { return us / 1000.0; };
+
+	out << std::left << std::setw(10) << result.name << std::right
+		<< std::setw(10) << latency.Count()
+		<< std::setw(8) << result.errors
+		<< std::setw(11) << std::fixed << std::setprecision(1) << (seconds > 0.0 ? latency.Count() / seconds : 0.0)
+		<< std::setprecision(3)
+		<< std::setw(10) << Ms(static_cast<double>(latency.Min()))
+		<< std::setw(10) << Ms(latency.Mean());
+	for (const auto& percentile : REPORT_PERCENTILES)
+	{
+		out << std::setw(10) << Ms(static_cast<double>(latency.ValueAtPercentile(percentile.first)));
+	}
+	out << std::setw(10) << Ms(static_cast<double>(latency.Max())) << std::defaultfloat << std::endl;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleBenchmarkReport::Print(std::ostream& out) const
+{
+	out << std::left << std::setw(10) << "operation" << std::right
+		<< std::setw(10) << "count"
+		<< std::setw(8) << "errors"
+		<< std::setw(11) << "ops/s"
+		<< std::setw(10) << "min ms"
+		<< std::setw(10) << "mean ms"
+		<< std::setw(10) << "p50 ms"
+		<< std::setw(10) << "p90 ms"
+		<< std::setw(10) << "p99 ms"
+		<< std::setw(10) << "p99.9 ms"
+		<< std::setw(10) << "max ms" << std::endl;
+
+	for (const auto& operation : operations)
+	{
+		PrintLine(out, operation, seconds);
+	}
+	PrintLine(out, total, seconds);
+
+	TMyOracleBenchmarkResult wait{ "acquire", 0, acquire };
+	PrintLine(out, wait, 0.0);
+
+	if (late_starts > 0)
+	{
+		out << late_starts << " operation(s) started more than one interval late, the target rate was not reached" << std::endl;
+	}
+
+	const double ops = total.latency.Count() > 0 ? static_cast<double>(total.latency.Count()) : 1.0;
+	out << "Result sets: " << allocations.allocations << " allocation(s), " << allocations.bytes / 1024 << " KiB, "
+		<< allocations.heap_allocations << " from the heap (" << std::fixed << std::setprecision(1)
+		<< static_cast<double>(allocations.heap_allocations) / ops << "/op)" << std::defaultfloat;
+	if (allocations.arenas > 0)
+	{
+		out << ", " << allocations.arenas << " arena(s), " << allocations.reused_blocks << " block(s) reused";
+	}
+	out << std::endl;
+}
+// -----------------------------------------------------------------------------
+static void WriteHistogramJson(std::ostream& out, const TMyOracleHistogram& histogram)
+{
+	out << "{ \"count\": " << histogram.Count()
+		<< ", \"min\": " << histogram.Min()
+		<< ", \"mean\": " << histogram.Mean();
+	for (const auto& percentile : REPORT_PERCENTILES)
+	{
+		out << ", \"" << percentile.second << "\": " << histogram.ValueAtPercentile(percentile.first);
+	}
+	out << ", \"max\": " << histogram.Max() << " }";
+}
+// -----------------------------------------------------------------------------
+static void WriteResultJson(std::ostream& out, const TMyOracleBenchmarkResult& result, double seconds)
+{
+	out << "{ \"name\": \"" << result.name << "\""
+		<< ", \"count\": " << result.latency.Count()
+		<< ", \"errors\": " << result.errors
+		<< ", \"throughput\": " << (seconds > 0.0 ? result.latency.Count() / seconds : 0.0)
+		<< ", \"latency_us\": ";
+	WriteHistogramJson(out, result.latency);
+	out << " }";
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleBenchmarkReport::WriteJson(const std::string& path, const TMyOracleBenchmarkConfig& config) const
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleBenchmarkReport::WriteJson: Cannot create ", path);
+		return false;
+	}
+
+	out << "{\n  \"config\": { \"threads\": " << config.threads
+		<< ", \"connections\": " << config.connections
+		<< ", \"pool\": \"" << (config.pool_type == SQL_POOL_TYPE::SESSION_POOL ? "session" : "dedicated") << "\""
+		<< ", \"duration\": " << config.duration.count()
+		<< ", \"warmup\": " << config.warmup.count()
+		<< ", \"mix\": {";
+	for (size_t i = 0; i < config.mix.size(); ++i)
+	{
+		out << (i > 0 ? ", \"" : " \"") << config.mix[i].first << "\": " << config.mix[i].second;
+	}
+	out << " }, \"key_min\": " << config.key_min
+		<< ", \"key_max\": " << config.key_max
+		<< ", \"distribution\": \"" << (config.distribution == TMyOracleKeyDistribution::ZIPF ? "zipf" : "uniform") << "\""
+		<< ", \"zipf_theta\": " << config.zipf_theta
+		<< ", \"batch_size\": " << config.batch_size
+		<< ", \"commit\": \"" << (config.commit == TMyOracleCommitPolicy::GROUP ? "group" : config.commit == TMyOracleCommitPolicy::NOWAIT ? "nowait" : "statement") << "\""
+		<< ", \"target_qps\": " << config.target_qps
+		<< ", \"join\": \"" << (config.client_join ? "client" : "server") << "\""
+		<< ", \"cache_mb\": " << config.cache_mb
+		<< ", \"cache_ttl_ms\": " << config.cache_ttl.count()
+		<< ", \"arena\": " << (config.arena ? "true" : "false")
+		<< ", \"thread_affine\": " << (config.thread_affine ? "true" : "false")
+		<< ", \"call_timeout_ms\": " << config.call_timeout.count()
+		<< ", \"hedge_threads\": " << config.hedge_threads
+		<< ", \"health_interval_ms\": " << config.health_interval.count()
+		<< ", \"spike_rate\": " << config.spike_rate
+		<< ", \"disconnect_rate\": " << config.disconnect_rate
+		<< ", \"simulated\": " << (config.simulated ? "true" : "false") << " },\n";
+
+	out << "  \"seconds\": " << seconds << ",\n  \"operations\": [";
+	for (size_t i = 0; i < operations.size(); ++i)
+	{
+		out << (i > 0 ? ",\n    " : "\n    ");
+		WriteResultJson(out, operations[i], seconds);
+	}
+	out << "\n  ],\n  \"total\": ";
+	WriteResultJson(out, total, seconds);
+	out << ",\n  \"acquire_us\": ";
+	WriteHistogramJson(out, acquire);
+	out << ",\n  \"late_starts\": " << late_starts;
+	out << ",\n  \"allocations\": { \"arenas\": " << allocations.arenas
+		<< ", \"allocations\": " << allocations.allocations
+		<< ", \"bytes\": " << allocations.bytes
+		<< ", \"heap_allocations\": " << allocations.heap_allocations
+		<< ", \"heap_bytes\": " << allocations.heap_bytes
+		<< ", \"reused_blocks\": " << allocations.reused_blocks << " }\n}\n";
+
+	return static_cast<bool>(out);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleBenchmark::AddOperation(const std::string& name, Operation operation)
+{
+	m_operations.emplace_back(name, std::move(operation));
+}
+// -----------------------------------------------------------------------------
+void TMyOracleBenchmark::Worker(SqlConnection& pool, size_t thread_index, std::chrono::steady_clock::time_point start, ThreadResult& result) const
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point measure_from = start + m_config.warmup;
+	const Clock::time_point measure_to = measure_from + m_config.duration;
+
+	TMyOracleKeyGenerator keys(m_config, m_zipf_cdf, std::random_device{}() ^ (thread_index * 0x9E3779B97F4A7C15ull));
+	std::discrete_distribution<size_t> pick(m_mix_weights.begin(), m_mix_weights.end());
+
+	// Open loop: this thread's share of the rate, its slots staggered with
+	// the other threads
+	const bool open_loop = m_config.target_qps > 0.0;
+	const auto interval = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(open_loop ? m_config.threads / m_config.target_qps : 0.0));
+	Clock::time_point scheduled = start + interval * thread_index / m_config.threads;
+
+	for (;;)
+	{
+		Clock::time_point now = Clock::now();
+		if (open_loop)
+		{
+			if (scheduled >= measure_to)
+			{
+				break;
+			}
+			if (now < scheduled)
+			{
+				std::this_thread::sleep_until(scheduled);
+				now = Clock::now();
+			}
+			else if (now - scheduled > interval && scheduled >= measure_from)
+			{
+				++result.late_starts;
+			}
+		}
+		else if (now >= measure_to)
+		{
+			break;
+		}
+
+		// Latency counts from the scheduled start in open loop, so that a
+		// stall delays every operation queued behind it
+		const Clock::time_point origin = open_loop ? scheduled : now;
+		const bool measured = origin >= measure_from;
+		scheduled += interval;
+
+		const size_t mix_index = pick(keys.Random());
+		TMyOracleBenchmarkResult& counters = result.operations[mix_index];
+
+		SqlConnectionLease lease;
+		TMyOracle* sql = nullptr;
+		if (m_config.thread_affine)
+		{
+			sql = pool.Pin();
+		}
+		else
+		{
+			lease = pool.Acquire();
+			sql = lease.get();
+		}
+		const Clock::time_point leased = Clock::now();
+		if (measured)
+		{
+			result.acquire.Record(std::chrono::duration_cast<std::chrono::microseconds>(leased - now).count());
+		}
+		if (!sql)
+		{
+			counters.errors += measured ? 1 : 0;
+			continue;
+		}
+
+		const bool success = m_operations[m_mix_operations[mix_index]].second(sql, keys);
+		lease.Release();
+
+		if (measured)
+		{
+			if (success)
+			{
+				counters.latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count());
+			}
+			else
+			{
+				++counters.errors;
+			}
+		}
+	}
+
+	if (m_config.thread_affine)
+	{
+		pool.Unpin();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleBenchmark::Run(SqlConnection& pool, TMyOracleBenchmarkReport& report)
+{
+	m_mix_operations.clear();
+	m_mix_weights.clear();
+	for (const auto& entry : m_config.mix)
+	{
+		auto it = std::find_if(m_operations.begin(), m_operations.end(), [&entry](const auto& operation) { return operation.first == entry.first; });
+		if (it == m_operations.end())
+		{
+			TMYORACLE_LOG_ERROR("TMyOracleBenchmark::Run: Unknown operation ", entry.first);
+			return false;
+		}
+		m_mix_operations.push_back(it - m_operations.begin());
+		m_mix_weights.push_back(entry.second);
+	}
+
+	if (m_config.thread_affine && m_config.threads > pool.MaxConnections())
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleBenchmark::Run: --affine needs a connection per thread, ", m_config.threads, " thread(s) for ", pool.MaxConnections(), " connection(s)");
+		return false;
+	}
+
+	m_zipf_cdf.reset();
+	if (m_config.distribution == TMyOracleKeyDistribution::ZIPF)
+	{
+		m_zipf_cdf = TMyOracleKeyGenerator::ZipfCdf(static_cast<size_t>(m_config.key_max - m_config.key_min + 1), m_config.zipf_theta);
+	}
+
+	std::vector<ThreadResult> results(m_config.threads);
+	for (auto& result : results)
+	{
+		for (const auto& entry : m_config.mix)
+		{
+			result.operations.push_back({ entry.first, 0, TMyOracleHistogram() });
+		}
+	}
+
+	TMYORACLE_LOG_INFO("Benchmark: ", m_config.threads, " thread(s), ", m_config.warmup.count(), " s warm-up, ",
+		m_config.duration.count(), " s measured, ",
+		(m_config.target_qps > 0.0 ? std::to_string(static_cast<int64_t>(m_config.target_qps)) + " ops/s open loop" : std::string("closed loop")));
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < m_config.threads; ++i)
+	{
+		threads.emplace_back(&TMyOracleBenchmark::Worker, this, std::ref(pool), i, start, std::ref(results[i]));
+	}
+
+	// Leave the warm-up out of the metrics and the allocation counters
+	std::this_thread::sleep_until(start + m_config.warmup);
+	if (TMyOracleMetrics::IsEnabled())
+	{
+		pool.ResetMetrics();
+	}
+	TMyOracleArena::ResetStats();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Merge the per-thread histograms
+	report = TMyOracleBenchmarkReport();
+	report.seconds = std::chrono::duration<double>(m_config.duration).count();
+	report.total.name = "total";
+	for (const auto& entry : m_config.mix)
+	{
+		report.operations.push_back({ entry.first, 0, TMyOracleHistogram() });
+	}
+	for (const auto& result : results)
+	{
+		for (size_t i = 0; i < result.operations.size(); ++i)
+		{
+			report.operations[i].latency.Merge(result.operations[i].latency);
+			report.operations[i].errors += result.operations[i].errors;
+			report.total.latency.Merge(result.operations[i].latency);
+			report.total.errors += result.operations[i].errors;
+		}
+		report.acquire.Merge(result.acquire);
+		report.late_starts += result.late_starts;
+	}
+	report.allocations = TMyOracleArena::Stats();
+
+	return true;
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,203 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEBENCHMARK_H__
+#define __TMYORACLEBENCHMARK_H__
+// -----------------------------------------------------------------------------
+#include "SqlConnection.h"
+#include "TMyOracleArena.h"
+#include "TMyOracleHistogram.h"
+#include "TMyOracleLog.h"
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+enum class TMyOracleKeyDistribution
+{
+	UNIFORM = 1,
+	ZIPF = 2	// rank r is drawn with probability ~ 1 / r^theta, key_min is the hottest
+};
+
+// Commits of the write operation, see TMyOracleTransaction
+enum class TMyOracleCommitPolicy
+{
+	STATEMENT = 1,	// each row commits
+	GROUP = 2,		// the rows of an operation commit together
+	NOWAIT = 3		// same, without waiting for the redo
+};
+
+struct TMyOracleBenchmarkConfig
+{
+	size_t threads = 20;
+	size_t connections = 10;
+	SQL_POOL_TYPE pool_type = SQL_POOL_TYPE::DEDICATED;
+
+	std::chrono::seconds duration{ 10 };
+	// Run before the measurement starts, nothing is recorded
+	std::chrono::seconds warmup{ 2 };
+
+	// Operations by weight, "point=90,batch=10"
+	std::vector<std::pair<std::string, unsigned int>> mix{ { "point", 90 }, { "batch", 10 } };
+
+	int64_t key_min = 1;
+	int64_t key_max = 1000;
+	TMyOracleKeyDistribution distribution = TMyOracleKeyDistribution::UNIFORM;
+	double zipf_theta = 0.99;
+	// Keys (rows written) per operation for the operations that take several
+	size_t batch_size = 100;
+	TMyOracleCommitPolicy commit = TMyOracleCommitPolicy::STATEMENT;
+
+	// Open loop when > 0: operations start on a fixed schedule whether or not
+	// the previous ones finished, and latency counts from the scheduled start.
+	// 0 runs closed loop, each thread starting the next operation when its
+	// previous one returns.
+	double target_qps = 0.0;
+
+	// Replicates DEPARTMENT and drops it from the employee queries
+	bool client_join = true;
+
+	// Result cache for the point lookups, none when 0
+	size_t cache_mb = 0;
+	std::chrono::milliseconds cache_ttl{ 60000 };
+
+	// Script or CSV bulk loaded before the run, see TMyOracleLoader. A CSV
+	// needs the table it goes to.
+	std::string load_path;
+	std::string load_table;
+	// Rows per array DML round trip of the load
+	size_t array_size = 1000;
+	// Loads the CSV in direct path instead, on load_streams connections
+	bool direct_path = false;
+	size_t load_streams = 1;
+
+	// Client result sets built in arenas, see TMyOracleArena
+	bool arena = true;
+	// Every thread pins a connection for the run instead of leasing one per
+	// operation, see SqlConnection::Pin(). Needs a connection per thread.
+	bool thread_affine = false;
+
+	// Deadline of every call, none when 0, see TMyOracle::SetCallTimeout()
+	std::chrono::milliseconds call_timeout{ 0 };
+	// Workers of the "hedged" operation, the point lookup run as a hedged
+	// read (see TMyOracleExecutor::ExecuteHedgedQuery()). They hold a
+	// connection each on top of the benchmark threads. None when 0.
+	size_t hedge_threads = 0;
+	// Interval of the pool health checker, none when 0, see
+	// SqlConnection::StartHealthCheck()
+	std::chrono::milliseconds health_interval{ 0 };
+
+	// Messages below are not written, see TMyOracleLog
+	TMyOracleLogLevel log_level = TMyOracleLogLevel::Info;
+
+	// Report written as JSON when not empty
+	std::string json_path;
+	// Enables TMyOracleMetrics, the phase timings are written there in the
+	// Prometheus text format when not empty
+	std::string metrics_path;
+
+	// Runs against TMyOracleSimDatabase loaded from sql_dir
+	bool simulated = false;
+	std::string sql_dir = "../SQL_Tables";
+	// Round trips of the simulated database taking a spike, see
+	// TMyOracleSimConfig
+	double spike_rate = 0.0;
+	// Round trips of the simulated database losing their session
+	// (ORA-03113)
+	double disconnect_rate = 0.0;
+
+	// Reads the command line, see Usage(). False with the error on a bad
+	// option or value.
+	bool Parse(int argc, const char* argv[], std::string& error);
+	static std::string Usage();
+};
+
+// Key source of one benchmark thread. The Zipf CDF is computed once and
+// shared, drawing a key is a binary search.
+class TMyOracleKeyGenerator
+{
+public:
+	TMyOracleKeyGenerator(const TMyOracleBenchmarkConfig& config, std::shared_ptr<const std::vector<double>> zipf_cdf, uint64_t seed);
+
+	static std::shared_ptr<const std::vector<double>> ZipfCdf(size_t keys, double theta);
+
+	int64_t Next();
+	std::vector<int64_t> Next(size_t count);
+
+	std::mt19937_64& Random() { return m_random; }
+
+private:
+	int64_t m_key_min;
+	int64_t m_key_max;
+	std::shared_ptr<const std::vector<double>> m_zipf_cdf;
+	std::mt19937_64 m_random;
+};
+
+// Results of one operation, or of all of them
+struct TMyOracleBenchmarkResult
+{
+	std::string name;
+	uint64_t errors = 0;
+	// Microseconds, successful operations only
+	TMyOracleHistogram latency;
+};
+
+struct TMyOracleBenchmarkReport
+{
+	double seconds = 0.0;
+	std::vector<TMyOracleBenchmarkResult> operations;
+	TMyOracleBenchmarkResult total;
+	// Time spent waiting for a pooled connection, in microseconds
+	TMyOracleHistogram acquire;
+	// Open loop only: operations that started later than scheduled because
+	// every thread was busy
+	uint64_t late_starts = 0;
+	// Memory of the client result sets freed during the measurement
+	TMyOracleAllocationStats allocations;
+
+	void Print(std::ostream& out) const;
+	bool WriteJson(const std::string& path, const TMyOracleBenchmarkConfig& config) const;
+};
+
+// Load generator over a SqlConnection.
+//
+// Every thread leases a connection per operation, picks the operation by
+// the mix weights and records its latency in a per-thread histogram; the
+// histograms are merged once the run is over so that recording costs no
+// synchronisation.
+class TMyOracleBenchmark
+{
+public:
+	// Runs one unit of work on a leased connection, false if it failed
+	using Operation = std::function<bool(TMyOracle* sql, TMyOracleKeyGenerator& keys)>;
+
+	explicit TMyOracleBenchmark(const TMyOracleBenchmarkConfig& config) : m_config(config) {}
+
+	void AddOperation(const std::string& name, Operation operation);
+
+	// False if the mix names an operation that was not added. When metrics
+	// are enabled they are reset once the warm-up is over.
+	bool Run(SqlConnection& pool, TMyOracleBenchmarkReport& report);
+
+private:
+	struct ThreadResult
+	{
+		std::vector<TMyOracleBenchmarkResult> operations;
+		TMyOracleHistogram acquire;
+		uint64_t late_starts = 0;
+	};
+
+	void Worker(SqlConnection& pool, size_t thread_index, std::chrono::steady_clock::time_point start, ThreadResult& result) const;
+
+	TMyOracleBenchmarkConfig m_config;
+	std::vector<std::pair<std::string, Operation>> m_operations;
+
+	// Set up by Run(): the operation and weight of every mix entry
+	std::vector<size_t> m_mix_operations;
+	std::vector<double> m_mix_weights;
+	std::shared_ptr<const std::vector<double>> m_zipf_cdf;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
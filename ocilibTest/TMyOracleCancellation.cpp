@@ -0,0 +1,197 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleCancellation.h"
+#include "TMyOracle.h"
+#include <algorithm>
+#include <thread>
+// -----------------------------------------------------------------------------
+void TMyOracleCancellationToken::Cancel()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_cancelled.exchange(true, std::memory_order_acq_rel))
+	{
+		return;
+	}
+
+	// The calls stay attached until they end, the watchdog breaks them
+	// until then
+	const auto now = std::chrono::steady_clock::now();
+	for (const TMyOracle* sql : m_calls)
+	{
+		TMyOracleInterrupt none = TMyOracleInterrupt::None;
+		sql->m_interrupt.compare_exchange_strong(none, TMyOracleInterrupt::Cancel, std::memory_order_relaxed);
+		TMyOracleWatchdog::Arm(sql, now);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCancellationToken::Attach(const TMyOracle* sql)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_cancelled.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+	m_calls.push_back(sql);
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleCancellationToken::Detach(const TMyOracle* sql)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = std::find(m_calls.begin(), m_calls.end(), sql);
+	if (it != m_calls.end())
+	{
+		m_calls.erase(it);
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleCallScope::TMyOracleCallScope(TMyOracle* sql, std::chrono::milliseconds timeout, TMyOracleCancellationToken* token)
+	: m_sql{ sql }
+{
+	// Not a call, nothing to arm
+	std::unique_lock<std::mutex> lock(m_sql->m_mutex, std::defer_lock);
+	if (!m_sql->IsThreadBound())
+	{
+		lock.lock();
+	}
+
+	m_previous_deadline = m_sql->m_scope_deadline;
+	m_previous_token = m_sql->m_scope_token;
+	if (timeout.count() > 0)
+	{
+		m_sql->m_scope_deadline = std::min(m_previous_deadline, std::chrono::steady_clock::now() + timeout);
+	}
+	if (token)
+	{
+		m_sql->m_scope_token = token;
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleCallScope::~TMyOracleCallScope()
+{
+	std::unique_lock<std::mutex> lock(m_sql->m_mutex, std::defer_lock);
+	if (!m_sql->IsThreadBound())
+	{
+		lock.lock();
+	}
+
+	m_sql->m_scope_deadline = m_previous_deadline;
+	m_sql->m_scope_token = m_previous_token;
+}
+// -----------------------------------------------------------------------------
+TMyOracleWatchdog& TMyOracleWatchdog::Instance()
+{
+	// Never destroyed and its thread never joined, so that the calls made
+	// late at exit still find it
+	static TMyOracleWatchdog* watchdog = new TMyOracleWatchdog();
+	return *watchdog;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Open(const TMyOracle* sql, std::chrono::steady_clock::time_point deadline)
+{
+	TMyOracleWatchdog& watchdog = Instance();
+	std::lock_guard<std::mutex> lock(watchdog.m_mutex);
+
+	sql->m_watch_open = true;
+	sql->m_watch_retry = std::chrono::milliseconds(0);
+	if (deadline != std::chrono::steady_clock::time_point::max())
+	{
+		watchdog.Insert(sql, deadline);
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Arm(const TMyOracle* sql, std::chrono::steady_clock::time_point when)
+{
+	TMyOracleWatchdog& watchdog = Instance();
+	std::lock_guard<std::mutex> lock(watchdog.m_mutex);
+
+	if (sql->m_watch_open)
+	{
+		watchdog.Erase(sql);
+		watchdog.Insert(sql, when);
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Close(const TMyOracle* sql)
+{
+	TMyOracleWatchdog& watchdog = Instance();
+	std::lock_guard<std::mutex> lock(watchdog.m_mutex);
+
+	watchdog.Erase(sql);
+	sql->m_watch_open = false;
+}
+// -----------------------------------------------------------------------------
+uint64_t TMyOracleWatchdog::Timeouts()
+{
+	return Instance().m_timeouts.load(std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Insert(const TMyOracle* sql, std::chrono::steady_clock::time_point when)
+{
+	if (!m_started)
+	{
+		m_started = true;
+		std::thread(&TMyOracleWatchdog::Run, this).detach();
+	}
+
+	auto it = m_calls.emplace(when, sql);
+	sql->m_watch_time = when;
+	sql->m_watched = true;
+	if (it == m_calls.begin())
+	{
+		m_wake.notify_one();
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Erase(const TMyOracle* sql)
+{
+	if (!sql->m_watched)
+	{
+		return;
+	}
+
+	auto range = m_calls.equal_range(sql->m_watch_time);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == sql)
+		{
+			m_calls.erase(it);
+			break;
+		}
+	}
+	sql->m_watched = false;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleWatchdog::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		if (m_calls.empty())
+		{
+			m_wake.wait(lock);
+			continue;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		auto first = m_calls.begin();
+		if (first->first > now)
+		{
+			m_wake.wait_until(lock, first->first);
+			continue;
+		}
+
+		// Still holding m_mutex: the call cannot end and free the
+		// connection under the break
+		const TMyOracle* sql = first->second;
+		m_calls.erase(first);
+		sql->m_watched = false;
+		if (sql->Interrupt(TMyOracleInterrupt::Timeout))
+		{
+			m_timeouts.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		sql->m_watch_retry = sql->m_watch_retry.count() == 0 ? FIRST_RETRY : std::min(sql->m_watch_retry * 2, LAST_RETRY);
+		Insert(sql, now + sql->m_watch_retry);
+	}
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,128 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLECANCELLATION_H__
+#define __TMYORACLECANCELLATION_H__
+// -----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+// -----------------------------------------------------------------------------
+class TMyOracle;
+// -----------------------------------------------------------------------------
+
+// Why the last call of a connection was interrupted
+enum class TMyOracleInterrupt
+{
+	None = 0,
+	Timeout = 1,	// its deadline passed
+	Cancel = 2		// its TMyOracleCancellationToken was cancelled
+};
+
+// Cancels calls from another thread. The calls made on a connection inside
+// a TMyOracleCallScope holding the token are interrupted by Cancel() and
+// fail with ORA-01013; later calls under the token are interrupted as soon
+// as they start. The token must outlive the calls using it.
+class TMyOracleCancellationToken
+{
+public:
+	TMyOracleCancellationToken() = default;
+
+	// Prevent copying
+	TMyOracleCancellationToken(const TMyOracleCancellationToken&) = delete;
+	TMyOracleCancellationToken& operator=(const TMyOracleCancellationToken&) = delete;
+
+	// Callable from any thread, once is enough
+	void Cancel();
+	bool IsCancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+
+private:
+	friend class TMyOracle;
+
+	// A call of sql starts or ends under the token. Attach() is false once
+	// the token is cancelled.
+	bool Attach(const TMyOracle* sql);
+	void Detach(const TMyOracle* sql);
+
+	std::atomic<bool> m_cancelled{ false };
+	std::mutex m_mutex;
+	// Connections in a call under the token
+	std::vector<const TMyOracle*> m_calls;
+};
+
+// Deadline and cancellation of the calls made on a connection while the
+// scope is open. The deadline is shared by all of them, timeout from the
+// construction of the scope: it bounds a request that takes several calls.
+// Past it, the call in progress is interrupted (driver Break) and fails with
+// ORA-01013. A zero timeout leaves the deadline to
+// TMyOracle::SetCallTimeout().
+//
+//	TMyOracleCallScope scope(sql, std::chrono::milliseconds(200), &token);
+//	std::unique_ptr<TMyOracleResultSet> rs(sql->ExecuteQuery(query, binds));
+//
+// Like TMyOracleTransaction the connection is not reserved: calls of other
+// threads on it during the scope are bound by it too. Scopes nest, the
+// destructor restores the previous deadline and token.
+class TMyOracleCallScope
+{
+public:
+	TMyOracleCallScope(TMyOracle* sql, std::chrono::milliseconds timeout, TMyOracleCancellationToken* token = nullptr);
+	~TMyOracleCallScope();
+
+	// Prevent copying
+	TMyOracleCallScope(const TMyOracleCallScope&) = delete;
+	TMyOracleCallScope& operator=(const TMyOracleCallScope&) = delete;
+
+private:
+	TMyOracle* m_sql;
+	std::chrono::steady_clock::time_point m_previous_deadline;
+	TMyOracleCancellationToken* m_previous_token;
+};
+
+// Interrupts the calls whose deadline passed, on a thread of its own started
+// with the first deadline. A call keeps being interrupted, at growing
+// intervals, until it returns: a Break() that lands between two round trips
+// of the call is lost.
+//
+// Every method takes one process wide mutex, which the watchdog holds while
+// it interrupts a call: once Close() returned for a connection, it is not
+// touched anymore.
+class TMyOracleWatchdog
+{
+public:
+	// A call starts on sql, interrupted at deadline unless it is max()
+	static void Open(const TMyOracle* sql, std::chrono::steady_clock::time_point deadline);
+	// Interrupts the call of sql at when instead. Does nothing once the call
+	// is closed.
+	static void Arm(const TMyOracle* sql, std::chrono::steady_clock::time_point when);
+	// The call of sql ends, or must not be interrupted anymore (its clean-up)
+	static void Close(const TMyOracle* sql);
+
+	// Calls interrupted by a deadline, process wide
+	static uint64_t Timeouts();
+
+private:
+	static TMyOracleWatchdog& Instance();
+	TMyOracleWatchdog() = default;
+
+	// The first interval between two interrupts of one call, doubled every
+	// time up to the last one
+	static constexpr std::chrono::milliseconds FIRST_RETRY{ 1 };
+	static constexpr std::chrono::milliseconds LAST_RETRY{ 100 };
+
+	void Run();
+	// The caller holds m_mutex
+	void Insert(const TMyOracle* sql, std::chrono::steady_clock::time_point when);
+	void Erase(const TMyOracle* sql);
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_started = false;
+	std::multimap<std::chrono::steady_clock::time_point, const TMyOracle*> m_calls;
+	std::atomic<uint64_t> m_timeouts{ 0 };
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,134 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleCursor.h"
+#include "TMyOracleLog.h"
+// -----------------------------------------------------------------------------
+TMyOracleCursor::TMyOracleCursor(TMyOracle* owner)
+	: m_owner{ owner }, m_timer{ &owner->m_metrics }
+{
+}
+// -----------------------------------------------------------------------------
+TMyOracleCursor::~TMyOracleCursor()
+{
+	// Free the statement before handing the connection back
+	m_stmt.reset();
+
+	if (m_timer.Enabled())
+	{
+		m_timer.AddRoundTrips(m_fetchRoundTrips);
+		m_timer.Flush();
+	}
+
+	m_lock.reset();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCursor::Fetch()
+{
+	if (m_eof)
+	{
+		return false;
+	}
+
+	if (m_stmt && m_stmt->Fetch())
+	{
+		if (m_rows % m_fetch_size == 0)
+		{
+			++m_fetchRoundTrips;
+		}
+		++m_rows;
+		return true;
+	}
+
+	if (m_stmt && m_stmt->FetchFailed())
+	{
+		m_timer.Fail();
+		TMYORACLE_LOG_ERROR("TMyOracleCursor::Fetch[", m_owner->GetConnInstanceCounter(), "]: ", m_owner->GetDriver()->GetLastError());
+	}
+
+	m_eof = true;
+	return false;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCursor::Next()
+{
+	m_row.Clear();
+
+	m_timer.Restart();
+	if (!Fetch())
+	{
+		m_timer.Lap(TMyOraclePhase::FETCH);
+		return false;
+	}
+	m_timer.Lap(TMyOraclePhase::FETCH);
+
+	m_row.AppendRow(*m_stmt);
+	if (m_timer.Enabled())
+	{
+		m_timer.Lap(TMyOraclePhase::CONVERT);
+		m_timer.AddRows(1, m_row.Bytes());
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCursor::NextView()
+{
+	m_row.Clear();
+
+	m_timer.Restart();
+	const bool fetched = Fetch();
+	m_timer.Lap(TMyOraclePhase::FETCH);
+	if (fetched && m_timer.Enabled())
+	{
+		m_timer.AddRows(1, 0);
+	}
+	return fetched;
+}
+// -----------------------------------------------------------------------------
+std::string_view TMyOracleCursor::GetView(size_t colIndex) const
+{
+	if (!m_stmt || m_eof || m_rows == 0 || colIndex >= m_row.Columns())
+	{
+		return {};
+	}
+
+	const unsigned int index = static_cast<unsigned int>(colIndex + 1);
+	if (m_stmt->IsNull(index))
+	{
+		return {};
+	}
+
+	size_t length = 0;
+	const char* text = m_stmt->GetString(index, length);
+	return text ? std::string_view(text, length) : std::string_view();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCursor::NextBatch(TMyOracleResultSet& batch, size_t max_rows)
+{
+	if (batch.Columns() != m_row.Columns())
+	{
+		batch.DescribeLike(m_row);
+	}
+	batch.Clear();
+
+	if (max_rows == 0)
+	{
+		max_rows = m_fetch_size;
+	}
+	batch.Reserve(max_rows);
+
+	m_timer.Restart();
+	while (batch.Rows() < max_rows && Fetch())
+	{
+		m_timer.Lap(TMyOraclePhase::FETCH);
+		batch.AppendRow(*m_stmt);
+		m_timer.Lap(TMyOraclePhase::CONVERT);
+	}
+	m_timer.Lap(TMyOraclePhase::FETCH);
+	if (m_timer.Enabled())
+	{
+		m_timer.AddRows(batch.Rows(), batch.Bytes());
+	}
+
+	batch.m_fetchRoundTrips = m_fetchRoundTrips;
+	return batch.Rows() > 0;
+}
+// -----------------------------------------------------------------------------
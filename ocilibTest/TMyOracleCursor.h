@@ -0,0 +1,92 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLECURSOR_H__
+#define __TMYORACLECURSOR_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include "TMyOracleResultSet.h"
+#include <optional>
+// -----------------------------------------------------------------------------
+
+// Forward-only cursor over a running query, see TMyOracle::OpenCursor().
+//
+// The cursor owns the driver statement and keeps the connection locked until
+// it is destroyed, so only one cursor can be open per TMyOracle and the
+// connection must not be used for anything else while it is alive. Memory is
+// bounded by the fetch array size: rows are read out of the driver fetch
+// buffer as they are consumed and nothing is kept once the cursor moved past
+// them.
+class TMyOracleCursor
+{
+	friend class TMyOracle;
+
+public:
+	~TMyOracleCursor();
+
+	// Prevent copying
+	TMyOracleCursor(const TMyOracleCursor&) = delete;
+	TMyOracleCursor& operator=(const TMyOracleCursor&) = delete;
+
+	// Moves to the next row, fetching the next batch from the server when
+	// the current one is consumed. Returns false at the end or on error.
+	bool Next();
+
+	// Moves to the next row without copying it: Row() and the accessors
+	// reading it are empty, the values are only read in place with
+	// GetView(). Returns false at the end or on error.
+	bool NextView();
+
+	// Replaces the content of batch with up to max_rows of the next rows.
+	// The batch buffers are reused from call to call. Returns false when no
+	// more rows are available.
+	bool NextBatch(TMyOracleResultSet& batch, size_t max_rows);
+
+	// Rows read so far
+	size_t Rows() const { return m_rows; }
+	size_t FetchRoundTrips() const { return m_fetchRoundTrips; }
+	bool Eof() const { return m_eof; }
+
+	size_t Columns() const { return m_row.Columns(); }
+	std::string GetColumnName(size_t index) const { return m_row.GetColumnName(index); }
+
+	// Values of the current row
+	const TMyOracleResultSet& Row() const { return m_row; }
+	std::string Get(size_t colIndex) const { return m_row.Get(colIndex); }
+	std::string Get(const std::string& field_name) const { return m_row.Get(field_name); }
+	bool IsNull(size_t colIndex) const { return m_row.IsNull(colIndex); }
+	int64_t GetInt64(size_t colIndex) const { return m_row.GetInt64(colIndex); }
+	double GetDouble(size_t colIndex) const { return m_row.GetDouble(colIndex); }
+	TMyOracleDate GetDate(size_t colIndex) const { return m_row.GetDate(colIndex); }
+
+	// Text of a column of the current row read straight from the driver
+	// fetch buffer, after Next() or NextView(). The view is only valid until
+	// the cursor moves or is destroyed: copy what must outlive the row. NULL
+	// reads as empty, typed columns as the text the driver formats.
+	std::string_view GetView(size_t colIndex) const;
+
+private:
+	explicit TMyOracleCursor(TMyOracle* owner);
+
+	// Positions the statement on the next row
+	bool Fetch();
+
+	TMyOracle* m_owner;
+	// The connection, locked from TMyOracle::OpenCursor() until destroyed
+	std::optional<TMyOracle::CallLock> m_lock;
+	// Set from the statement by TMyOracle::OpenCursor()
+	unsigned int m_fetch_size = 20;
+
+	std::unique_ptr<TMyOracleDriverStatement> m_stmt;
+
+	TMyOracleResultSet m_row;
+	size_t m_rows = 0;
+	size_t m_fetchRoundTrips = 0;
+	bool m_eof = false;
+
+	// Fetch and copy time of the rows, recorded when the cursor is destroyed.
+	// Time spent by the caller between rows is not charged.
+	TMyOracleQueryTimer m_timer;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,277 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleDirectPathLoader.h"
+#include "utils.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+// -----------------------------------------------------------------------------
+void TMyOracleDirectPathReport::Print(std::ostream& out) const
+{
+	out << "Direct path: " << loaded << " of " << rows << " row(s) in " << std::fixed << std::setprecision(3) << seconds << " s, "
+		<< arrays << " array(s) on " << streams << " stream(s), "
+		<< std::setprecision(0) << RowsPerSecond() << " rows/s, "
+		<< std::setprecision(1) << (seconds > 0.0 ? static_cast<double>(bytes) / seconds / (1024.0 * 1024.0) : 0.0) << " MiB/s";
+	if (rejected > 0)
+	{
+		out << ", " << rejected << " rejected";
+	}
+	out << std::defaultfloat << std::endl;
+
+	for (const auto& error : errors)
+	{
+		out << "  " << error << std::endl;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleDirectPathLoader::Stream(TMyOracle* sql, Shared& shared) const
+{
+	auto Error = [&shared](const std::string& error)
+	{
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		if (shared.report.errors.size() < TMyOracleDirectPathReport::MAX_ERRORS)
+		{
+			shared.report.errors.push_back(error);
+		}
+		// The other streams stop too
+		shared.done = true;
+	};
+
+	TMyOracleDriver* driver = sql ? sql->GetDriver() : nullptr;
+	if (!driver || !driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleDirectPathLoader::Stream: Not connected to database");
+		Error("not connected to database");
+		return false;
+	}
+
+	const unsigned int array_rows = m_config.array_rows > 0 ? m_config.array_rows : 1;
+	const size_t columns = m_config.columns.size();
+
+	TMyOracleQueryTimer setup(&sql->GetMetrics());
+	std::unique_ptr<TMyOracleDriverDirectPath> dp = driver->CreateDirectPath();
+	setup.Lap(TMyOraclePhase::CREATE);
+	if (!dp || !dp->Prepare(m_config.table, m_config.columns, array_rows, m_config.buffer_size, m_config.parallel > 1))
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleDirectPathLoader::Stream: Failed to prepare the load of ", m_config.table, ": ", driver->GetLastError());
+		Error(driver->GetLastError());
+		setup.Fail();
+		return false;
+	}
+	setup.Lap(TMyOraclePhase::PREPARE);
+	setup.AddRoundTrips(1);
+	setup.Flush();
+
+	// Strings are passed to the stream in place, numbers are written out in
+	// text. Both stay untouched until the array is loaded.
+	std::vector<std::vector<TMyOracleValue>> rows(array_rows);
+	std::vector<std::string> text(static_cast<size_t>(array_rows) * columns);
+	std::vector<size_t> rejected;
+	char number[32];
+
+	size_t stream_loaded = 0;
+	bool success = true;
+
+	while (success)
+	{
+		TMyOracleQueryTimer timer(&sql->GetMetrics());
+
+		size_t first = 0;
+		unsigned int count = 0;
+		{
+			std::lock_guard<std::mutex> lock(shared.mutex);
+			if (shared.done)
+			{
+				break;
+			}
+			first = shared.report.rows;
+			for (; count < array_rows; ++count)
+			{
+				rows[count].clear();
+				if (!shared.producer(rows[count]))
+				{
+					shared.done = true;
+					break;
+				}
+			}
+			shared.report.rows += count;
+		}
+		if (count == 0)
+		{
+			break;
+		}
+		// The producer's time is not the load's
+		timer.Restart();
+
+		size_t bytes = 0;
+		for (unsigned int row = 0; success && row < count; ++row)
+		{
+			if (rows[row].size() != columns)
+			{
+				Error("row " + std::to_string(first + row) + ": " + std::to_string(rows[row].size()) + " value(s), expected " + std::to_string(columns));
+				success = false;
+				break;
+			}
+
+			for (size_t column = 0; success && column < columns; ++column)
+			{
+				const TMyOracleValue& value = rows[row][column];
+				const char* data = nullptr;
+				size_t length = 0;
+				switch (value.index())
+				{
+				case 1:
+				case 2:
+				{
+					if (value.index() == 1)
+					{
+						std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(std::get<int64_t>(value)));
+					}
+					else
+					{
+						std::snprintf(number, sizeof(number), "%.17g", std::get<double>(value));
+					}
+					std::string& str = text[static_cast<size_t>(row) * columns + column];
+					str = number;
+					data = str.c_str();
+					length = str.size();
+					break;
+				}
+				case 3:
+					data = std::get<std::string>(value).c_str();
+					length = std::get<std::string>(value).size();
+					break;
+				default:
+					break;
+				}
+
+				bytes += length;
+				if (!dp->SetEntry(row, static_cast<unsigned int>(column), data, static_cast<unsigned int>(length)))
+				{
+					Error(driver->GetLastError());
+					success = false;
+				}
+			}
+		}
+		timer.Lap(TMyOraclePhase::CONVERT);
+
+		size_t loaded = 0;
+		rejected.clear();
+		const bool sent = success && dp->Load(count, loaded, rejected);
+		timer.Lap(TMyOraclePhase::EXECUTE);
+		timer.AddRoundTrips(1);
+		timer.AddRows(loaded, bytes);
+		stream_loaded += loaded;
+
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		++shared.report.arrays;
+		shared.report.loaded += loaded;
+		shared.report.bytes += bytes;
+		shared.report.rejected += rejected.size();
+		for (const size_t row : rejected)
+		{
+			if (shared.report.errors.size() < TMyOracleDirectPathReport::MAX_ERRORS)
+			{
+				shared.report.errors.push_back("row " + std::to_string(first + row) + ": not converted");
+			}
+		}
+
+		if (!sent)
+		{
+			if (success)
+			{
+				TMYORACLE_LOG_ERROR("TMyOracleDirectPathLoader::Stream: Failed to load into ", m_config.table, ": ", driver->GetLastError());
+				if (shared.report.errors.size() < TMyOracleDirectPathReport::MAX_ERRORS)
+				{
+					shared.report.errors.push_back(driver->GetLastError());
+				}
+				shared.done = true;
+			}
+			shared.report.rejected += count - std::min<size_t>(count, loaded + rejected.size());
+			timer.Fail();
+			success = false;
+		}
+	}
+
+	if (success)
+	{
+		TMyOracleQueryTimer timer(&sql->GetMetrics());
+		success = dp->Finish();
+		timer.Lap(TMyOraclePhase::COMMIT);
+		timer.AddRoundTrips(1);
+		if (!success)
+		{
+			TMYORACLE_LOG_ERROR("TMyOracleDirectPathLoader::Stream: Failed to save the load of ", m_config.table, ": ", driver->GetLastError());
+			Error(driver->GetLastError());
+			timer.Fail();
+		}
+	}
+	else
+	{
+		dp->Abort();
+	}
+
+	if (!success)
+	{
+		// Aborted, nothing this stream loaded is kept
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		shared.report.loaded -= stream_loaded;
+		shared.report.rejected += stream_loaded;
+	}
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleDirectPathLoader::Load(TMyOracle* sql, const TMyOracleRowProducer& producer, TMyOracleDirectPathReport& report)
+{
+	report = TMyOracleDirectPathReport();
+	report.streams = 1;
+
+	const auto start = std::chrono::steady_clock::now();
+	Shared shared(producer, report);
+	const bool success = Stream(sql, shared);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleDirectPathLoader::Load(SqlConnection& pool, const TMyOracleRowProducer& producer, TMyOracleDirectPathReport& report)
+{
+	report = TMyOracleDirectPathReport();
+	report.streams = m_config.parallel > 0 ? m_config.parallel : 1;
+
+	const auto start = std::chrono::steady_clock::now();
+	Shared shared(producer, report);
+
+	std::vector<char> results(report.streams, 0);
+	auto Run = [this, &pool, &shared, &results](size_t stream)
+	{
+		SqlConnectionLease sql = pool.Acquire();
+		if (!sql)
+		{
+			TMYORACLE_LOG_ERROR("TMyOracleDirectPathLoader::Load: No connection available for stream ", stream);
+			return;
+		}
+		results[stream] = Stream(sql.get(), shared);
+	};
+
+	if (report.streams == 1)
+	{
+		Run(0);
+	}
+	else
+	{
+		std::vector<std::thread> threads;
+		for (size_t stream = 0; stream < report.streams; ++stream)
+		{
+			threads.emplace_back(Run, stream);
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return std::all_of(results.begin(), results.end(), [](char result) { return result != 0; });
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEDIRECTPATHLOADER_H__
+#define __TMYORACLEDIRECTPATHLOADER_H__
+// -----------------------------------------------------------------------------
+#include "SqlConnection.h"
+#include "TMyOracle.h"
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Source of the rows of a direct path load: fills row with one value per
+// column and returns true, or returns false once there are no more rows.
+// The loader calls it from one thread at a time.
+using TMyOracleRowProducer = std::function<bool(std::vector<TMyOracleValue>& row)>;
+
+struct TMyOracleDirectPathConfig
+{
+	std::string table;
+	std::vector<TMyOracleDirectPathColumn> columns;
+
+	// Rows converted and sent together
+	unsigned int array_rows = 1000;
+	// Stream buffer sent per round trip, 0 for the OCI default (64 KiB)
+	unsigned int buffer_size = 0;
+	// Streams loading at the same time, each on its own connection. More
+	// than one needs a table the server can load in parallel (no enabled
+	// unique index).
+	size_t parallel = 1;
+};
+
+struct TMyOracleDirectPathReport
+{
+	// Rows handed out by the producer
+	size_t rows = 0;
+	size_t loaded = 0;
+	// Rows that did not convert, or were not sent because a stream failed
+	size_t rejected = 0;
+	size_t arrays = 0;
+	// Text of the values sent
+	size_t bytes = 0;
+	size_t streams = 0;
+	double seconds = 0.0;
+	// The first MAX_ERRORS errors, "row N: ..." with N counted from 0 in the
+	// order of the producer
+	std::vector<std::string> errors;
+
+	static constexpr size_t MAX_ERRORS = 10;
+
+	double RowsPerSecond() const { return seconds > 0.0 ? static_cast<double>(loaded) / seconds : 0.0; }
+	void Print(std::ostream& out) const;
+};
+
+// Bulk ingestion with OCI direct path (see TMyOracleDriverDirectPath): rows
+// are pulled from a producer, formatted into blocks on the client and written
+// straight into the table, bypassing the SQL engine, undo and most redo.
+// Arrays of rows are converted and sent as the producer fills them, so memory
+// stays bounded by array_rows whatever the size of the load.
+//
+// The loaded rows are saved when every stream finishes. A stream that fails
+// aborts its own rows, the streams that finished keep theirs.
+class TMyOracleDirectPathLoader
+{
+public:
+	explicit TMyOracleDirectPathLoader(const TMyOracleDirectPathConfig& config) : m_config(config) {}
+
+	// One stream on sql, which must not be used by anything else meanwhile
+	bool Load(TMyOracle* sql, const TMyOracleRowProducer& producer, TMyOracleDirectPathReport& report);
+
+	// config.parallel streams, each on a connection leased from pool
+	bool Load(SqlConnection& pool, const TMyOracleRowProducer& producer, TMyOracleDirectPathReport& report);
+
+private:
+	// State the streams of a load share
+	struct Shared
+	{
+		Shared(const TMyOracleRowProducer& rows, TMyOracleDirectPathReport& result) : producer(rows), report(result) {}
+
+		const TMyOracleRowProducer& producer;
+		TMyOracleDirectPathReport& report;
+		std::mutex mutex;
+		// Producer ran dry, or a stream failed and the others stop
+		bool done = false;
+	};
+
+	// Loads arrays until the producer runs dry, false if the stream failed
+	bool Stream(TMyOracle* sql, Shared& shared) const;
+
+	TMyOracleDirectPathConfig m_config;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,157 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleDriver.h"
+#include "TMyOracleSimDriver.h"
+#include "TMyOracleLog.h"
+#ifndef TMYORACLE_NO_OCI
+#include "TMyOracleOciDriver.h"
+#include "TMyOracleOciCxxDriver.h"
+#endif
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriver> TMyOracleDriver::Create(OCI_TYPE type)
+{
+	switch (type)
+	{
+#ifndef TMYORACLE_NO_OCI
+	case OCI_TYPE::OCI_C_API:
+		return std::make_unique<TMyOracleOciDriver>();
+	case OCI_TYPE::OCI_CXX_API:
+		return std::make_unique<TMyOracleOciCxxDriver>();
+#endif
+	case OCI_TYPE::OCI_SIMULATED:
+		return std::make_unique<TMyOracleSimDriver>();
+	default:
+		break;
+	}
+
+	TMYORACLE_LOG_FATAL("TMyOracleDriver::Create: Driver ", static_cast<int>(type), " is not available in this build");
+	return nullptr;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleDriver::SetLastError(const std::string& error)
+{
+	m_lst_error = error;
+	if (IsConnectionLost(error))
+	{
+		m_lost.store(true, std::memory_order_release);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleDriver::IsConnectionLost(const std::string& error)
+{
+	// The session is gone on the server, or the network link to it is
+	static const char* const codes[] =
+	{
+		"ORA-00028",	// your session has been killed
+		"ORA-01012",	// not logged on
+		"ORA-03113",	// end-of-file on communication channel
+		"ORA-03114",	// not connected to ORACLE
+		"ORA-03135",	// connection lost contact
+		"ORA-12537",	// TNS:connection closed
+		"ORA-12541"		// TNS:no listener
+	};
+	for (const char* code : codes)
+	{
+		if (error.find(code) != std::string::npos)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+// The simulated pool only needs db and min_sessions
+std::unique_ptr<TMyOracleDriverPool> TMyOracleDriver::CreatePool(OCI_TYPE type, const std::string& db, [[maybe_unused]] const std::string& user, [[maybe_unused]] const std::string& password,
+	unsigned int min_sessions, [[maybe_unused]] unsigned int max_sessions, [[maybe_unused]] unsigned int increment, [[maybe_unused]] unsigned int statement_cache_size)
+{
+	try
+	{
+		switch (type)
+		{
+#ifndef TMYORACLE_NO_OCI
+		case OCI_TYPE::OCI_C_API:
+		{
+			OCI_Pool* pool = OCI_PoolCreate(db.c_str(), user.c_str(), password.c_str(), OCI_POOL_SESSION, OCI_SESSION_DEFAULT, min_sessions, max_sessions, increment);
+			if (!pool)
+			{
+				TMYORACLE_LOG_FATAL("TMyOracleDriver::CreatePool: ", std::string(OCI_ErrorGetString(OCI_GetLastError())));
+				return nullptr;
+			}
+			OCI_PoolSetStatementCacheSize(pool, statement_cache_size);
+			return std::make_unique<TMyOracleOciPool>(pool);
+		}
+		case OCI_TYPE::OCI_CXX_API:
+		{
+			auto pool = std::make_unique<ocilib::Pool>(db, user, password, ocilib::Pool::SessionPool, min_sessions, max_sessions, increment);
+			pool->SetStatementCacheSize(statement_cache_size);
+			return std::make_unique<TMyOracleOciCxxPool>(std::move(pool));
+		}
+#endif
+		case OCI_TYPE::OCI_SIMULATED:
+			return TMyOracleSimPool::Create(db, min_sessions);
+		default:
+			TMYORACLE_LOG_FATAL("TMyOracleDriver::CreatePool: Driver ", static_cast<int>(type), " is not available in this build");
+			break;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleDriver::CreatePool: ", ex.what());
+	}
+	return nullptr;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleDriver::Initialize(OCI_TYPE type)
+{
+	try
+	{
+		switch (type)
+		{
+#ifndef TMYORACLE_NO_OCI
+		case OCI_TYPE::OCI_C_API:
+			// Initialize OCI C API
+			if (!OCI_Initialize(nullptr, nullptr, OCI_ENV_THREADED | OCI_ENV_CONTEXT))
+			{
+				return false;
+			}
+			OCI_EnableWarnings(true);
+			return true;
+		case OCI_TYPE::OCI_CXX_API:
+			ocilib::Environment::Initialize(ocilib::Environment::Default | ocilib::Environment::Threaded);
+			ocilib::Environment::EnableWarnings(true);
+			return true;
+#endif
+		default:
+			return true;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleDriver::Initialize: ", ex.what());
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleDriver::Cleanup(OCI_TYPE type)
+{
+	try
+	{
+		switch (type)
+		{
+#ifndef TMYORACLE_NO_OCI
+		case OCI_TYPE::OCI_C_API:
+			OCI_Cleanup();
+			break;
+		case OCI_TYPE::OCI_CXX_API:
+			ocilib::Environment::Cleanup();
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleDriver::Cleanup: ", ex.what());
+	}
+}
+// -----------------------------------------------------------------------------
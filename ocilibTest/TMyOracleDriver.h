@@ -0,0 +1,222 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEDRIVER_H__
+#define __TMYORACLEDRIVER_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleResultSet.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+enum class OCI_TYPE
+{
+	OCI_C_API = 1,
+	OCI_CXX_API = 2,
+	OCI_SIMULATED = 3	// in-process database, see TMyOracleSimDatabase
+};
+// -----------------------------------------------------------------------------
+class TMyOracleDriverStatement;
+class TMyOracleDriverDirectPath;
+// -----------------------------------------------------------------------------
+
+// Durability of a commit
+enum class TMyOracleCommitMode
+{
+	Wait = 1,	// returns once the redo is on disk (COMMIT WRITE WAIT)
+	NoWait = 2	// returns once the redo write is queued (COMMIT WRITE NOWAIT):
+				// an instance crash can lose the transaction
+};
+
+// A row of an array DML that failed, see TMyOracleDriverStatement::ExecuteArray()
+struct TMyOracleBatchError
+{
+	size_t row = 0;		// 0-based
+	int code = 0;		// ORA error number
+	std::string message;
+};
+
+// A column of a direct path load. Values are sent as text and converted by
+// the client, format is the date format of a DATE column.
+struct TMyOracleDirectPathColumn
+{
+	std::string name;
+	// Longest text of a value
+	unsigned int max_size = 64;
+	std::string format;
+};
+
+// Session pool of a driver, see TMyOracleDriver::CreatePool()
+class TMyOracleDriverPool
+{
+public:
+	virtual ~TMyOracleDriverPool() = default;
+};
+
+// One database session. TMyOracle, its cursors and prepared statements only
+// talk to the database through this interface; the OCILIB C and C++ APIs and
+// the simulated database are its implementations.
+//
+// Calls return false on failure with the error in GetLastError(), OCILIB
+// exceptions do not get past the driver.
+class TMyOracleDriver
+{
+public:
+	// nullptr when the type is not compiled in (TMYORACLE_NO_OCI)
+	static std::unique_ptr<TMyOracleDriver> Create(OCI_TYPE type);
+	static std::unique_ptr<TMyOracleDriverPool> CreatePool(OCI_TYPE type, const std::string& db, const std::string& user, const std::string& password,
+		unsigned int min_sessions, unsigned int max_sessions, unsigned int increment, unsigned int statement_cache_size);
+
+	// Process wide setup of the client library, once per Cleanup()
+	static bool Initialize(OCI_TYPE type);
+	static void Cleanup(OCI_TYPE type);
+
+	virtual ~TMyOracleDriver() = default;
+
+	virtual bool Connect(const std::string& user, const std::string& password, const std::string& db) = 0;
+	// Takes a session from a pool created by the same driver type
+	virtual bool Connect(TMyOracleDriverPool& pool) = 0;
+	// Closes the session or gives it back to its pool. False if there was none.
+	virtual bool Disconnect() = 0;
+	// Local check of the session handle and of IsLost(), no round trip
+	virtual bool IsConnected() const = 0;
+	// Round trip to the server
+	virtual bool Ping() = 0;
+
+	virtual bool Commit(TMyOracleCommitMode mode) = 0;
+	virtual bool Rollback() = 0;
+	// Interrupts the call in progress on this session, callable from any
+	// thread. It runs alongside that call, so it leaves GetLastError() and
+	// IsLost() alone: a failure is only returned, its reason in error.
+	virtual bool Break(std::string& error) = 0;
+
+	// Commit with every execute, TMyOracle turns it off and commits itself
+	virtual void SetAutoCommit(bool enabled) = 0;
+	virtual void SetStatementCacheSize(unsigned int size) = 0;
+
+	// nullptr if the session cannot create a statement
+	virtual std::unique_ptr<TMyOracleDriverStatement> CreateStatement() = 0;
+	// nullptr if the session cannot load in direct path
+	virtual std::unique_ptr<TMyOracleDriverDirectPath> CreateDirectPath() = 0;
+
+	const std::string& GetLastError() const { return m_lst_error; }
+	// An error saying the session is gone marks it lost
+	void SetLastError(const std::string& error);
+
+	// A call failed with an error saying the session or its network link is
+	// gone (ORA-03113, ORA-03114, ORA-12541, ...): the cached liveness of the
+	// session, read from any thread without a round trip. Cleared by Connect().
+	bool IsLost() const { return m_lost.load(std::memory_order_acquire); }
+	static bool IsConnectionLost(const std::string& error);
+
+protected:
+	void ClearLost() { m_lost.store(false, std::memory_order_release); }
+
+private:
+	std::string m_lst_error;
+	std::atomic<bool> m_lost{ false };
+};
+
+// A statement on a driver session. The session must outlive it.
+//
+// Column indexes are 1-based like OCILIB. Fetched values are only valid until
+// the next Fetch().
+class TMyOracleDriverStatement
+{
+public:
+	virtual ~TMyOracleDriverStatement() = default;
+
+	// Rows per fetch round trip and rows prefetched with the execute, 0 keeps
+	// the driver default
+	virtual void SetFetchSize(unsigned int rows) = 0;
+	virtual void SetPrefetchSize(unsigned int rows) = 0;
+	virtual unsigned int GetFetchSize() const = 0;
+	// Binds go to :1, :2, ... by position instead of by name
+	virtual void SetBindByPosition() = 0;
+
+	virtual bool Prepare(const std::string& sql) = 0;
+
+	// The statement reads the bound variables on every Execute(), they must
+	// stay in place until the statement is freed
+	virtual bool BindInt64(const std::string& name, int64_t* value) = 0;
+	virtual bool BindDouble(const std::string& name, double* value) = 0;
+	virtual bool BindString(const std::string& name, std::string* value, unsigned int capacity) = 0;
+	virtual void SetBindNull(const std::string& name, bool is_null) = 0;
+
+	virtual bool Execute() = 0;
+
+	// Array DML. SetBindArraySize() goes before the array binds, every bound
+	// array then holds size values and ExecuteArray(rows) runs the statement
+	// for the first rows of them in one round trip. Rows that fail do not
+	// stop the others (batch error mode), they are listed by GetBatchErrors().
+	// A string array is size values of length + 1 chars, NUL terminated.
+	virtual bool SetBindArraySize(unsigned int size) = 0;
+	virtual bool BindInt64Array(const std::string& name, int64_t* values) = 0;
+	virtual bool BindDoubleArray(const std::string& name, double* values) = 0;
+	virtual bool BindStringArray(const std::string& name, char* values, unsigned int length) = 0;
+	// row is 0-based
+	virtual void SetBindNullAt(const std::string& name, unsigned int row, bool is_null) = 0;
+	// False when the statement failed as a whole rather than row by row
+	virtual bool ExecuteArray(unsigned int rows) = 0;
+	const std::vector<TMyOracleBatchError>& GetBatchErrors() const { return m_batch_errors; }
+
+	virtual std::string GetSql() const = 0;
+	// Rows changed by a DML statement
+	virtual unsigned int GetAffectedRows() const = 0;
+
+	// Result of a query, 0 columns when the statement returned none
+	virtual unsigned int GetColumnCount() const = 0;
+	virtual std::string GetColumnName(unsigned int index) const = 0;
+	virtual TMyOracleColumnType GetColumnType(unsigned int index) const = 0;
+
+	// Moves to the next row, false at the end of the rows or on error
+	virtual bool Fetch() = 0;
+	// The last Fetch() stopped on an error rather than at the end of the rows
+	bool FetchFailed() const { return m_fetch_failed; }
+	virtual bool IsNull(unsigned int index) = 0;
+	virtual int64_t GetInt64(unsigned int index) = 0;
+	virtual double GetDouble(unsigned int index) = 0;
+	virtual TMyOracleDate GetDate(unsigned int index) = 0;
+	// length chars, not necessarily NUL terminated. For a string column the
+	// text may be the fetch buffer itself, valid until the next Fetch().
+	virtual const char* GetString(unsigned int index, size_t& length) = 0;
+
+protected:
+	bool m_fetch_failed = false;
+	std::vector<TMyOracleBatchError> m_batch_errors;
+};
+
+// A direct path load stream on a driver session (OCI_DirPath). Rows are
+// formatted into data blocks on the client and written above the high water
+// mark of the table: no SQL engine, no undo. The session must outlive it and
+// is busy with the load until Finish() or Abort().
+//
+// Rows are set an array at a time, 0-based, then sent with Load(). The
+// server does not check unique constraints during the load, a violation
+// leaves the index unusable.
+class TMyOracleDriverDirectPath
+{
+public:
+	virtual ~TMyOracleDriverDirectPath() = default;
+
+	// rows per array. buffer_size is the size of the stream sent per round
+	// trip, 0 keeps the default (64 KiB). parallel allows other streams to
+	// load the same table at the same time.
+	virtual bool Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel) = 0;
+
+	// value is not copied and must stay valid until Load(), nullptr for NULL
+	virtual bool SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length) = 0;
+
+	// Converts and sends the first rows of the array, then clears it. Rows
+	// that do not convert are skipped and listed in rejected. False if the
+	// stream failed, the load must then be aborted.
+	virtual bool Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected) = 0;
+
+	// Saves the loaded rows. Without it the destructor aborts the load.
+	virtual bool Finish() = 0;
+	virtual void Abort() = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
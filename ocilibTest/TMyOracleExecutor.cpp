@@ -0,0 +1,270 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleExecutor.h"
+#include "TMyOracleCancellation.h"
+#include "TMyOracleLog.h"
+// -----------------------------------------------------------------------------
+TMyOracleExecutor::TMyOracleExecutor(SqlConnection* pool, size_t threads)
+	: m_pool{ pool }
+{
+	if (threads == 0)
+	{
+		threads = m_pool ? m_pool->MaxConnections() : 1;
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_workers.emplace_back(&TMyOracleExecutor::Worker, this);
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleExecutor::~TMyOracleExecutor()
+{
+	Stop();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleExecutor::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_cv.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleExecutor::Submit(Work work, Completion onComplete)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_stopping)
+		{
+			return false;
+		}
+		m_queue.push_back({ std::move(work), std::move(onComplete) });
+	}
+	m_cv.notify_one();
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleExecutor::ExecuteQueryAsync(const std::string& query, const TMyOracleBinds& binds, Completion onComplete)
+{
+	auto work = [query, binds](TMyOracle* sql) -> TMyOracleResultSet*
+	{
+		return sql->ExecuteQuery(query, binds);
+	};
+
+	if (!Submit(work, onComplete) && onComplete)
+	{
+		onComplete(nullptr, "Executor is stopped");
+	}
+}
+// -----------------------------------------------------------------------------
+std::future<TMyOracleAsyncResult> TMyOracleExecutor::ExecuteQueryAsync(const std::string& query, const TMyOracleBinds& binds)
+{
+	auto promise = std::make_shared<std::promise<TMyOracleAsyncResult>>();
+	auto future = promise->get_future();
+
+	ExecuteQueryAsync(query, binds, [promise](std::unique_ptr<TMyOracleResultSet> result, const std::string& error)
+	{
+		promise->set_value({ std::move(result), error });
+	});
+
+	return future;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleResultSet> TMyOracleExecutor::ExecuteHedgedQuery(const std::string& query, const TMyOracleBinds& binds,
+	std::chrono::microseconds hedge_delay, std::string* error)
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Shared with the runs, which may end after the caller returned
+	struct Hedge
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		TMyOracleCancellationToken tokens[2];
+		Clock::time_point starts[2];
+		size_t runs = 0;
+		size_t failed = 0;
+		int winner = -1;
+		std::unique_ptr<TMyOracleResultSet> result;
+		std::string error;
+	};
+	auto hedge = std::make_shared<Hedge>();
+
+	auto run = [this, hedge, query, binds](size_t index)
+	{
+		auto work = [hedge, query, binds, index](TMyOracle* sql) -> TMyOracleResultSet*
+		{
+			// The other run answered while this one was queued
+			if (hedge->tokens[index].IsCancelled())
+			{
+				return nullptr;
+			}
+			hedge->starts[index] = Clock::now();
+			TMyOracleCallScope scope(sql, std::chrono::milliseconds(0), &hedge->tokens[index]);
+			return sql->ExecuteQuery(query, binds);
+		};
+
+		auto onComplete = [this, hedge, index](std::unique_ptr<TMyOracleResultSet> result, const std::string& run_error)
+		{
+			std::lock_guard<std::mutex> lock(hedge->mutex);
+			if (result && hedge->winner < 0)
+			{
+				hedge->winner = static_cast<int>(index);
+				hedge->result = std::move(result);
+				hedge->tokens[1 - index].Cancel();
+				RecordHedgeLatency(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - hedge->starts[index]));
+			}
+			else if (!result)
+			{
+				++hedge->failed;
+				if (hedge->error.empty() || index == 0)
+				{
+					hedge->error = run_error.empty() ? std::string("Cancelled") : run_error;
+				}
+			}
+			hedge->done.notify_all();
+		};
+
+		{
+			std::lock_guard<std::mutex> lock(hedge->mutex);
+			++hedge->runs;
+		}
+		if (!Submit(work, onComplete))
+		{
+			onComplete(nullptr, "Executor is stopped");
+		}
+	};
+
+	m_hedge_queries.fetch_add(1, std::memory_order_relaxed);
+	if (hedge_delay.count() == 0)
+	{
+		hedge_delay = HedgeDelay();
+	}
+
+	run(0);
+
+	std::unique_lock<std::mutex> lock(hedge->mutex);
+	auto answered = [&hedge]() { return hedge->winner >= 0 || hedge->failed == hedge->runs; };
+	if (hedge_delay != std::chrono::microseconds::max() && m_workers.size() > 1
+		&& !hedge->done.wait_for(lock, hedge_delay, answered))
+	{
+		lock.unlock();
+		m_hedges.fetch_add(1, std::memory_order_relaxed);
+		run(1);
+		lock.lock();
+	}
+	hedge->done.wait(lock, answered);
+
+	if (!hedge->result)
+	{
+		if (error)
+		{
+			*error = hedge->error;
+		}
+		return nullptr;
+	}
+	if (hedge->winner == 1)
+	{
+		m_hedge_wins.fetch_add(1, std::memory_order_relaxed);
+	}
+	return std::move(hedge->result);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleExecutor::RecordHedgeLatency(std::chrono::microseconds latency)
+{
+	std::lock_guard<std::mutex> lock(m_hedge_mutex);
+	m_hedge_latency.Record(latency.count());
+
+	const uint64_t count = m_hedge_latency.Count();
+	if (count % HEDGE_UPDATE == 0)
+	{
+		m_hedge_delay_us.store(m_hedge_latency.ValueAtPercentile(HEDGE_PERCENTILE), std::memory_order_relaxed);
+	}
+	if (count >= HEDGE_WINDOW)
+	{
+		m_hedge_latency.Reset();
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleHedgeStats TMyOracleExecutor::GetHedgeStats() const
+{
+	TMyOracleHedgeStats stats;
+	stats.queries = m_hedge_queries.load(std::memory_order_relaxed);
+	stats.hedges = m_hedges.load(std::memory_order_relaxed);
+	stats.hedge_wins = m_hedge_wins.load(std::memory_order_relaxed);
+	stats.delay = HedgeDelay();
+	return stats;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleExecutor::Worker()
+{
+	SqlConnectionLease sql;
+
+	while (true)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+
+			if (m_queue.empty())
+			{
+				// Stopping and drained
+				break;
+			}
+
+			task = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+
+		// The worker keeps its connection between tasks. A lost one goes back
+		// to the pool, whose Acquire() reconnects or replaces it.
+		if (sql && !sql->IsConnected())
+		{
+			sql.Release();
+		}
+		if (!sql)
+		{
+			sql = m_pool->Acquire();
+		}
+
+		std::unique_ptr<TMyOracleResultSet> result;
+		std::string error;
+
+		if (!sql)
+		{
+			error = "No connection available";
+		}
+		else
+		{
+			try
+			{
+				result.reset(task.work(sql.get()));
+				if (!result)
+				{
+					error = sql->GetLastError();
+				}
+			}
+			catch (const std::exception& ex)
+			{
+				error = ex.what();
+				TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleExecutor::Worker: ", ex.what());
+			}
+		}
+
+		if (task.onComplete)
+		{
+			task.onComplete(std::move(result), error);
+		}
+	}
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,128 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEEXECUTOR_H__
+#define __TMYORACLEEXECUTOR_H__
+// -----------------------------------------------------------------------------
+#include "SqlConnection.h"
+#include "TMyOracleHistogram.h"
+#include "TMyOracleResultSet.h"
+#include <deque>
+#include <future>
+// -----------------------------------------------------------------------------
+
+// Counters of TMyOracleExecutor::ExecuteHedgedQuery()
+struct TMyOracleHedgeStats
+{
+	uint64_t queries = 0;
+	// Queries that were run a second time, and those the second run answered
+	uint64_t hedges = 0;
+	uint64_t hedge_wins = 0;
+	// Current delay before the second run, max() until enough latencies
+	// were seen
+	std::chrono::microseconds delay{ std::chrono::microseconds::max() };
+};
+
+// Result of TMyOracleExecutor::ExecuteQueryAsync(), error is set when result
+// is nullptr
+struct TMyOracleAsyncResult
+{
+	std::unique_ptr<TMyOracleResultSet> result;
+	std::string error;
+};
+
+// Runs queries asynchronously on the connections of a SqlConnection.
+//
+// Each worker thread keeps one leased connection, so up to
+// `threads` queries are in flight at once and callers never block on a
+// round trip. A worker gives back a connection found lost (see
+// TMyOracle::IsConnected()) and leases another before its next task.
+// Completions run on the worker thread that executed the query and should
+// be short. The destructor finishes the queued work first.
+class TMyOracleExecutor
+{
+public:
+	// Work to run on a leased connection, returns the result or nullptr
+	using Work = std::function<TMyOracleResultSet*(TMyOracle*)>;
+	// Called with the result, or with nullptr and the error
+	using Completion = std::function<void(std::unique_ptr<TMyOracleResultSet> result, const std::string& error)>;
+
+	// threads defaults to the number of connections the pool can open
+	explicit TMyOracleExecutor(SqlConnection* pool, size_t threads = 0);
+	virtual ~TMyOracleExecutor();
+
+	// Prevent copying
+	TMyOracleExecutor(const TMyOracleExecutor&) = delete;
+	TMyOracleExecutor& operator=(const TMyOracleExecutor&) = delete;
+
+	std::future<TMyOracleAsyncResult> ExecuteQueryAsync(const std::string& query, const TMyOracleBinds& binds = {});
+	void ExecuteQueryAsync(const std::string& query, const TMyOracleBinds& binds, Completion onComplete);
+
+	// Queues any work; returns false once the executor is stopping
+	bool Submit(Work work, Completion onComplete);
+
+	// Hedged read, for idempotent queries only. Runs the query on a worker
+	// and waits for it; when no answer came within hedge_delay, runs it
+	// again on a second worker, and so on a second pool connection. The
+	// first answer is returned and the other run is cancelled. A failure of
+	// the first run before the delay is returned as is.
+	//
+	// A zero hedge_delay uses the 95th percentile of the latencies of the
+	// previous hedged reads, so that about one read in twenty is run twice;
+	// nothing is hedged until enough of them were seen. Blocks the calling
+	// thread, which must not be a worker of the executor. nullptr on
+	// failure, with the error in error if given.
+	std::unique_ptr<TMyOracleResultSet> ExecuteHedgedQuery(const std::string& query, const TMyOracleBinds& binds = {},
+		std::chrono::microseconds hedge_delay = std::chrono::microseconds(0), std::string* error = nullptr);
+
+	TMyOracleHedgeStats GetHedgeStats() const;
+
+	// Runs the queued work and joins the workers
+	void Stop();
+
+	size_t Pending() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size();
+	}
+	size_t Threads() const { return m_workers.size(); }
+
+private:
+	struct Task
+	{
+		Work work;
+		Completion onComplete;
+	};
+
+	void Worker();
+
+	// Latencies of the hedged reads, which give their default delay
+	void RecordHedgeLatency(std::chrono::microseconds latency);
+	std::chrono::microseconds HedgeDelay() const
+	{
+		return std::chrono::microseconds(m_hedge_delay_us.load(std::memory_order_relaxed));
+	}
+
+	// The delay is recomputed every HEDGE_UPDATE latencies, and the
+	// histogram started over after HEDGE_WINDOW so that it follows the load
+	static constexpr uint64_t HEDGE_UPDATE = 256;
+	static constexpr uint64_t HEDGE_WINDOW = 16384;
+	static constexpr double HEDGE_PERCENTILE = 95.0;
+
+	SqlConnection* m_pool;
+	std::vector<std::thread> m_workers;
+
+	std::deque<Task> m_queue;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cv;
+	bool m_stopping = false;
+
+	TMyOracleHistogram m_hedge_latency;
+	std::mutex m_hedge_mutex;
+	std::atomic<int64_t> m_hedge_delay_us{ std::chrono::microseconds::max().count() };
+	std::atomic<uint64_t> m_hedge_queries{ 0 };
+	std::atomic<uint64_t> m_hedges{ 0 };
+	std::atomic<uint64_t> m_hedge_wins{ 0 };
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,62 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleHistogram.h"
+#include <cmath>
+// -----------------------------------------------------------------------------
+void TMyOracleHistogram::Record(int64_t value, uint64_t count)
+{
+	if (value < 0)
+	{
+		value = 0;
+	}
+
+	m_counts[BucketIndex(value)] += count;
+	m_count += count;
+	m_sum += value * static_cast<int64_t>(count);
+	m_min = std::min(m_min, value);
+	m_max = std::max(m_max, value);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleHistogram::Merge(const TMyOracleHistogram& other)
+{
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		m_counts[i] += other.m_counts[i];
+	}
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	m_min = std::min(m_min, other.m_min);
+	m_max = std::max(m_max, other.m_max);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleHistogram::Reset()
+{
+	std::fill(m_counts.begin(), m_counts.end(), 0);
+	m_count = 0;
+	m_sum = 0;
+	m_min = INT64_MAX;
+	m_max = 0;
+}
+// -----------------------------------------------------------------------------
+int64_t TMyOracleHistogram::ValueAtPercentile(double percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0;
+	}
+
+	percentile = std::clamp(percentile, 0.0, 100.0);
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(m_count))));
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		seen += m_counts[i];
+		if (seen >= rank)
+		{
+			// The bucket bound can overshoot the largest value recorded
+			return std::min(BucketValue(i), m_max);
+		}
+	}
+	return m_max;
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEHISTOGRAM_H__
+#define __TMYORACLEHISTOGRAM_H__
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Log-linear bucket layout: values below 2^SubBucketBits get a bucket each,
+// every power of two above is split into 2^(SubBucketBits - 1) equal
+// buckets. Values of 2^MaxExponent and more are clamped into the last one.
+template<unsigned int SubBucketBits, unsigned int MaxExponent>
+struct TMyOracleLogLinearBuckets
+{
+	static_assert(SubBucketBits >= 2 && MaxExponent > SubBucketBits && MaxExponent < 63, "bucket layout");
+
+	static constexpr int64_t SUB_BUCKETS = int64_t(1) << SubBucketBits;
+	static constexpr size_t COUNT = SUB_BUCKETS + (MaxExponent - SubBucketBits) * (SUB_BUCKETS / 2);
+
+	static size_t Index(int64_t value)
+	{
+		if (value < SUB_BUCKETS)
+		{
+			return value > 0 ? static_cast<size_t>(value) : 0;
+		}
+
+		const uint64_t v = static_cast<uint64_t>(std::min(value, (int64_t(1) << MaxExponent) - 1));
+
+		// v has its top bit at exponent >= SubBucketBits; keep the next
+		// SubBucketBits - 1 bits below it
+		const unsigned int exponent = 63 - static_cast<unsigned int>(std::countl_zero(v));
+		const unsigned int shift = exponent - SubBucketBits + 1;
+		const size_t top = static_cast<size_t>(v >> shift);
+		return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2) + (top - SUB_BUCKETS / 2);
+	}
+
+	// Highest value that lands in a bucket
+	static int64_t Value(size_t index)
+	{
+		if (index < static_cast<size_t>(SUB_BUCKETS))
+		{
+			return static_cast<int64_t>(index);
+		}
+
+		const size_t offset = index - SUB_BUCKETS;
+		const unsigned int shift = static_cast<unsigned int>(offset / (SUB_BUCKETS / 2)) + 1;
+		const int64_t top = static_cast<int64_t>(offset % (SUB_BUCKETS / 2)) + SUB_BUCKETS / 2;
+		return ((top + 1) << shift) - 1;
+	}
+};
+
+// Log-linear histogram of non-negative values, HDR style: every power of two
+// range is split into 512 equal buckets, so any recorded value is known
+// within 0.2% whatever its magnitude. Values up to 2^40 are tracked (about
+// 12 days in microseconds), larger ones are clamped.
+//
+// Not thread-safe: record into one histogram per thread and Merge().
+class TMyOracleHistogram
+{
+public:
+	using Buckets = TMyOracleLogLinearBuckets<10, 40>;
+	static constexpr size_t BUCKETS = Buckets::COUNT;
+
+	// Bucket of a value, and the highest value that lands in a bucket
+	static size_t BucketIndex(int64_t value) { return Buckets::Index(value); }
+	static int64_t BucketValue(size_t index) { return Buckets::Value(index); }
+
+	TMyOracleHistogram() : m_counts(BUCKETS, 0) {}
+
+	void Record(int64_t value, uint64_t count = 1);
+	void Merge(const TMyOracleHistogram& other);
+	void Reset();
+
+	uint64_t Count() const { return m_count; }
+	int64_t Min() const { return m_count ? m_min : 0; }
+	int64_t Max() const { return m_max; }
+	double Mean() const { return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0; }
+
+	// Smallest recorded value (to the bucket precision) that percentile % of
+	// the values are at or below, 0 when empty
+	int64_t ValueAtPercentile(double percentile) const;
+
+private:
+	std::vector<uint64_t> m_counts;
+	uint64_t m_count = 0;
+	int64_t m_min = INT64_MAX;
+	int64_t m_max = 0;
+	int64_t m_sum = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
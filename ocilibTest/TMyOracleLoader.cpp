@@ -0,0 +1,479 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleLoader.h"
+#include "utils.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+// -----------------------------------------------------------------------------
+static std::string Trim(const std::string& text)
+{
+	size_t start = 0;
+	size_t end = text.size();
+	while (start < end && std::isspace(static_cast<unsigned char>(text[start])))
+	{
+		++start;
+	}
+	while (end > start && std::isspace(static_cast<unsigned char>(text[end - 1])))
+	{
+		--end;
+	}
+	return text.substr(start, end - start);
+}
+// -----------------------------------------------------------------------------
+// Splits a VALUES list at the commas outside of 'literals' and parentheses
+static std::vector<std::string> SplitValues(const std::string& text)
+{
+	std::vector<std::string> values;
+	std::string value;
+	bool quoted = false;
+	int depth = 0;
+
+	for (const char c : text)
+	{
+		if (c == '\'')
+		{
+			quoted = !quoted;
+		}
+		else if (!quoted && c == '(')
+		{
+			++depth;
+		}
+		else if (!quoted && c == ')')
+		{
+			--depth;
+		}
+		else if (!quoted && depth == 0 && c == ',')
+		{
+			values.push_back(Trim(value));
+			value.clear();
+			continue;
+		}
+		value += c;
+	}
+	values.push_back(Trim(value));
+	return values;
+}
+// -----------------------------------------------------------------------------
+// 'it''s' -> it's, false if text is not a single string literal
+static bool Unquote(const std::string& text, std::string& value)
+{
+	if (text.size() < 2 || text.front() != '\'' || text.back() != '\'')
+	{
+		return false;
+	}
+
+	value.clear();
+	for (size_t i = 1; i + 1 < text.size(); ++i)
+	{
+		if (text[i] == '\'')
+		{
+			if (text[i + 1] != '\'' || i + 2 == text.size())
+			{
+				return false;
+			}
+			++i;
+		}
+		value += text[i];
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+// Integer or decimal number, the whole text
+static bool ParseNumber(const std::string& text, TMyOracleValue& value)
+{
+	if (text.empty())
+	{
+		return false;
+	}
+
+	char* end = nullptr;
+	errno = 0;
+	const long long number = std::strtoll(text.c_str(), &end, 10);
+	if (*end == '\0' && errno == 0)
+	{
+		value = static_cast<int64_t>(number);
+		return true;
+	}
+
+	const double real = std::strtod(text.c_str(), &end);
+	if (*end == '\0' && std::isdigit(static_cast<unsigned char>(text.back())))
+	{
+		value = real;
+		return true;
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+// A literal of an exported INSERT. Numbers, strings and NULL become the bind
+// :position, to_date('text', 'format') becomes TO_DATE(:position, 'format')
+// with the text bound. Anything else stays in the SQL as written, sql gets
+// what goes in the VALUES list.
+static bool ParseLiteral(const std::string& text, size_t position, TMyOracleBinds& binds, std::string& sql)
+{
+	const std::string bind = ":" + std::to_string(position);
+	std::string str;
+
+	if (std::to_upper(text) == "NULL")
+	{
+		binds.emplace_back(nullptr);
+		sql = bind;
+		return true;
+	}
+
+	if (Unquote(text, str))
+	{
+		binds.emplace_back(str);
+		sql = bind;
+		return true;
+	}
+
+	TMyOracleValue number;
+	if (ParseNumber(text, number))
+	{
+		binds.emplace_back(nullptr);
+		binds.back().value = number;
+		sql = bind;
+		return true;
+	}
+
+	if (text.size() > 9 && std::to_upper(text.substr(0, 8)) == "TO_DATE(" && text.back() == ')')
+	{
+		const std::vector<std::string> args = SplitValues(text.substr(8, text.size() - 9));
+		std::string format;
+		if (args.size() == 2 && Unquote(args[0], str) && Unquote(args[1], format))
+		{
+			binds.emplace_back(str);
+			sql = "TO_DATE(" + bind + ", " + args[1] + ")";
+			return true;
+		}
+	}
+
+	sql = text;
+	return false;
+}
+// -----------------------------------------------------------------------------
+// Fields of a CSV line, quoted tells which were in quotes
+static std::vector<std::string> SplitCsv(const std::string& line, std::vector<bool>& quoted)
+{
+	std::vector<std::string> fields(1);
+	quoted.assign(1, false);
+	bool in_quotes = false;
+
+	for (size_t i = 0; i < line.size(); ++i)
+	{
+		const char c = line[i];
+		if (in_quotes)
+		{
+			if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+			{
+				fields.back() += '"';
+				++i;
+			}
+			else if (c == '"')
+			{
+				in_quotes = false;
+			}
+			else
+			{
+				fields.back() += c;
+			}
+		}
+		else if (c == '"')
+		{
+			in_quotes = true;
+			quoted.back() = true;
+		}
+		else if (c == ',')
+		{
+			fields.emplace_back();
+			quoted.push_back(false);
+		}
+		else
+		{
+			fields.back() += c;
+		}
+	}
+
+	for (size_t i = 0; i < fields.size(); ++i)
+	{
+		if (!quoted[i])
+		{
+			fields[i] = Trim(fields[i]);
+		}
+	}
+	return fields;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCsvReader::Open(const std::string& path)
+{
+	m_file.open(path);
+	if (!m_file)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleCsvReader::Open: Cannot open ", path);
+		return false;
+	}
+
+	std::string line;
+	if (!std::getline(m_file, line))
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleCsvReader::Open: ", path, " has no header line");
+		return false;
+	}
+	m_line = 1;
+	if (!line.empty() && line.back() == '\r')
+	{
+		line.pop_back();
+	}
+
+	std::vector<bool> quoted;
+	m_columns = SplitCsv(line, quoted);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleCsvReader::Next(std::vector<std::string>& fields, std::vector<bool>& quoted)
+{
+	std::string line;
+	while (std::getline(m_file, line))
+	{
+		++m_line;
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (!Trim(line).empty())
+		{
+			fields = SplitCsv(line, quoted);
+			return true;
+		}
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleLoadReport::AddError(size_t line, const std::string& error)
+{
+	if (errors.size() < MAX_ERRORS)
+	{
+		errors.push_back("line " + std::to_string(line) + ": " + error);
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleLoadReport::Print(std::ostream& out, const std::string& path) const
+{
+	out << "Loaded " << inserted << " of " << rows << " row(s) from " << path
+		<< " in " << std::fixed << std::setprecision(3) << seconds << " s, "
+		<< round_trips << " round trip(s)";
+	if (seconds > 0.0)
+	{
+		out << ", " << std::setprecision(0) << static_cast<double>(inserted) / seconds << " rows/s";
+	}
+	if (failed > 0)
+	{
+		out << ", " << failed << " failed";
+	}
+	out << std::endl;
+
+	for (const auto& error : errors)
+	{
+		out << "  " << error << std::endl;
+	}
+	if (failed > errors.size())
+	{
+		out << "  ..." << std::endl;
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleLoader::TMyOracleLoader(TMyOracle* sql, size_t array_size)
+	: m_sql(sql), m_array_size(array_size)
+{
+	if (m_array_size == 0 && m_sql)
+	{
+		m_array_size = m_sql->GetArraySize();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleLoader::Flush(Batch& batch, TMyOracleLoadReport& report)
+{
+	if (batch.rows.empty())
+	{
+		return true;
+	}
+
+	TMyOracleArrayResult result;
+	const bool success = m_sql->ExecuteArray(batch.sql, batch.rows, result, m_array_size);
+
+	report.inserted += result.affected;
+	report.round_trips += result.round_trips;
+	report.failed += result.errors.size();
+	for (const auto& error : result.errors)
+	{
+		report.AddError(batch.lines[error.row], error.message);
+	}
+
+	if (!success)
+	{
+		// The rows after the failed round trip were not sent
+		report.failed += batch.rows.size() - std::min(batch.rows.size(), result.affected + result.errors.size());
+		report.AddError(batch.lines.front(), m_sql->GetLastError());
+	}
+
+	batch.rows.clear();
+	batch.lines.clear();
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleLoader::LoadScript(const std::string& path, TMyOracleLoadReport& report)
+{
+	report = TMyOracleLoadReport();
+
+	if (!m_sql)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleLoader::LoadScript: SQL connection is null");
+		return false;
+	}
+
+	std::ifstream file(path);
+	if (!file)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleLoader::LoadScript: Cannot open ", path);
+		return false;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	Batch batch;
+	bool success = true;
+	size_t line_number = 0;
+	std::string line;
+	while (success && std::getline(file, line))
+	{
+		++line_number;
+
+		line = Trim(line);
+		if (line.size() < 11 || std::to_upper(line.substr(0, 11)) != "INSERT INTO")
+		{
+			continue;
+		}
+		++report.rows;
+
+		// Insert into DEV.EMPLOYEE (ID,...) values (348,'Duwkvxjq',...);
+		// the column list has no literals, VALUES is the first one before a quote
+		const std::string head = std::to_upper(line.substr(0, line.find('\'')));
+		const size_t values = head.find("VALUES");
+		const size_t open = values == std::string::npos ? values : line.find('(', values);
+		const size_t close = line.rfind(')');
+		if (open == std::string::npos || close == std::string::npos || close < open)
+		{
+			++report.failed;
+			report.AddError(line_number, "not an INSERT ... VALUES (...) statement");
+			continue;
+		}
+
+		TMyOracleBinds binds;
+		std::string sql = line.substr(0, values) + "VALUES (";
+		std::string fragment;
+		const std::vector<std::string> literals = SplitValues(line.substr(open + 1, close - open - 1));
+		for (size_t i = 0; i < literals.size(); ++i)
+		{
+			ParseLiteral(literals[i], binds.size() + 1, binds, fragment);
+			sql += (i > 0 ? ", " : "") + fragment;
+		}
+		sql += ")";
+
+		// Rows of the same shape share the statement
+		if (sql != batch.sql || batch.rows.size() >= m_array_size)
+		{
+			success = Flush(batch, report);
+			batch.sql = sql;
+		}
+		batch.rows.push_back(std::move(binds));
+		batch.lines.push_back(line_number);
+	}
+
+	success = success && Flush(batch, report);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleLoader::LoadCsv(const std::string& path, const std::string& table, TMyOracleLoadReport& report)
+{
+	report = TMyOracleLoadReport();
+
+	if (!m_sql)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleLoader::LoadCsv: SQL connection is null");
+		return false;
+	}
+
+	TMyOracleCsvReader reader;
+	if (!reader.Open(path))
+	{
+		return false;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	const std::vector<std::string>& columns = reader.Columns();
+	std::vector<std::string> fields;
+	std::vector<bool> quoted;
+	Batch batch;
+	batch.sql = "INSERT INTO " + table + " (";
+	for (size_t i = 0; i < columns.size(); ++i)
+	{
+		batch.sql += (i > 0 ? ", " : "") + columns[i];
+	}
+	batch.sql += ") VALUES (";
+	for (size_t i = 1; i <= columns.size(); ++i)
+	{
+		batch.sql += (i > 1 ? ", :" : ":") + std::to_string(i);
+	}
+	batch.sql += ")";
+
+	bool success = true;
+	while (success && reader.Next(fields, quoted))
+	{
+		++report.rows;
+
+		if (fields.size() != columns.size())
+		{
+			++report.failed;
+			report.AddError(reader.Line(), std::to_string(fields.size()) + " field(s), expected " + std::to_string(columns.size()));
+			continue;
+		}
+
+		TMyOracleBinds binds;
+		binds.reserve(fields.size());
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			TMyOracleValue number;
+			if (fields[i].empty())
+			{
+				binds.emplace_back(nullptr);
+			}
+			else if (!quoted[i] && ParseNumber(fields[i], number))
+			{
+				binds.emplace_back(nullptr);
+				binds.back().value = number;
+			}
+			else
+			{
+				binds.emplace_back(fields[i]);
+			}
+		}
+
+		if (batch.rows.size() >= m_array_size)
+		{
+			success = Flush(batch, report);
+		}
+		batch.rows.push_back(std::move(binds));
+		batch.lines.push_back(reader.Line());
+	}
+
+	success = success && Flush(batch, report);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return success;
+}
+// -----------------------------------------------------------------------------
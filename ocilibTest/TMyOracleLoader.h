@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLELOADER_H__
+#define __TMYORACLELOADER_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Reads a CSV file whose first line names the columns. Fields are separated
+// by commas and may be "quoted" ("" for a quote), but do not span lines.
+class TMyOracleCsvReader
+{
+public:
+	// Opens the file and reads the header, false if either fails
+	bool Open(const std::string& path);
+
+	const std::vector<std::string>& Columns() const { return m_columns; }
+
+	// Fields of the next line that is not blank, quoted tells which were in
+	// quotes. False at the end of the file.
+	bool Next(std::vector<std::string>& fields, std::vector<bool>& quoted);
+
+	// Line number of the last line read, 1 for the header
+	size_t Line() const { return m_line; }
+
+private:
+	std::ifstream m_file;
+	std::vector<std::string> m_columns;
+	size_t m_line = 0;
+};
+
+struct TMyOracleLoadReport
+{
+	// Rows read from the file
+	size_t rows = 0;
+	size_t inserted = 0;
+	// Rows rejected by the server, or that could not be read
+	size_t failed = 0;
+	size_t round_trips = 0;
+	double seconds = 0.0;
+	// The first MAX_ERRORS errors, "line N: ORA-..."
+	std::vector<std::string> errors;
+
+	static constexpr size_t MAX_ERRORS = 10;
+
+	void AddError(size_t line, const std::string& error);
+	void Print(std::ostream& out, const std::string& path) const;
+};
+
+// Bulk loader on top of TMyOracle::ExecuteArray().
+//
+// LoadScript() reads the INSERT statements of a SQL Developer export
+// (SQL_Tables/*.sql) and turns their literals into binds, so consecutive
+// INSERTs into the same columns go to the server array_size rows per round
+// trip instead of one. LoadCsv() does the same for a CSV file whose header
+// line names the columns. Rows the server rejects are counted and reported,
+// they do not stop the load.
+class TMyOracleLoader
+{
+public:
+	// 0 array_size uses the connection default
+	explicit TMyOracleLoader(TMyOracle* sql, size_t array_size = 0);
+
+	// INSERT lines of the script, the other statements are skipped. False if
+	// the file cannot be read or a round trip failed.
+	bool LoadScript(const std::string& path, TMyOracleLoadReport& report);
+
+	// See TMyOracleCsvReader. Empty fields are NULL, integers and decimals
+	// bind as numbers and everything else as strings.
+	bool LoadCsv(const std::string& path, const std::string& table, TMyOracleLoadReport& report);
+
+private:
+	// Rows of the same statement waiting to be sent
+	struct Batch
+	{
+		std::string sql;
+		std::vector<TMyOracleBinds> rows;
+		// Line of each row in the file
+		std::vector<size_t> lines;
+	};
+
+	bool Flush(Batch& batch, TMyOracleLoadReport& report);
+
+	TMyOracle* m_sql;
+	size_t m_array_size;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,330 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleLog.h"
+#include <chrono>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+// -----------------------------------------------------------------------------
+std::atomic<int> TMyOracleLog::s_level{ static_cast<int>(TMyOracleLogLevel::Info) };
+std::atomic<bool> TMyOracleLog::s_sync{ false };
+// -----------------------------------------------------------------------------
+
+// The rings of the threads and the thread writing them out. Draining is
+// done under m_mutex, which makes the writer thread and Flush() one reader
+// for the rings.
+class TMyOracleLogWriter
+{
+public:
+	using Ring = TMyOracleLog::Ring;
+
+	// Never destroyed, so that whatever logs late at exit finds it.
+	// Stopped by StopAtExit.
+	static TMyOracleLogWriter& Instance()
+	{
+		static TMyOracleLogWriter* writer = new TMyOracleLogWriter();
+		return *writer;
+	}
+
+	std::shared_ptr<Ring> Register()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_rings.push_back(std::make_shared<Ring>(m_ring_size));
+		if (!m_thread.joinable() && !m_stopped)
+		{
+			m_thread = std::thread(&TMyOracleLogWriter::Run, this);
+		}
+		return m_rings.back();
+	}
+
+	void SetRingSize(size_t bytes)
+	{
+		size_t size = 1024;
+		while (size < bytes)
+		{
+			size <<= 1;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_ring_size = size;
+	}
+
+	void Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Drain();
+	}
+
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stopped)
+			{
+				return;
+			}
+			m_stopped = true;
+		}
+		// From here on the threads logging write out their own messages
+		TMyOracleLog::s_sync.store(true, std::memory_order_relaxed);
+		m_wake.notify_all();
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+		Flush();
+	}
+
+	TMyOracleLogStats Stats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		TMyOracleLogStats stats = m_stats;
+		stats.threads = m_rings.size();
+		stats.dropped = m_retired_dropped;
+		for (const auto& ring : m_rings)
+		{
+			stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+private:
+	TMyOracleLogWriter() = default;
+
+	// Idle polling period: the logging threads never wake the writer
+	static constexpr std::chrono::milliseconds PERIOD{ 5 };
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_stopped)
+		{
+			Drain();
+			m_wake.wait_for(lock, PERIOD);
+		}
+	}
+
+	// Formats and writes what the rings hold, the caller holds m_mutex
+	void Drain()
+	{
+		std::vector<char> record;
+		uint64_t dropped = m_retired_dropped;
+
+		for (auto it = m_rings.begin(); it != m_rings.end();)
+		{
+			Ring& ring = **it;
+			// Read before the head: a ring seen closed and empty stays empty
+			const bool closed = ring.closed.load(std::memory_order_acquire);
+			const uint64_t head = ring.Head();
+			uint64_t tail = ring.Tail();
+			while (tail < head)
+			{
+				TMyOracleLog::Header header;
+				ring.Read(tail, &header, sizeof(header));
+				record.resize(header.size);
+				ring.Read(tail, record.data(), header.size);
+				tail += header.size;
+				Format(static_cast<TMyOracleLogLevel>(header.level), record.data() + sizeof(header), record.data() + header.size);
+			}
+			ring.Release(tail);
+
+			dropped += ring.dropped.load(std::memory_order_relaxed);
+			if (closed)
+			{
+				m_retired_dropped += ring.dropped.load(std::memory_order_relaxed);
+				it = m_rings.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (dropped > m_reported_dropped)
+		{
+			m_err += "[WARN] TMyOracleLog: " + std::to_string(dropped - m_reported_dropped) + " message(s) dropped, the log ring of their thread was full\n";
+			m_reported_dropped = dropped;
+		}
+
+		// One write per stream and drain
+		if (!m_out.empty())
+		{
+			std::fwrite(m_out.data(), 1, m_out.size(), stdout);
+			std::fflush(stdout);
+			m_stats.bytes += m_out.size();
+			m_out.clear();
+		}
+		if (!m_err.empty())
+		{
+			std::fwrite(m_err.data(), 1, m_err.size(), stderr);
+			std::fflush(stderr);
+			m_stats.bytes += m_err.size();
+			m_err.clear();
+		}
+	}
+
+	void Format(TMyOracleLogLevel level, const char* data, const char* end)
+	{
+		using Tag = TMyOracleLog::Tag;
+
+		std::string& out = level >= TMyOracleLogLevel::Warn ? m_err : m_out;
+		switch (level)
+		{
+		case TMyOracleLogLevel::Trace: out += "[TRACE] "; break;
+		case TMyOracleLogLevel::Debug: out += "[DEBUG] "; break;
+		case TMyOracleLogLevel::Warn: out += "[WARN] "; break;
+		case TMyOracleLogLevel::Error: out += "[ERROR] "; break;
+		case TMyOracleLogLevel::Fatal: out += "[FATAL] "; break;
+		default: break;
+		}
+
+		auto Take = [&data](auto& value)
+		{
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+		};
+
+		char number[32];
+		while (data < end)
+		{
+			Tag tag;
+			Take(tag);
+			switch (tag)
+			{
+			case Tag::Int:
+			{
+				int64_t value;
+				Take(value);
+				out.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+				break;
+			}
+			case Tag::UInt:
+			{
+				uint64_t value;
+				Take(value);
+				out.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+				break;
+			}
+			case Tag::Double:
+			{
+				// As operator<< writes it
+				double value;
+				Take(value);
+				out.append(number, static_cast<size_t>(std::snprintf(number, sizeof(number), "%g", value)));
+				break;
+			}
+			case Tag::Text:
+			{
+				uint32_t length;
+				Take(length);
+				out.append(data, length);
+				data += length;
+				break;
+			}
+			case Tag::Char:
+			{
+				char value;
+				Take(value);
+				out += value;
+				break;
+			}
+			case Tag::Bool:
+			{
+				uint8_t value;
+				Take(value);
+				out += value ? '1' : '0';
+				break;
+			}
+			case Tag::Pointer:
+			{
+				uintptr_t value;
+				Take(value);
+				out += "0x";
+				out.append(number, std::to_chars(number, number + sizeof(number), value, 16).ptr);
+				break;
+			}
+			default:
+				// Cannot happen, the record is not readable further
+				data = end;
+				break;
+			}
+		}
+		out += '\n';
+		++m_stats.written;
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::thread m_thread;
+	bool m_stopped = false;
+
+	std::vector<std::shared_ptr<Ring>> m_rings;
+	size_t m_ring_size = 64 * 1024;
+
+	// Text of the drain in progress, kept for its capacity
+	std::string m_out;
+	std::string m_err;
+
+	TMyOracleLogStats m_stats;
+	// Drops of the rings gone, and drops already reported
+	uint64_t m_retired_dropped = 0;
+	uint64_t m_reported_dropped = 0;
+};
+
+// Writes out what is left when the program ends
+static struct StopAtExit
+{
+	~StopAtExit() { TMyOracleLog::Stop(); }
+} s_stop_at_exit;
+// -----------------------------------------------------------------------------
+TMyOracleLog::Ring* TMyOracleLog::ThreadRing()
+{
+	// t_alive has no destructor and can be read while the thread exits,
+	// after t_owner is gone
+	static thread_local bool t_alive = true;
+	struct Owner
+	{
+		std::shared_ptr<Ring> ring;
+
+		~Owner()
+		{
+			t_alive = false;
+			if (ring)
+			{
+				ring->closed.store(true, std::memory_order_release);
+			}
+		}
+	};
+	static thread_local Owner t_owner;
+
+	if (!t_alive)
+	{
+		return nullptr;
+	}
+	if (!t_owner.ring)
+	{
+		t_owner.ring = TMyOracleLogWriter::Instance().Register();
+	}
+	return t_owner.ring.get();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleLog::SetRingSize(size_t bytes)
+{
+	TMyOracleLogWriter::Instance().SetRingSize(bytes);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleLog::Flush()
+{
+	TMyOracleLogWriter::Instance().Flush();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleLog::Stop()
+{
+	TMyOracleLogWriter::Instance().Stop();
+}
+// -----------------------------------------------------------------------------
+TMyOracleLogStats TMyOracleLog::Stats()
+{
+	return TMyOracleLogWriter::Instance().Stats();
+}
+// -----------------------------------------------------------------------------
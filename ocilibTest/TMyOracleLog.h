@@ -0,0 +1,286 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLELOG_H__
+#define __TMYORACLELOG_H__
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+enum class TMyOracleLogLevel
+{
+	Trace = 0,
+	Debug = 1,
+	Info = 2,
+	Warn = 3,
+	Error = 4,
+	Fatal = 5,
+	Off = 6
+};
+
+// Messages below this level are compiled out, their arguments are not even
+// evaluated. Debug builds keep everything, release builds drop Trace and
+// Debug.
+#ifndef TMYORACLE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define TMYORACLE_LOG_MIN_LEVEL 2
+#else
+#define TMYORACLE_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// TMYORACLE_LOG_ERROR("[", id, "] Failed to execute statement: ", error)
+// writes its arguments one after the other, like operator<< would. Info
+// and below go to stdout, the others to stderr with a "[LEVEL] " prefix.
+#define TMYORACLE_LOG(level, ...) \
+	do \
+	{ \
+		if constexpr (static_cast<int>(level) >= TMYORACLE_LOG_MIN_LEVEL) \
+		{ \
+			if (TMyOracleLog::IsEnabled(level)) \
+			{ \
+				TMyOracleLog::Write(level, __VA_ARGS__); \
+			} \
+		} \
+	} while (0)
+
+#define TMYORACLE_LOG_TRACE(...) TMYORACLE_LOG(TMyOracleLogLevel::Trace, __VA_ARGS__)
+#define TMYORACLE_LOG_DEBUG(...) TMYORACLE_LOG(TMyOracleLogLevel::Debug, __VA_ARGS__)
+#define TMYORACLE_LOG_INFO(...) TMYORACLE_LOG(TMyOracleLogLevel::Info, __VA_ARGS__)
+#define TMYORACLE_LOG_WARN(...) TMYORACLE_LOG(TMyOracleLogLevel::Warn, __VA_ARGS__)
+#define TMYORACLE_LOG_ERROR(...) TMYORACLE_LOG(TMyOracleLogLevel::Error, __VA_ARGS__)
+#define TMYORACLE_LOG_FATAL(...) TMYORACLE_LOG(TMyOracleLogLevel::Fatal, __VA_ARGS__)
+
+struct TMyOracleLogStats
+{
+	uint64_t written = 0;
+	// Messages lost because the ring of their thread was full
+	uint64_t dropped = 0;
+	// Text written out
+	uint64_t bytes = 0;
+	// Threads with a ring
+	size_t threads = 0;
+};
+
+// Asynchronous logging.
+//
+// A message is not formatted by the thread logging it: its arguments are
+// copied in binary (numbers as they are, strings as length and bytes) into a
+// ring owned by that thread, with no lock and no system call. A background
+// writer drains the rings every few milliseconds, formats the messages and
+// writes them out with one call per stream. When the ring of a thread is
+// full its messages are dropped and counted, so an error storm costs the
+// threads raising it a failed bounds check instead of a stream lock each.
+//
+// Messages of one thread stay in order, messages of different threads are
+// only ordered by when the writer drained them. Fatal messages are written
+// before the call returns.
+class TMyOracleLog
+{
+public:
+	static void SetLevel(TMyOracleLogLevel level) { s_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+	static TMyOracleLogLevel GetLevel() { return static_cast<TMyOracleLogLevel>(s_level.load(std::memory_order_relaxed)); }
+	static bool IsEnabled(TMyOracleLogLevel level) { return static_cast<int>(level) >= s_level.load(std::memory_order_relaxed); }
+
+	// Bytes of the ring of the threads that log for the first time after the
+	// call, rounded up to a power of two (64 KiB)
+	static void SetRingSize(size_t bytes);
+
+	template<typename... Args>
+	static void Write(TMyOracleLogLevel level, const Args&... args)
+	{
+		Ring* ring = ThreadRing();
+		if (!ring)
+		{
+			return;
+		}
+
+		Encoder size;
+		size.Put(Header{});
+		(Encode(size, args), ...);
+
+		uint64_t pos = 0;
+		if (!ring->Reserve(size.bytes, pos))
+		{
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Encoder record(ring, pos);
+		record.Put(Header{ static_cast<uint32_t>(size.bytes), static_cast<uint8_t>(level) });
+		(Encode(record, args), ...);
+		ring->Publish(pos + size.bytes);
+
+		if (level >= TMyOracleLogLevel::Fatal || s_sync.load(std::memory_order_relaxed))
+		{
+			Flush();
+		}
+	}
+
+	// Writes out what every thread logged so far before returning
+	static void Flush();
+	// Stops the writer once everything is written, later messages are
+	// written by the thread logging them. Called at exit.
+	static void Stop();
+
+	static TMyOracleLogStats Stats();
+
+private:
+	friend class TMyOracleLogWriter;
+
+	enum class Tag : uint8_t
+	{
+		Int = 1,
+		UInt = 2,
+		Double = 3,
+		Text = 4,
+		Char = 5,
+		Bool = 6,
+		Pointer = 7
+	};
+
+	struct Header
+	{
+		uint32_t size = 0;	// bytes of the record, header included
+		uint8_t level = 0;
+	};
+
+	// Longer strings are cut
+	static constexpr size_t MAX_TEXT = 4096;
+
+	// Bytes written by one thread and read by the writer, positions only
+	// grow and are taken modulo the size
+	class Ring
+	{
+	public:
+		explicit Ring(size_t size) : m_data(size), m_mask(size - 1) {}
+
+		bool Reserve(size_t bytes, uint64_t& pos) const
+		{
+			pos = m_head.load(std::memory_order_relaxed);
+			return pos + bytes - m_tail.load(std::memory_order_acquire) <= m_data.size();
+		}
+		void Copy(uint64_t pos, const void* data, size_t bytes)
+		{
+			const size_t offset = static_cast<size_t>(pos & m_mask);
+			const size_t first = std::min(bytes, m_data.size() - offset);
+			std::memcpy(m_data.data() + offset, data, first);
+			std::memcpy(m_data.data(), static_cast<const char*>(data) + first, bytes - first);
+		}
+		void Publish(uint64_t head) { m_head.store(head, std::memory_order_release); }
+
+		uint64_t Head() const { return m_head.load(std::memory_order_acquire); }
+		uint64_t Tail() const { return m_tail.load(std::memory_order_relaxed); }
+		void Read(uint64_t pos, void* data, size_t bytes) const
+		{
+			const size_t offset = static_cast<size_t>(pos & m_mask);
+			const size_t first = std::min(bytes, m_data.size() - offset);
+			std::memcpy(data, m_data.data() + offset, first);
+			std::memcpy(static_cast<char*>(data) + first, m_data.data(), bytes - first);
+		}
+		void Release(uint64_t tail) { m_tail.store(tail, std::memory_order_release); }
+
+		std::atomic<uint64_t> dropped{ 0 };
+		// The thread exited, the ring goes once drained
+		std::atomic<bool> closed{ false };
+
+	private:
+		std::vector<char> m_data;
+		uint64_t m_mask;
+		alignas(64) std::atomic<uint64_t> m_head{ 0 };
+		alignas(64) std::atomic<uint64_t> m_tail{ 0 };
+	};
+
+	// Measures a record without a ring, writes it with one
+	struct Encoder
+	{
+		Encoder() = default;
+		Encoder(Ring* r, uint64_t p) : ring(r), pos(p) {}
+
+		void Put(const void* data, size_t size)
+		{
+			if (ring)
+			{
+				ring->Copy(pos + bytes, data, size);
+			}
+			bytes += size;
+		}
+		template<typename T>
+		void Put(const T& value) { Put(&value, sizeof(value)); }
+
+		Ring* ring = nullptr;
+		uint64_t pos = 0;
+		size_t bytes = 0;
+	};
+
+	template<typename T>
+	static void Encode(Encoder& encoder, const T& value)
+	{
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			encoder.Put(Tag::Bool);
+			encoder.Put(static_cast<uint8_t>(value));
+		}
+		else if constexpr (std::is_same_v<T, char>)
+		{
+			encoder.Put(Tag::Char);
+			encoder.Put(value);
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			encoder.Put(Tag::Int);
+			encoder.Put(static_cast<int64_t>(value));
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			encoder.Put(Tag::Int);
+			encoder.Put(static_cast<int64_t>(value));
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			encoder.Put(Tag::UInt);
+			encoder.Put(static_cast<uint64_t>(value));
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			encoder.Put(Tag::Double);
+			encoder.Put(static_cast<double>(value));
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+		{
+			const std::string_view text = value;
+			const uint32_t length = static_cast<uint32_t>(std::min(text.size(), MAX_TEXT));
+			encoder.Put(Tag::Text);
+			encoder.Put(length);
+			encoder.Put(text.data(), length);
+		}
+		else if constexpr (std::is_pointer_v<T>)
+		{
+			encoder.Put(Tag::Pointer);
+			encoder.Put(reinterpret_cast<uintptr_t>(value));
+		}
+		else
+		{
+			static_assert(std::is_same_v<T, void>, "TMyOracleLog: unsupported argument type");
+		}
+	}
+
+	// The ring of the calling thread, created on its first message.
+	// nullptr once the thread is exiting.
+	static Ring* ThreadRing();
+
+	static std::atomic<int> s_level;
+	// Set by Stop(), the writer is gone
+	static std::atomic<bool> s_sync;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
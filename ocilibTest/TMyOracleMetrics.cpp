@@ -0,0 +1,231 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleMetrics.h"
+#include <cstdio>
+#include <iomanip>
+// -----------------------------------------------------------------------------
+std::atomic<bool> TMyOracleMetrics::s_enabled{ false };
+// -----------------------------------------------------------------------------
+static constexpr size_t PHASES = static_cast<size_t>(TMyOraclePhase::PHASES);
+// -----------------------------------------------------------------------------
+static const char* const PHASE_NAMES[PHASES] =
+{
+	"mutex_wait",
+	"create",
+	"prepare",
+	"execute",
+	"commit",
+	"fetch",
+	"convert"
+};
+// -----------------------------------------------------------------------------
+// Prometheus bucket bounds: powers of two from 2^10 ns (1 us) to 2^35 ns
+// (34 s). They fall on bucket boundaries, so the counts are exact.
+static constexpr unsigned int PROMETHEUS_FIRST_EXPONENT = 10;
+static constexpr unsigned int PROMETHEUS_LAST_EXPONENT = 35;
+// -----------------------------------------------------------------------------
+int64_t TMyOracleMetricsSnapshot::Phase::PercentileNs(double percentile) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	const double rank = percentile / 100.0 * static_cast<double>(count);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size(); ++i)
+	{
+		seen += buckets[i];
+		if (seen > 0 && static_cast<double>(seen) >= rank)
+		{
+			return TMyOracleMetricBuckets::Value(i);
+		}
+	}
+	return TMyOracleMetricBuckets::Value(buckets.size() - 1);
+}
+// -----------------------------------------------------------------------------
+TMyOracleMetrics& TMyOracleMetrics::Global()
+{
+	static TMyOracleMetrics global;
+	return global;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleMetrics::Record(TMyOraclePhase phase, int64_t ns)
+{
+	Phase& target = m_phases[static_cast<size_t>(phase)];
+	target.count.fetch_add(1, std::memory_order_relaxed);
+	target.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+	target.buckets[TMyOracleMetricBuckets::Index(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleMetrics::AddQuery(bool failed, uint64_t rows, uint64_t bytes, uint64_t round_trips)
+{
+	m_queries.fetch_add(1, std::memory_order_relaxed);
+	if (failed)
+	{
+		m_errors.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_rows.fetch_add(rows, std::memory_order_relaxed);
+	m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	m_round_trips.fetch_add(round_trips, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+TMyOracleMetricsSnapshot TMyOracleMetrics::Snapshot() const
+{
+	TMyOracleMetricsSnapshot snapshot;
+
+	for (size_t p = 0; p < PHASES; ++p)
+	{
+		const Phase& source = m_phases[p];
+		TMyOracleMetricsSnapshot::Phase& target = snapshot.phases[p];
+
+		target.buckets.resize(TMyOracleMetricBuckets::COUNT);
+		for (size_t i = 0; i < TMyOracleMetricBuckets::COUNT; ++i)
+		{
+			target.buckets[i] = source.buckets[i].load(std::memory_order_relaxed);
+			target.count += target.buckets[i];
+		}
+		target.sum_ns = source.sum_ns.load(std::memory_order_relaxed);
+	}
+
+	snapshot.queries = m_queries.load(std::memory_order_relaxed);
+	snapshot.errors = m_errors.load(std::memory_order_relaxed);
+	snapshot.rows = m_rows.load(std::memory_order_relaxed);
+	snapshot.bytes = m_bytes.load(std::memory_order_relaxed);
+	snapshot.round_trips = m_round_trips.load(std::memory_order_relaxed);
+	return snapshot;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleMetrics::Reset()
+{
+	for (Phase& phase : m_phases)
+	{
+		phase.count.store(0, std::memory_order_relaxed);
+		phase.sum_ns.store(0, std::memory_order_relaxed);
+		for (auto& bucket : phase.buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+	m_queries.store(0, std::memory_order_relaxed);
+	m_errors.store(0, std::memory_order_relaxed);
+	m_rows.store(0, std::memory_order_relaxed);
+	m_bytes.store(0, std::memory_order_relaxed);
+	m_round_trips.store(0, std::memory_order_relaxed);
+}
+// -----------------------------------------------------------------------------
+// {labels,extra} or {extra} or {labels}
+static std::string Labels(const std::string& labels, const std::string& extra)
+{
+	if (labels.empty() && extra.empty())
+	{
+		return std::string();
+	}
+	return "{" + labels + (!labels.empty() && !extra.empty() ? "," : "") + extra + "}";
+}
+// -----------------------------------------------------------------------------
+void TMyOracleMetrics::WritePrometheus(std::ostream& out, const std::vector<std::pair<std::string, TMyOracleMetricsSnapshot>>& series)
+{
+	char number[32];
+
+	out << "# HELP tmyoracle_phase_seconds Time spent in each phase of a query.\n"
+		<< "# TYPE tmyoracle_phase_seconds histogram\n";
+	for (const auto& [labels, snapshot] : series)
+	{
+		for (size_t p = 0; p < PHASES; ++p)
+		{
+			const TMyOracleMetricsSnapshot::Phase& phase = snapshot.phases[p];
+			const std::string phase_label = std::string("phase=\"") + PHASE_NAMES[p] + "\"";
+
+			// Cumulative counts at every power of two bound
+			uint64_t cumulative = 0;
+			size_t bucket = 0;
+			for (unsigned int exponent = PROMETHEUS_FIRST_EXPONENT; exponent <= PROMETHEUS_LAST_EXPONENT; ++exponent)
+			{
+				const int64_t bound = int64_t(1) << exponent;
+				while (bucket < phase.buckets.size() && TMyOracleMetricBuckets::Value(bucket) < bound)
+				{
+					cumulative += phase.buckets[bucket++];
+				}
+				std::snprintf(number, sizeof(number), "%g", static_cast<double>(bound) / 1e9);
+				out << "tmyoracle_phase_seconds_bucket" << Labels(labels, phase_label + ",le=\"" + number + "\"") << " " << cumulative << "\n";
+			}
+			out << "tmyoracle_phase_seconds_bucket" << Labels(labels, phase_label + ",le=\"+Inf\"") << " " << phase.count << "\n";
+
+			std::snprintf(number, sizeof(number), "%.9g", static_cast<double>(phase.sum_ns) / 1e9);
+			out << "tmyoracle_phase_seconds_sum" << Labels(labels, phase_label) << " " << number << "\n";
+			out << "tmyoracle_phase_seconds_count" << Labels(labels, phase_label) << " " << phase.count << "\n";
+		}
+	}
+
+	const std::pair<const char*, uint64_t TMyOracleMetricsSnapshot::*> counters[] =
+	{
+		{ "queries", &TMyOracleMetricsSnapshot::queries },
+		{ "errors", &TMyOracleMetricsSnapshot::errors },
+		{ "rows_fetched", &TMyOracleMetricsSnapshot::rows },
+		{ "bytes_materialized", &TMyOracleMetricsSnapshot::bytes },
+		{ "round_trips", &TMyOracleMetricsSnapshot::round_trips }
+	};
+	for (const auto& [name, member] : counters)
+	{
+		out << "# TYPE tmyoracle_" << name << "_total counter\n";
+		for (const auto& [labels, snapshot] : series)
+		{
+			out << "tmyoracle_" << name << "_total" << Labels(labels, std::string()) << " " << snapshot.*member << "\n";
+		}
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleMetrics::Print(std::ostream& out, const TMyOracleMetricsSnapshot& snapshot)
+{
+	out << std::left << std::setw(12) << "phase" << std::right
+		<< std::setw(10) << "count"
+		<< std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us"
+		<< std::setw(12) << "p99 us"
+		<< std::setw(12) << "p99.9 us"
+		<< std::setw(14) << "total ms" << std::endl;
+
+	out << std::fixed << std::setprecision(1);
+	for (size_t p = 0; p < PHASES; ++p)
+	{
+		const TMyOracleMetricsSnapshot::Phase& phase = snapshot.phases[p];
+		out << std::left << std::setw(12) << PHASE_NAMES[p] << std::right
+			<< std::setw(10) << phase.count
+			<< std::setw(12) << phase.MeanNs() / 1000.0
+			<< std::setw(12) << phase.PercentileNs(50.0) / 1000.0
+			<< std::setw(12) << phase.PercentileNs(99.0) / 1000.0
+			<< std::setw(12) << phase.PercentileNs(99.9) / 1000.0
+			<< std::setw(14) << static_cast<double>(phase.sum_ns) / 1e6 << std::endl;
+	}
+	out << std::defaultfloat;
+
+	out << snapshot.queries << " queries, " << snapshot.errors << " errors, " << snapshot.rows << " rows, "
+		<< snapshot.bytes << " bytes, " << snapshot.round_trips << " round trips" << std::endl;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleQueryTimer::Flush()
+{
+	if (!m_enabled)
+	{
+		return;
+	}
+	m_enabled = false;
+
+	TMyOracleMetrics* targets[] = { m_connection, &TMyOracleMetrics::Global() };
+	for (TMyOracleMetrics* metrics : targets)
+	{
+		if (!metrics)
+		{
+			continue;
+		}
+		for (size_t p = 0; p < PHASES; ++p)
+		{
+			if (m_seen[p])
+			{
+				metrics->Record(static_cast<TMyOraclePhase>(p), m_ns[p]);
+			}
+		}
+		metrics->AddQuery(m_failed, m_rows, m_bytes, m_round_trips);
+	}
+}
+// -----------------------------------------------------------------------------
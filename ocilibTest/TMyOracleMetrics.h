@@ -0,0 +1,187 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEMETRICS_H__
+#define __TMYORACLEMETRICS_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleHistogram.h"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Where the time of a query goes, in the order a query runs through them
+enum class TMyOraclePhase
+{
+	MUTEX_WAIT = 0,	// waiting for the TMyOracle connection lock
+	CREATE,			// statement handle creation
+	PREPARE,
+	EXECUTE,		// execute round trip, with the prefetched rows
+	COMMIT,
+	FETCH,			// fetch round trips, and reading rows out of the fetch buffer
+	CONVERT,		// copying rows into TMyOracleResultSet columns
+	PHASES
+};
+
+// Nanosecond buckets, 4 per power of two (within 25%)
+using TMyOracleMetricBuckets = TMyOracleLogLinearBuckets<3, 62>;
+
+// Plain copy of a TMyOracleMetrics
+struct TMyOracleMetricsSnapshot
+{
+	struct Phase
+	{
+		uint64_t count = 0;
+		int64_t sum_ns = 0;
+		std::vector<uint64_t> buckets;
+
+		double MeanNs() const { return count ? static_cast<double>(sum_ns) / static_cast<double>(count) : 0.0; }
+		// Upper bound of the bucket holding the percentile, 0 when empty
+		int64_t PercentileNs(double percentile) const;
+	};
+
+	Phase phases[static_cast<size_t>(TMyOraclePhase::PHASES)];
+	// Queries run, and those that failed
+	uint64_t queries = 0;
+	uint64_t errors = 0;
+	uint64_t rows = 0;
+	// Size of the values copied into result sets
+	uint64_t bytes = 0;
+	// One per execute, commit and fetch array
+	uint64_t round_trips = 0;
+
+	const Phase& Get(TMyOraclePhase phase) const { return phases[static_cast<size_t>(phase)]; }
+};
+
+// Per-phase timers and counters. Every TMyOracle keeps its own and adds to
+// Global() as well; all updates are relaxed atomics, so recording never
+// takes a lock.
+//
+// Recording is off by default. While off, queries only test one flag: no
+// clock is read and nothing is written.
+class TMyOracleMetrics
+{
+public:
+	static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+	static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+	// Sum over every connection of the process
+	static TMyOracleMetrics& Global();
+
+	TMyOracleMetrics() = default;
+
+	// Prevent copying
+	TMyOracleMetrics(const TMyOracleMetrics&) = delete;
+	TMyOracleMetrics& operator=(const TMyOracleMetrics&) = delete;
+
+	void Record(TMyOraclePhase phase, int64_t ns);
+	void AddQuery(bool failed, uint64_t rows, uint64_t bytes, uint64_t round_trips);
+
+	TMyOracleMetricsSnapshot Snapshot() const;
+	void Reset();
+
+	// Prometheus text format. Every series gets its labels ("conn=\"3\""),
+	// HELP and TYPE lines are written once for all of them.
+	static void WritePrometheus(std::ostream& out, const std::vector<std::pair<std::string, TMyOracleMetricsSnapshot>>& series);
+	void WritePrometheus(std::ostream& out) const { WritePrometheus(out, { { std::string(), Snapshot() } }); }
+
+	// Mean and percentiles of every phase, in microseconds
+	static void Print(std::ostream& out, const TMyOracleMetricsSnapshot& snapshot);
+
+private:
+	struct Phase
+	{
+		std::atomic<uint64_t> count{ 0 };
+		std::atomic<int64_t> sum_ns{ 0 };
+		std::atomic<uint64_t> buckets[TMyOracleMetricBuckets::COUNT] = {};
+	};
+
+	static std::atomic<bool> s_enabled;
+
+	Phase m_phases[static_cast<size_t>(TMyOraclePhase::PHASES)];
+	std::atomic<uint64_t> m_queries{ 0 };
+	std::atomic<uint64_t> m_errors{ 0 };
+	std::atomic<uint64_t> m_rows{ 0 };
+	std::atomic<uint64_t> m_bytes{ 0 };
+	std::atomic<uint64_t> m_round_trips{ 0 };
+};
+
+// Times the phases of one query and records them into the connection and
+// global metrics when it goes out of scope. Phases are consecutive: Lap()
+// charges the time since the previous lap to a phase. Does nothing when
+// metrics are disabled at construction.
+class TMyOracleQueryTimer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit TMyOracleQueryTimer(TMyOracleMetrics* connection)
+		: m_connection(connection), m_enabled(TMyOracleMetrics::IsEnabled())
+	{
+		if (m_enabled)
+		{
+			m_lap = Clock::now();
+		}
+	}
+	~TMyOracleQueryTimer() { Flush(); }
+
+	// Prevent copying
+	TMyOracleQueryTimer(const TMyOracleQueryTimer&) = delete;
+	TMyOracleQueryTimer& operator=(const TMyOracleQueryTimer&) = delete;
+
+	bool Enabled() const { return m_enabled; }
+
+	void Lap(TMyOraclePhase phase)
+	{
+		if (m_enabled)
+		{
+			const Clock::time_point now = Clock::now();
+			m_ns[static_cast<size_t>(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_lap).count();
+			m_seen[static_cast<size_t>(phase)] = true;
+			m_lap = now;
+		}
+	}
+	void Add(TMyOraclePhase phase, int64_t ns)
+	{
+		m_ns[static_cast<size_t>(phase)] += ns;
+		m_seen[static_cast<size_t>(phase)] = true;
+	}
+	// Restarts the lap clock without charging anyone, after time the query
+	// is not responsible for
+	void Restart()
+	{
+		if (m_enabled)
+		{
+			m_lap = Clock::now();
+		}
+	}
+
+	void Fail() { m_failed = true; }
+	void AddRows(uint64_t rows, uint64_t bytes)
+	{
+		m_rows += rows;
+		m_bytes += bytes;
+	}
+	void AddRoundTrips(uint64_t round_trips) { m_round_trips += round_trips; }
+
+	// Records now instead of at destruction, the timer is spent afterwards
+	void Flush();
+
+private:
+	TMyOracleMetrics* m_connection;
+	bool m_enabled;
+	bool m_failed = false;
+	Clock::time_point m_lap;
+
+	// Phases the query went through get one sample each
+	int64_t m_ns[static_cast<size_t>(TMyOraclePhase::PHASES)] = {};
+	bool m_seen[static_cast<size_t>(TMyOraclePhase::PHASES)] = {};
+	uint64_t m_rows = 0;
+	uint64_t m_bytes = 0;
+	uint64_t m_round_trips = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,662 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleOciCxxDriver.h"
+#include "TMyOracleOciDriver.h"
+// -----------------------------------------------------------------------------
+#ifndef TMYORACLE_NO_OCI
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Fail()
+{
+	try
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		SetLastError(ex.what());
+	}
+	catch (...)
+	{
+		SetLastError("Unknown OCILIB error");
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Connect(const std::string& user, const std::string& password, const std::string& db)
+{
+	Disconnect();
+
+	ClearLost();
+	try
+	{
+		m_conn = std::make_unique<ocilib::Connection>(db, user, password, ocilib::Environment::SessionDefault);
+		if (m_conn->IsNull())
+		{
+			m_conn.reset();
+			SetLastError("Failed to create the connection");
+			return false;
+		}
+		return true;
+	}
+	catch (...)
+	{
+		m_conn.reset();
+		return Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Connect(TMyOracleDriverPool& pool)
+{
+	Disconnect();
+
+	TMyOracleOciCxxPool* cxx_pool = dynamic_cast<TMyOracleOciCxxPool*>(&pool);
+	if (!cxx_pool || cxx_pool->Handle().IsNull())
+	{
+		SetLastError("Not an OCI C++ API session pool");
+		return false;
+	}
+
+	ClearLost();
+	try
+	{
+		m_conn = std::make_unique<ocilib::Connection>(cxx_pool->Handle().GetConnection());
+		if (m_conn->IsNull())
+		{
+			m_conn.reset();
+			SetLastError("Failed to get a pooled session");
+			return false;
+		}
+		return true;
+	}
+	catch (...)
+	{
+		m_conn.reset();
+		return Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Disconnect()
+{
+	if (!m_conn)
+	{
+		return false;
+	}
+
+	try
+	{
+		// Closes the session, or gives it back to its pool
+		m_conn->Close();
+	}
+	catch (...)
+	{
+		Fail();
+	}
+	m_conn.reset();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::IsConnected() const
+{
+	// No IsServerAlive(): it is a round trip per check. A session the server
+	// dropped shows up as the error of the next call, see IsLost().
+	return m_conn && !m_conn->IsNull() && !IsLost();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Ping()
+{
+	try
+	{
+		return m_conn && m_conn->PingServer();
+	}
+	catch (...)
+	{
+		return Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Commit(TMyOracleCommitMode mode)
+{
+	try
+	{
+		if (mode == TMyOracleCommitMode::Wait)
+		{
+			m_conn->Commit();
+		}
+		else
+		{
+			// Connection::Commit() always waits, the durability is chosen in SQL
+			ocilib::Statement stmt(*m_conn);
+			stmt.Execute("COMMIT WRITE NOWAIT");
+		}
+		return true;
+	}
+	catch (...)
+	{
+		return Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Rollback()
+{
+	try
+	{
+		m_conn->Rollback();
+		return true;
+	}
+	catch (...)
+	{
+		return Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriver::Break(std::string& error)
+{
+	if (!m_conn)
+	{
+		error = "Not connected";
+		return false;
+	}
+
+	try
+	{
+		m_conn->Break();
+		return true;
+	}
+	catch (const std::exception& ex)
+	{
+		error = ex.what();
+	}
+	catch (...)
+	{
+		error = "Unknown OCILIB error";
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriver::SetAutoCommit(bool enabled)
+{
+	try
+	{
+		m_conn->SetAutoCommit(enabled);
+	}
+	catch (...)
+	{
+		Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriver::SetStatementCacheSize(unsigned int size)
+{
+	try
+	{
+		m_conn->SetStatementCacheSize(size);
+	}
+	catch (...)
+	{
+		Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverStatement> TMyOracleOciCxxDriver::CreateStatement()
+{
+	try
+	{
+		if (m_conn)
+		{
+			return std::make_unique<TMyOracleOciCxxDriverStatement>(*this, *m_conn);
+		}
+		SetLastError("Not connected");
+	}
+	catch (...)
+	{
+		Fail();
+	}
+	return nullptr;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverDirectPath> TMyOracleOciCxxDriver::CreateDirectPath()
+{
+	if (!m_conn)
+	{
+		SetLastError("Not connected");
+		return nullptr;
+	}
+	return std::make_unique<TMyOracleOciCxxDirectPath>(*this, *m_conn);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriverStatement::SetFetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		m_stmt.SetFetchSize(rows);
+		m_fetch_size = rows;
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriverStatement::SetPrefetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		m_stmt.SetPrefetchSize(rows);
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriverStatement::SetBindByPosition()
+{
+	m_stmt.SetBindMode(ocilib::Statement::BindByPosition);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::Prepare(const std::string& sql)
+{
+	try
+	{
+		m_rs.reset();
+		m_stmt.Prepare(sql);
+		// Array DML in batch error mode: the rows in error are skipped and
+		// reported by ExecuteArray(), the others are applied
+		m_stmt.SetBatchErrorMode(true);
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindInt64(const std::string& name, int64_t* value)
+{
+	try
+	{
+		m_stmt.Bind(name, *reinterpret_cast<big_int*>(value), ocilib::BindInfo::In);
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindDouble(const std::string& name, double* value)
+{
+	try
+	{
+		m_stmt.Bind(name, *value, ocilib::BindInfo::In);
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindString(const std::string& name, std::string* value, unsigned int capacity)
+{
+	try
+	{
+		m_stmt.Bind(name, *value, capacity, ocilib::BindInfo::In);
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriverStatement::SetBindNull(const std::string& name, bool is_null)
+{
+	try
+	{
+		m_stmt.GetBind(name).SetDataNull(is_null);
+	}
+	catch (...)
+	{
+		m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::Execute()
+{
+	m_rs.reset();
+	m_names.clear();
+	m_types.clear();
+
+	try
+	{
+		m_stmt.ExecutePrepared();
+
+		// Describe the columns once, not once per fetched row
+		std::unique_ptr<ocilib::Resultset> rs = std::make_unique<ocilib::Resultset>(m_stmt.GetResultset());
+		if (!rs->IsNull())
+		{
+			const unsigned int colCount = rs->GetColumnCount();
+			for (unsigned int i = 1; i <= colCount; ++i)
+			{
+				const auto col = rs->GetColumn(i);
+				m_names.push_back(col.GetName());
+				m_types.push_back(TMyOracleOciColumnType(col.GetType(), col.GetScale(), col.GetPrecision()));
+			}
+			m_text.assign(colCount, std::string());
+			m_rs = std::move(rs);
+		}
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::SetBindArraySize(unsigned int size)
+{
+	try
+	{
+		m_stmt.SetBindArraySize(size);
+		m_array_size = size;
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindArray(std::unique_ptr<ArrayBind> bind)
+{
+	try
+	{
+		if (bind->ints)
+		{
+			bind->int_values.resize(m_array_size);
+			m_stmt.Bind(bind->name, bind->int_values, ocilib::BindInfo::In);
+		}
+		else if (bind->doubles)
+		{
+			bind->double_values.resize(m_array_size);
+			m_stmt.Bind(bind->name, bind->double_values, ocilib::BindInfo::In);
+		}
+		else
+		{
+			bind->text_values.resize(m_array_size);
+			m_stmt.Bind(bind->name, bind->text_values, bind->length, ocilib::BindInfo::In);
+		}
+		m_array_binds.push_back(std::move(bind));
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindInt64Array(const std::string& name, int64_t* values)
+{
+	auto bind = std::make_unique<ArrayBind>();
+	bind->name = name;
+	bind->ints = values;
+	return BindArray(std::move(bind));
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindDoubleArray(const std::string& name, double* values)
+{
+	auto bind = std::make_unique<ArrayBind>();
+	bind->name = name;
+	bind->doubles = values;
+	return BindArray(std::move(bind));
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::BindStringArray(const std::string& name, char* values, unsigned int length)
+{
+	auto bind = std::make_unique<ArrayBind>();
+	bind->name = name;
+	bind->text = values;
+	bind->length = length;
+	return BindArray(std::move(bind));
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDriverStatement::SetBindNullAt(const std::string& name, unsigned int row, bool is_null)
+{
+	try
+	{
+		m_stmt.GetBind(name).SetDataNull(is_null, row + 1);
+	}
+	catch (...)
+	{
+		m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::ExecuteArray(unsigned int rows)
+{
+	m_batch_errors.clear();
+	m_rs.reset();
+	m_names.clear();
+	m_types.clear();
+
+	for (auto& bind : m_array_binds)
+	{
+		for (unsigned int row = 0; row < rows; ++row)
+		{
+			if (bind->ints)
+			{
+				bind->int_values[row] = bind->ints[row];
+			}
+			else if (bind->doubles)
+			{
+				bind->double_values[row] = bind->doubles[row];
+			}
+			else
+			{
+				bind->text_values[row] = bind->text + static_cast<size_t>(row) * (bind->length + 1);
+			}
+		}
+	}
+
+	bool executed = true;
+	try
+	{
+		if (rows != m_array_size)
+		{
+			m_stmt.SetBindArraySize(rows);
+			m_array_size = rows;
+		}
+		m_stmt.ExecutePrepared();
+	}
+	catch (...)
+	{
+		executed = m_driver.Fail();
+	}
+
+	try
+	{
+		for (const ocilib::Exception& error : m_stmt.GetBatchErrors())
+		{
+			m_batch_errors.push_back({ error.GetRow() - 1, error.GetOracleErrorCode(), error.GetMessage() });
+		}
+	}
+	catch (...)
+	{
+		m_driver.Fail();
+	}
+
+	return executed || !m_batch_errors.empty();
+}
+// -----------------------------------------------------------------------------
+std::string TMyOracleOciCxxDriverStatement::GetSql() const
+{
+	try
+	{
+		return m_stmt.GetSql();
+	}
+	catch (...)
+	{
+		return {};
+	}
+}
+// -----------------------------------------------------------------------------
+unsigned int TMyOracleOciCxxDriverStatement::GetAffectedRows() const
+{
+	try
+	{
+		return m_stmt.GetAffectedRows();
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDriverStatement::Fetch()
+{
+	try
+	{
+		m_fetch_failed = false;
+		return m_rs && m_rs->Next();
+	}
+	catch (...)
+	{
+		m_fetch_failed = true;
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleDate TMyOracleOciCxxDriverStatement::GetDate(unsigned int index)
+{
+	int y = 0, m = 0, d = 0, h = 0, mi = 0, s = 0;
+	m_rs->Get<ocilib::Date>(index).GetDateTime(y, m, d, h, mi, s);
+	return TMyOracleDate::Make(y, m, d, h, mi, s);
+}
+// -----------------------------------------------------------------------------
+const char* TMyOracleOciCxxDriverStatement::GetString(unsigned int index, size_t& length)
+{
+	std::string& text = m_text[index - 1];
+	text = m_rs->Get<ocilib::ostring>(index);
+	length = text.size();
+	return text.c_str();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDirectPath::Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel)
+{
+	try
+	{
+		m_table = std::make_unique<ocilib::TypeInfo>(m_conn, table, ocilib::TypeInfo::Table);
+		m_dp = std::make_unique<ocilib::DirectPath>(*m_table, static_cast<unsigned int>(columns.size()), rows);
+
+		for (size_t i = 0; i < columns.size(); ++i)
+		{
+			m_dp->SetColumn(static_cast<unsigned int>(i + 1), columns[i].name, columns[i].max_size, columns[i].format);
+		}
+		if (buffer_size > 0)
+		{
+			m_dp->SetBufferSize(buffer_size);
+		}
+		m_dp->SetParallel(parallel);
+		// Rows that do not convert are skipped instead of stopping the array
+		m_dp->SetConversionMode(ocilib::DirectPath::Force);
+		m_dp->Prepare();
+
+		m_columns = columns.size();
+		m_values.assign(m_columns * rows, ocilib::ostring());
+		m_open = true;
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDirectPath::SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length)
+{
+	try
+	{
+		ocilib::ostring& text = m_values.at(row * m_columns + column);
+		text.assign(value ? value : "", value ? length : 0);
+		m_dp->SetEntry(row + 1, column + 1, text);
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDirectPath::Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected)
+{
+	loaded = 0;
+	rejected.clear();
+
+	try
+	{
+		m_dp->SetCurrentRows(rows);
+
+		// A full stream buffer is sent and the conversion goes on where it
+		// stopped, so an array may take several round trips
+		ocilib::DirectPath::ResultValues state = ocilib::DirectPath::ResultFull;
+		while (state == ocilib::DirectPath::ResultFull)
+		{
+			state = m_dp->Convert();
+			for (unsigned int row = m_dp->GetErrorRow(); row != 0; row = m_dp->GetErrorRow())
+			{
+				rejected.push_back(row - 1);
+			}
+			if (state != ocilib::DirectPath::ResultComplete && state != ocilib::DirectPath::ResultFull && state != ocilib::DirectPath::ResultError)
+			{
+				m_driver.SetLastError("Direct path conversion failed");
+				return false;
+			}
+
+			if (m_dp->Load() != ocilib::DirectPath::ResultComplete)
+			{
+				m_driver.SetLastError("Direct path load failed");
+				return false;
+			}
+			loaded += m_dp->GetAffectedRows();
+		}
+
+		m_dp->Reset();
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciCxxDirectPath::Finish()
+{
+	if (!m_open)
+	{
+		return false;
+	}
+	m_open = false;
+
+	try
+	{
+		m_dp->Finish();
+		return true;
+	}
+	catch (...)
+	{
+		return m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciCxxDirectPath::Abort()
+{
+	if (!m_open)
+	{
+		return;
+	}
+	m_open = false;
+
+	try
+	{
+		m_dp->Abort();
+	}
+	catch (...)
+	{
+		m_driver.Fail();
+	}
+}
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
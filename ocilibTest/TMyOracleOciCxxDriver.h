@@ -0,0 +1,165 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEOCICXXDRIVER_H__
+#define __TMYORACLEOCICXXDRIVER_H__
+// -----------------------------------------------------------------------------
+#ifndef TMYORACLE_NO_OCI
+// -----------------------------------------------------------------------------
+#include "ocilib.hpp"
+#include "TMyOracleDriver.h"
+#include "TMyOracleLog.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+class TMyOracleOciCxxPool : public TMyOracleDriverPool
+{
+public:
+	explicit TMyOracleOciCxxPool(std::unique_ptr<ocilib::Pool> pool) : m_pool(std::move(pool)) {}
+	~TMyOracleOciCxxPool() override
+	{
+		try
+		{
+			m_pool->Close();
+		}
+		catch (const std::exception& ex)
+		{
+			TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleOciCxxPool: ", ex.what());
+		}
+	}
+
+	ocilib::Pool& Handle() const { return *m_pool; }
+
+private:
+	std::unique_ptr<ocilib::Pool> m_pool;
+};
+
+// Driver on the OCILIB C++ API. OCILIB exceptions are caught here and
+// reported through GetLastError().
+class TMyOracleOciCxxDriver : public TMyOracleDriver
+{
+public:
+	~TMyOracleOciCxxDriver() override { Disconnect(); }
+
+	bool Connect(const std::string& user, const std::string& password, const std::string& db) override;
+	bool Connect(TMyOracleDriverPool& pool) override;
+	bool Disconnect() override;
+	bool IsConnected() const override;
+	bool Ping() override;
+
+	bool Commit(TMyOracleCommitMode mode) override;
+	bool Rollback() override;
+	bool Break(std::string& error) override;
+
+	void SetAutoCommit(bool enabled) override;
+	void SetStatementCacheSize(unsigned int size) override;
+
+	std::unique_ptr<TMyOracleDriverStatement> CreateStatement() override;
+	std::unique_ptr<TMyOracleDriverDirectPath> CreateDirectPath() override;
+
+	// Stores the message of the exception in flight, returns false
+	bool Fail();
+
+private:
+	std::unique_ptr<ocilib::Connection> m_conn;
+};
+
+class TMyOracleOciCxxDirectPath : public TMyOracleDriverDirectPath
+{
+public:
+	TMyOracleOciCxxDirectPath(TMyOracleOciCxxDriver& driver, const ocilib::Connection& conn) : m_driver(driver), m_conn(conn) {}
+	~TMyOracleOciCxxDirectPath() override { Abort(); }
+
+	bool Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel) override;
+	bool SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length) override;
+	bool Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected) override;
+	bool Finish() override;
+	void Abort() override;
+
+private:
+	TMyOracleOciCxxDriver& m_driver;
+	const ocilib::Connection& m_conn;
+	std::unique_ptr<ocilib::TypeInfo> m_table;
+	std::unique_ptr<ocilib::DirectPath> m_dp;
+	bool m_open = false;
+
+	// SetEntry() takes an ostring and keeps a pointer to its text, the
+	// values are copied here, row by row. An empty string is a NULL.
+	std::vector<ocilib::ostring> m_values;
+	size_t m_columns = 0;
+};
+
+class TMyOracleOciCxxDriverStatement : public TMyOracleDriverStatement
+{
+public:
+	TMyOracleOciCxxDriverStatement(TMyOracleOciCxxDriver& driver, const ocilib::Connection& conn) : m_driver(driver), m_stmt(conn) {}
+
+	void SetFetchSize(unsigned int rows) override;
+	void SetPrefetchSize(unsigned int rows) override;
+	unsigned int GetFetchSize() const override { return m_fetch_size; }
+	void SetBindByPosition() override;
+
+	bool Prepare(const std::string& sql) override;
+
+	bool BindInt64(const std::string& name, int64_t* value) override;
+	bool BindDouble(const std::string& name, double* value) override;
+	bool BindString(const std::string& name, std::string* value, unsigned int capacity) override;
+	void SetBindNull(const std::string& name, bool is_null) override;
+
+	bool Execute() override;
+
+	bool SetBindArraySize(unsigned int size) override;
+	bool BindInt64Array(const std::string& name, int64_t* values) override;
+	bool BindDoubleArray(const std::string& name, double* values) override;
+	bool BindStringArray(const std::string& name, char* values, unsigned int length) override;
+	void SetBindNullAt(const std::string& name, unsigned int row, bool is_null) override;
+	bool ExecuteArray(unsigned int rows) override;
+
+	std::string GetSql() const override;
+	unsigned int GetAffectedRows() const override;
+
+	unsigned int GetColumnCount() const override { return static_cast<unsigned int>(m_types.size()); }
+	std::string GetColumnName(unsigned int index) const override { return m_names.at(index - 1); }
+	TMyOracleColumnType GetColumnType(unsigned int index) const override { return m_types.at(index - 1); }
+
+	bool Fetch() override;
+	bool IsNull(unsigned int index) override { return m_rs->IsColumnNull(index); }
+	int64_t GetInt64(unsigned int index) override { return m_rs->Get<big_int>(index); }
+	double GetDouble(unsigned int index) override { return m_rs->Get<double>(index); }
+	TMyOracleDate GetDate(unsigned int index) override;
+	const char* GetString(unsigned int index, size_t& length) override;
+
+private:
+	// The C++ API binds vectors: the caller arrays are copied into them
+	// before every execute
+	struct ArrayBind
+	{
+		std::string name;
+		int64_t* ints = nullptr;
+		double* doubles = nullptr;
+		char* text = nullptr;
+		unsigned int length = 0;
+		std::vector<big_int> int_values;
+		std::vector<double> double_values;
+		std::vector<ocilib::ostring> text_values;
+	};
+
+	bool BindArray(std::unique_ptr<ArrayBind> bind);
+
+	TMyOracleOciCxxDriver& m_driver;
+	ocilib::Statement m_stmt;
+	// Bound vectors must not move
+	std::vector<std::unique_ptr<ArrayBind>> m_array_binds;
+	unsigned int m_array_size = 0;
+	std::unique_ptr<ocilib::Resultset> m_rs;
+	// OCILIB default
+	unsigned int m_fetch_size = 20;
+
+	std::vector<std::string> m_names;
+	std::vector<TMyOracleColumnType> m_types;
+	// Resultset::Get<ostring>() returns a copy, kept here until the next row
+	std::vector<std::string> m_text;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
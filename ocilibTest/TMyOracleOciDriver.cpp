@@ -0,0 +1,417 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleOciDriver.h"
+// -----------------------------------------------------------------------------
+#ifndef TMYORACLE_NO_OCI
+// -----------------------------------------------------------------------------
+#include <cstring>
+// -----------------------------------------------------------------------------
+static_assert(sizeof(big_int) == sizeof(int64_t), "OCI big_int binds int64_t storage");
+// -----------------------------------------------------------------------------
+// Widest NUMBER held exactly by an int64 and by a double
+static constexpr int MAX_INT64_PRECISION = 18;
+static constexpr int MAX_DOUBLE_PRECISION = 15;
+// -----------------------------------------------------------------------------
+TMyOracleColumnType TMyOracleOciColumnType(unsigned int type, int scale, int precision)
+{
+	switch (type)
+	{
+	case OCI_CDT_NUMERIC:
+		// A NUMBER too wide for an int64 or a double is fetched as its exact
+		// text, converted on access by TMyOracleColumn
+		if (scale == 0 && precision > 0)
+		{
+			// NUMBER(p, 0)
+			return precision <= MAX_INT64_PRECISION ? TMyOracleColumnType::Int64 : TMyOracleColumnType::String;
+		}
+		if (scale == -127)
+		{
+			// FLOAT(b), or NUMBER without precision when b is 0
+			return precision > 0 ? TMyOracleColumnType::Double : TMyOracleColumnType::String;
+		}
+		// NUMBER(p, s), BINARY_FLOAT and BINARY_DOUBLE (precision 0)
+		return precision <= MAX_DOUBLE_PRECISION ? TMyOracleColumnType::Double : TMyOracleColumnType::String;
+	case OCI_CDT_DATETIME:
+		return TMyOracleColumnType::Date;
+	default:
+		return TMyOracleColumnType::String;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Fail()
+{
+	OCI_Error* error = OCI_GetLastError();
+	SetLastError(error ? OCI_ErrorGetString(error) : "Unknown OCI error");
+	return false;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Connect(const std::string& user, const std::string& password, const std::string& db)
+{
+	Disconnect();
+
+	ClearLost();
+	m_Connection = OCI_ConnectionCreate(db.c_str(), user.c_str(), password.c_str(), OCI_SESSION_DEFAULT);
+	return m_Connection ? true : Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Connect(TMyOracleDriverPool& pool)
+{
+	Disconnect();
+
+	TMyOracleOciPool* oci_pool = dynamic_cast<TMyOracleOciPool*>(&pool);
+	if (!oci_pool)
+	{
+		SetLastError("Not an OCI C API session pool");
+		return false;
+	}
+
+	ClearLost();
+	m_Connection = OCI_PoolGetConnection(oci_pool->Handle(), nullptr);
+	return m_Connection ? true : Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Disconnect()
+{
+	if (!m_Connection)
+	{
+		return false;
+	}
+
+	// Closes the session, or gives it back to its pool
+	OCI_ConnectionFree(m_Connection);
+	m_Connection = nullptr;
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Ping()
+{
+	return m_Connection && OCI_Ping(m_Connection) ? true : Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Commit(TMyOracleCommitMode mode)
+{
+	if (mode == TMyOracleCommitMode::Wait)
+	{
+		return m_Connection && OCI_Commit(m_Connection) ? true : Fail();
+	}
+
+	// OCI_Commit() always waits, the durability is chosen in SQL
+	OCI_Statement* stmt = m_Connection ? OCI_StatementCreate(m_Connection) : nullptr;
+	if (!stmt)
+	{
+		return Fail();
+	}
+	// The error is read before the statement goes
+	const bool committed = OCI_ExecuteStmt(stmt, "COMMIT WRITE NOWAIT") ? true : Fail();
+	OCI_StatementFree(stmt);
+	return committed;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Rollback()
+{
+	return m_Connection && OCI_Rollback(m_Connection) ? true : Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriver::Break(std::string& error)
+{
+	if (m_Connection && OCI_Break(m_Connection))
+	{
+		return true;
+	}
+	// The OCILIB errors are per thread (OCI_ENV_CONTEXT), this one is ours
+	OCI_Error* oci_error = OCI_GetLastError();
+	error = oci_error ? OCI_ErrorGetString(oci_error) : "Not connected";
+	return false;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverStatement> TMyOracleOciDriver::CreateStatement()
+{
+	std::unique_ptr<TMyOracleOciDriverStatement> stmt(new TMyOracleOciDriverStatement(*this, m_Connection));
+	if (!stmt->IsCreated())
+	{
+		Fail();
+		return nullptr;
+	}
+	return stmt;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverDirectPath> TMyOracleOciDriver::CreateDirectPath()
+{
+	if (!IsConnected())
+	{
+		SetLastError("Not connected");
+		return nullptr;
+	}
+	return std::make_unique<TMyOracleOciDirectPath>(*this, m_Connection);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciDriverStatement::SetFetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		OCI_SetFetchSize(m_stmt, rows);
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciDriverStatement::SetPrefetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		OCI_SetPrefetchSize(m_stmt, rows);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::Prepare(const std::string& sql)
+{
+	m_rs = nullptr;
+
+	// Array DML in batch error mode: the rows in error are skipped and
+	// reported by ExecuteArray(), the others are applied
+	return OCI_Prepare(m_stmt, sql.c_str()) && OCI_SetBatchErrorMode(m_stmt, TRUE) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindInt64(const std::string& name, int64_t* value)
+{
+	return OCI_BindBigInt(m_stmt, name.c_str(), reinterpret_cast<big_int*>(value)) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindDouble(const std::string& name, double* value)
+{
+	return OCI_BindDouble(m_stmt, name.c_str(), value) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindString(const std::string& name, std::string* value, unsigned int capacity)
+{
+	// The buffer moves with the vector but its storage does not
+	m_string_binds.push_back({ name, value, std::vector<otext>(capacity + 1, 0) });
+	return OCI_BindString(m_stmt, name.c_str(), m_string_binds.back().buffer.data(), capacity) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciDriverStatement::SetBindNull(const std::string& name, bool is_null)
+{
+	OCI_Bind* bind = OCI_GetBind2(m_stmt, name.c_str());
+	is_null ? OCI_BindSetNull(bind) : OCI_BindSetNotNull(bind);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::Execute()
+{
+	for (StringBind& bind : m_string_binds)
+	{
+		const size_t length = std::min(bind.value->size(), bind.buffer.size() - 1);
+		std::copy(bind.value->begin(), bind.value->begin() + length, bind.buffer.begin());
+		bind.buffer[length] = 0;
+	}
+
+	m_rs = nullptr;
+	m_names.clear();
+	m_types.clear();
+
+	if (!OCI_Execute(m_stmt))
+	{
+		return m_driver.Fail();
+	}
+
+	// Describe the columns once, not once per fetched row
+	m_rs = OCI_GetResultset(m_stmt);
+	if (m_rs)
+	{
+		const unsigned int colCount = OCI_GetColumnCount(m_rs);
+		for (unsigned int i = 1; i <= colCount; ++i)
+		{
+			OCI_Column* col = OCI_GetColumn(m_rs, i);
+			m_names.push_back(OCI_ColumnGetName(col));
+			m_types.push_back(TMyOracleOciColumnType(OCI_ColumnGetType(col), OCI_ColumnGetScale(col), OCI_ColumnGetPrecision(col)));
+		}
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::SetBindArraySize(unsigned int size)
+{
+	m_array_size = size;
+	return OCI_BindArraySetSize(m_stmt, size) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindInt64Array(const std::string& name, int64_t* values)
+{
+	// 0 elements: the size set by OCI_BindArraySetSize()
+	return OCI_BindArrayOfBigInts(m_stmt, name.c_str(), reinterpret_cast<big_int*>(values), 0) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindDoubleArray(const std::string& name, double* values)
+{
+	return OCI_BindArrayOfDoubles(m_stmt, name.c_str(), values, 0) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::BindStringArray(const std::string& name, char* values, unsigned int length)
+{
+	return OCI_BindArrayOfStrings(m_stmt, name.c_str(), values, length, 0) ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciDriverStatement::SetBindNullAt(const std::string& name, unsigned int row, bool is_null)
+{
+	OCI_Bind* bind = OCI_GetBind2(m_stmt, name.c_str());
+	is_null ? OCI_BindSetNullAtPos(bind, row + 1) : OCI_BindSetNotNullAtPos(bind, row + 1);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::ExecuteArray(unsigned int rows)
+{
+	m_batch_errors.clear();
+	m_rs = nullptr;
+
+	// The array size can shrink below the bound size for a partial batch
+	if (rows != m_array_size && !SetBindArraySize(rows))
+	{
+		return false;
+	}
+
+	const bool executed = OCI_Execute(m_stmt);
+
+	for (OCI_Error* error = OCI_GetBatchError(m_stmt); error; error = OCI_GetBatchError(m_stmt))
+	{
+		m_batch_errors.push_back({ OCI_ErrorGetRow(error) - 1, OCI_ErrorGetOCICode(error), OCI_ErrorGetString(error) });
+	}
+
+	return executed || !m_batch_errors.empty() ? true : m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDriverStatement::Fetch()
+{
+	if (m_rs && OCI_FetchNext(m_rs))
+	{
+		return true;
+	}
+
+	// OCILIB clears the error of the thread on every call
+	m_fetch_failed = OCI_GetLastError() != nullptr;
+	if (m_fetch_failed)
+	{
+		m_driver.Fail();
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+TMyOracleDate TMyOracleOciDriverStatement::GetDate(unsigned int index)
+{
+	int y = 0, m = 0, d = 0, h = 0, mi = 0, s = 0;
+	OCI_DateGetDateTime(OCI_GetDate(m_rs, index), &y, &m, &d, &h, &mi, &s);
+	return TMyOracleDate::Make(y, m, d, h, mi, s);
+}
+// -----------------------------------------------------------------------------
+const char* TMyOracleOciDriverStatement::GetString(unsigned int index, size_t& length)
+{
+	const otext* str = OCI_GetString(m_rs, index);
+	length = str ? std::strlen(str) : 0;
+	return str ? str : "";
+}
+// -----------------------------------------------------------------------------
+TMyOracleOciDirectPath::~TMyOracleOciDirectPath()
+{
+	Abort();
+	if (m_dp)
+	{
+		OCI_DirPathFree(m_dp);
+	}
+	if (m_table)
+	{
+		OCI_TypeInfoFree(m_table);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDirectPath::Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel)
+{
+	m_table = OCI_TypeInfoGet(m_conn, table.c_str(), OCI_TIF_TABLE);
+	if (!m_table)
+	{
+		return m_driver.Fail();
+	}
+
+	m_dp = OCI_DirPathCreate(m_table, nullptr, static_cast<unsigned int>(columns.size()), rows);
+	if (!m_dp)
+	{
+		return m_driver.Fail();
+	}
+
+	for (size_t i = 0; i < columns.size(); ++i)
+	{
+		const TMyOracleDirectPathColumn& column = columns[i];
+		if (!OCI_DirPathSetColumn(m_dp, static_cast<unsigned int>(i + 1), column.name.c_str(), column.max_size, column.format.empty() ? nullptr : column.format.c_str()))
+		{
+			return m_driver.Fail();
+		}
+	}
+
+	// Rows that do not convert are skipped instead of stopping the array
+	if ((buffer_size > 0 && !OCI_DirPathSetBufferSize(m_dp, buffer_size)) ||
+		!OCI_DirPathSetParallel(m_dp, parallel) ||
+		!OCI_DirPathSetConvertMode(m_dp, OCI_DCM_FORCE) ||
+		!OCI_DirPathPrepare(m_dp))
+	{
+		return m_driver.Fail();
+	}
+
+	m_open = true;
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDirectPath::SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length)
+{
+	return OCI_DirPathSetEntry(m_dp, row + 1, column + 1, const_cast<char*>(value), value ? length : 0, TRUE) || m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDirectPath::Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected)
+{
+	loaded = 0;
+	rejected.clear();
+
+	if (!OCI_DirPathSetCurrentRows(m_dp, rows))
+	{
+		return m_driver.Fail();
+	}
+
+	// A full stream buffer is sent and the conversion goes on where it
+	// stopped, so an array may take several round trips
+	unsigned int state = OCI_DPR_FULL;
+	while (state == OCI_DPR_FULL)
+	{
+		state = OCI_DirPathConvert(m_dp);
+		for (unsigned int row = OCI_DirPathGetErrorRow(m_dp); row != 0; row = OCI_DirPathGetErrorRow(m_dp))
+		{
+			rejected.push_back(row - 1);
+		}
+		if (state != OCI_DPR_COMPLETE && state != OCI_DPR_FULL && state != OCI_DPR_ERROR)
+		{
+			return m_driver.Fail();
+		}
+
+		if (OCI_DirPathLoad(m_dp) != OCI_DPR_COMPLETE)
+		{
+			return m_driver.Fail();
+		}
+		loaded += OCI_DirPathGetAffectedRows(m_dp);
+	}
+
+	return OCI_DirPathReset(m_dp) || m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleOciDirectPath::Finish()
+{
+	if (!m_open)
+	{
+		return false;
+	}
+	m_open = false;
+	return OCI_DirPathFinish(m_dp) || m_driver.Fail();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleOciDirectPath::Abort()
+{
+	if (m_open)
+	{
+		m_open = false;
+		OCI_DirPathAbort(m_dp);
+	}
+}
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,177 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEOCIDRIVER_H__
+#define __TMYORACLEOCIDRIVER_H__
+// -----------------------------------------------------------------------------
+#ifndef TMYORACLE_NO_OCI
+// -----------------------------------------------------------------------------
+#include "ocilib.hpp"
+#include "TMyOracleDriver.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+// NUMBER(p,0) is kept as int64, any other NUMBER as double. Shared with the
+// OCILIB C++ driver.
+TMyOracleColumnType TMyOracleOciColumnType(unsigned int type, int scale, int precision);
+// -----------------------------------------------------------------------------
+class TMyOracleStatement
+{
+	OCI_Statement* stmt = nullptr;
+public:
+	explicit TMyOracleStatement(OCI_Connection* conn)
+	{
+		if (conn && OCI_IsConnected(conn))
+		{
+			stmt = OCI_StatementCreate(conn);
+			if (!stmt)
+			{
+				stmt = nullptr;
+			}
+		}
+	}
+	~TMyOracleStatement() { if (stmt) OCI_StatementFree(stmt); }
+
+	// Prevent copying
+	TMyOracleStatement(const TMyOracleStatement&) = delete;
+	TMyOracleStatement& operator=(const TMyOracleStatement&) = delete;
+
+	// Allow moving
+	TMyOracleStatement(TMyOracleStatement&& other) noexcept : stmt(other.stmt) { other.stmt = nullptr; }
+
+	operator OCI_Statement* () const { return stmt; }
+
+};
+
+class TMyOracleOciPool : public TMyOracleDriverPool
+{
+public:
+	explicit TMyOracleOciPool(OCI_Pool* pool) : m_pool(pool) {}
+	~TMyOracleOciPool() override { OCI_PoolFree(m_pool); }
+
+	OCI_Pool* Handle() const { return m_pool; }
+
+private:
+	OCI_Pool* m_pool;
+};
+
+// Driver on the OCILIB C API
+class TMyOracleOciDriver : public TMyOracleDriver
+{
+public:
+	~TMyOracleOciDriver() override { Disconnect(); }
+
+	bool Connect(const std::string& user, const std::string& password, const std::string& db) override;
+	bool Connect(TMyOracleDriverPool& pool) override;
+	bool Disconnect() override;
+	bool IsConnected() const override { return m_Connection && OCI_IsConnected(m_Connection) && !IsLost(); }
+	bool Ping() override;
+
+	bool Commit(TMyOracleCommitMode mode) override;
+	bool Rollback() override;
+	bool Break(std::string& error) override;
+
+	void SetAutoCommit(bool enabled) override { OCI_SetAutoCommit(m_Connection, enabled); }
+	void SetStatementCacheSize(unsigned int size) override { OCI_SetStatementCacheSize(m_Connection, size); }
+
+	std::unique_ptr<TMyOracleDriverStatement> CreateStatement() override;
+	std::unique_ptr<TMyOracleDriverDirectPath> CreateDirectPath() override;
+
+	// Stores the last OCILIB error of this thread, returns false
+	bool Fail();
+
+private:
+	OCI_Connection* m_Connection = nullptr;
+};
+
+class TMyOracleOciDirectPath : public TMyOracleDriverDirectPath
+{
+public:
+	TMyOracleOciDirectPath(TMyOracleOciDriver& driver, OCI_Connection* conn) : m_driver(driver), m_conn(conn) {}
+	~TMyOracleOciDirectPath() override;
+
+	// Prevent copying
+	TMyOracleOciDirectPath(const TMyOracleOciDirectPath&) = delete;
+	TMyOracleOciDirectPath& operator=(const TMyOracleOciDirectPath&) = delete;
+
+	bool Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel) override;
+	bool SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length) override;
+	bool Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected) override;
+	bool Finish() override;
+	void Abort() override;
+
+private:
+	TMyOracleOciDriver& m_driver;
+	OCI_Connection* m_conn;
+	OCI_TypeInfo* m_table = nullptr;
+	OCI_DirPath* m_dp = nullptr;
+	// Prepared and neither finished nor aborted
+	bool m_open = false;
+};
+
+class TMyOracleOciDriverStatement : public TMyOracleDriverStatement
+{
+public:
+	TMyOracleOciDriverStatement(TMyOracleOciDriver& driver, OCI_Connection* conn) : m_driver(driver), m_stmt(conn) {}
+
+	bool IsCreated() const { return m_stmt != nullptr; }
+
+	void SetFetchSize(unsigned int rows) override;
+	void SetPrefetchSize(unsigned int rows) override;
+	unsigned int GetFetchSize() const override { return OCI_GetFetchSize(m_stmt); }
+	void SetBindByPosition() override { OCI_SetBindMode(m_stmt, OCI_BIND_BY_POS); }
+
+	bool Prepare(const std::string& sql) override;
+
+	bool BindInt64(const std::string& name, int64_t* value) override;
+	bool BindDouble(const std::string& name, double* value) override;
+	bool BindString(const std::string& name, std::string* value, unsigned int capacity) override;
+	void SetBindNull(const std::string& name, bool is_null) override;
+
+	bool Execute() override;
+
+	bool SetBindArraySize(unsigned int size) override;
+	bool BindInt64Array(const std::string& name, int64_t* values) override;
+	bool BindDoubleArray(const std::string& name, double* values) override;
+	bool BindStringArray(const std::string& name, char* values, unsigned int length) override;
+	void SetBindNullAt(const std::string& name, unsigned int row, bool is_null) override;
+	bool ExecuteArray(unsigned int rows) override;
+
+	std::string GetSql() const override { return OCI_GetSql(m_stmt); }
+	unsigned int GetAffectedRows() const override { return OCI_GetAffectedRows(m_stmt); }
+
+	unsigned int GetColumnCount() const override { return static_cast<unsigned int>(m_types.size()); }
+	std::string GetColumnName(unsigned int index) const override { return m_names.at(index - 1); }
+	TMyOracleColumnType GetColumnType(unsigned int index) const override { return m_types.at(index - 1); }
+
+	bool Fetch() override;
+	bool IsNull(unsigned int index) override { return OCI_IsNull(m_rs, index); }
+	int64_t GetInt64(unsigned int index) override { return OCI_GetBigInt(m_rs, index); }
+	double GetDouble(unsigned int index) override { return OCI_GetDouble(m_rs, index); }
+	TMyOracleDate GetDate(unsigned int index) override;
+	const char* GetString(unsigned int index, size_t& length) override;
+
+private:
+	// OCI reads the values from these buffers, they are copied in before
+	// every execute
+	struct StringBind
+	{
+		std::string name;
+		std::string* value;
+		std::vector<otext> buffer;
+	};
+
+	TMyOracleOciDriver& m_driver;
+	TMyOracleStatement m_stmt;
+	OCI_Resultset* m_rs = nullptr;
+
+	std::vector<StringBind> m_string_binds;
+	// Current OCI_BindArraySetSize()
+	unsigned int m_array_size = 0;
+
+	std::vector<std::string> m_names;
+	std::vector<TMyOracleColumnType> m_types;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,402 @@
+// -----------------------------------------------------------------------------
+#include "TMyOraclePreparedStatement.h"
+#include "TMyOracleLog.h"
+#include <cctype>
+// -----------------------------------------------------------------------------
+// Smallest string bind buffer, so that short values of varying length do not
+// force a new prepare
+static constexpr unsigned int MIN_STRING_BIND_SIZE = 64;
+// -----------------------------------------------------------------------------
+enum TMyOracleValueIndex : size_t
+{
+	VALUE_NULL = 0,
+	VALUE_INT64 = 1,
+	VALUE_DOUBLE = 2,
+	VALUE_STRING = 3
+};
+// -----------------------------------------------------------------------------
+TMyOraclePreparedStatement::TMyOraclePreparedStatement(TMyOracle* owner, const std::string& sql)
+	: m_owner{ owner }, m_sql{ sql }, m_read_only{ TMyOracle::IsReadOnly(sql) }
+{
+}
+// -----------------------------------------------------------------------------
+TMyOraclePreparedStatement::~TMyOraclePreparedStatement()
+{
+	Release();
+}
+// -----------------------------------------------------------------------------
+void TMyOraclePreparedStatement::Release()
+{
+	m_stmt.reset();
+	m_slots.clear();
+	m_mapping = nullptr;
+	m_positions.clear();
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Matches(const TMyOracleBinds& binds) const
+{
+	if (!m_stmt)
+	{
+		return false;
+	}
+	if (binds.size() != m_slots.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < binds.size(); ++i)
+	{
+		const TMyOracleBind& bind = binds[i];
+		const Slot& slot = m_slots[i];
+
+		if (!bind.name.empty() && bind.name != slot.name)
+		{
+			return false;
+		}
+
+		// NULL can go into any slot, anything else needs a slot of its type
+		const size_t type = bind.value.index();
+		if (type == VALUE_NULL)
+		{
+			continue;
+		}
+		if (type != slot.type)
+		{
+			return false;
+		}
+		if (type == VALUE_STRING && std::get<std::string>(bind.value).size() > slot.capacity)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Prepare(const TMyOracleBinds& binds)
+{
+	Release();
+	++m_prepares;
+
+	bool by_position = false;
+
+	m_slots.resize(binds.size());
+	for (size_t i = 0; i < binds.size(); ++i)
+	{
+		Slot& slot = m_slots[i];
+
+		by_position |= binds[i].name.empty();
+		slot.name = binds[i].name.empty() ? ":" + std::to_string(i + 1) : binds[i].name;
+		slot.type = binds[i].value.index();
+
+		// A NULL with no type yet binds as an empty string
+		if (slot.type == VALUE_NULL || slot.type == VALUE_STRING)
+		{
+			const size_t length = slot.type == VALUE_STRING ? std::get<std::string>(binds[i].value).size() : 0;
+			slot.capacity = static_cast<unsigned int>(std::max<size_t>(MIN_STRING_BIND_SIZE, length * 2));
+		}
+	}
+
+	TMyOracleDriver* driver = m_owner->m_driver.get();
+	m_stmt = driver->CreateStatement();
+	if (!m_stmt)
+	{
+		m_owner->m_lst_error = driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_owner->m_conn_instance_counter, "] Failed to create statement: ", m_owner->m_lst_error);
+		return false;
+	}
+
+	if (by_position)
+	{
+		m_stmt->SetBindByPosition();
+	}
+
+	if (!m_stmt->Prepare(m_sql))
+	{
+		m_owner->m_lst_error = driver->GetLastError();
+		TMYORACLE_LOG_ERROR("[", m_owner->m_conn_instance_counter, "] Failed to prepare statement: ", m_owner->m_lst_error);
+		Release();
+		return false;
+	}
+
+	for (Slot& slot : m_slots)
+	{
+		bool bound = false;
+
+		switch (slot.type)
+		{
+		case VALUE_INT64:
+			bound = m_stmt->BindInt64(slot.name, &slot.number);
+			break;
+		case VALUE_DOUBLE:
+			bound = m_stmt->BindDouble(slot.name, &slot.real);
+			break;
+		default:
+			slot.text.reserve(slot.capacity);
+			bound = m_stmt->BindString(slot.name, &slot.text, slot.capacity);
+			break;
+		}
+
+		if (!bound)
+		{
+			m_owner->m_lst_error = driver->GetLastError();
+			TMYORACLE_LOG_ERROR("[", m_owner->m_conn_instance_counter, "] Failed to bind ", slot.name, ": ", m_owner->m_lst_error);
+			Release();
+			return false;
+		}
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOraclePreparedStatement::Assign(const TMyOracleBinds& binds)
+{
+	for (size_t i = 0; i < binds.size(); ++i)
+	{
+		const TMyOracleValue& value = binds[i].value;
+		Slot& slot = m_slots[i];
+		const bool is_null = value.index() == VALUE_NULL;
+
+		switch (value.index())
+		{
+		case VALUE_INT64:
+			slot.number = std::get<int64_t>(value);
+			break;
+		case VALUE_DOUBLE:
+			slot.real = std::get<double>(value);
+			break;
+		case VALUE_STRING:
+			slot.text = std::get<std::string>(value);
+			break;
+		default:
+			break;
+		}
+
+		m_stmt->SetBindNull(slot.name, is_null);
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOraclePreparedStatement::ExecuteQuery(const TMyOracleBinds& binds, unsigned int fetch_size, unsigned int prefetch_size)
+{
+	TMyOracleQueryTimer timer(&m_owner->m_metrics);
+	TMyOracle::CallLock lock(*m_owner);
+	timer.Lap(TMyOraclePhase::MUTEX_WAIT);
+	return Execute(binds, fetch_size, prefetch_size, timer);
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Run(const TMyOracleBinds& binds, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer)
+{
+	TMyOracle& owner = *m_owner;
+
+	if (fetch_size == 0)
+	{
+		fetch_size = owner.m_fetch_size;
+	}
+	if (prefetch_size == 0)
+	{
+		prefetch_size = owner.m_prefetch_size;
+	}
+
+	TMyOracleDriver* driver = owner.m_driver.get();
+	if (!driver || !driver->IsConnected())
+	{
+		TMYORACLE_LOG_ERROR("[", owner.m_conn_instance_counter, "] Not connected to database");
+		timer.Fail();
+		return false;
+	}
+
+	// Binding the new values is charged to prepare, the statement itself is
+	// only prepared when the bind layout changed
+	if (!Matches(binds) && !Prepare(binds))
+	{
+		timer.Fail();
+		return false;
+	}
+	Assign(binds);
+
+	// Rows per fetch round trip and rows prefetched by the client
+	if (fetch_size > 0)
+	{
+		m_stmt->SetFetchSize(fetch_size);
+	}
+	if (prefetch_size > 0)
+	{
+		m_stmt->SetPrefetchSize(prefetch_size);
+	}
+
+	timer.Lap(TMyOraclePhase::PREPARE);
+
+	// Execute the statement
+	const bool executed = m_stmt->Execute();
+	timer.Lap(TMyOraclePhase::EXECUTE);
+	timer.AddRoundTrips(1);
+	if (!executed)
+	{
+		owner.m_lst_error = driver->GetLastError();
+		owner.LogCallError("execute statement");
+		timer.Fail();
+
+		// The statement may be unusable, prepare it again next time
+		Release();
+
+		owner.EndStatement(m_sql, m_read_only, false, timer);
+		return false;
+	}
+
+	++m_executions;
+	owner.m_lst_query = m_sql;
+	return owner.EndStatement(m_sql, m_read_only, true, timer);
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOraclePreparedStatement::Execute(const TMyOracleBinds& binds, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer)
+{
+	if (!Run(binds, fetch_size, prefetch_size, timer))
+	{
+		return nullptr;
+	}
+
+	TMyOracle& owner = *m_owner;
+	TMyOracleDriver* driver = owner.m_driver.get();
+
+	TMyOracleResultSet* result_set = TMyOracleResultSet::ExtractResultSet(*m_stmt, m_stmt->GetFetchSize(), &timer);
+	if (!result_set && m_stmt->FetchFailed())
+	{
+		owner.m_lst_error = driver->GetLastError();
+		owner.LogCallError("fetch");
+	}
+	return result_set;
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Execute(const TMyOracleBinds& binds, size_t& affected, TMyOracleQueryTimer& timer)
+{
+	affected = 0;
+	if (!Run(binds, 0, 0, timer))
+	{
+		return false;
+	}
+
+	affected = m_stmt->GetAffectedRows();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Resolve(const TMyOracleRowReader& reader)
+{
+	auto EqualsNoCase = [](const std::string& a, const char* b)
+	{
+		size_t i = 0;
+		for (; i < a.size() && b[i]; ++i)
+		{
+			if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i])))
+			{
+				return false;
+			}
+		}
+		return i == a.size() && !b[i];
+	};
+
+	m_mapping = nullptr;
+	m_positions.assign(reader.Fields(), 0);
+
+	const unsigned int columns = m_stmt->GetColumnCount();
+	std::vector<std::string> names;
+	names.reserve(columns);
+	for (unsigned int index = 1; index <= columns; ++index)
+	{
+		names.push_back(m_stmt->GetColumnName(index));
+	}
+
+	for (size_t field = 0; field < m_positions.size(); ++field)
+	{
+		const char* column = reader.Column(field);
+		for (unsigned int index = 0; index < columns; ++index)
+		{
+			if (EqualsNoCase(names[index], column))
+			{
+				m_positions[field] = index + 1;
+				break;
+			}
+		}
+		if (m_positions[field] == 0)
+		{
+			m_owner->m_lst_error = std::string("Column ") + column + " is not selected by the query";
+			TMYORACLE_LOG_ERROR("TMyOraclePreparedStatement::Resolve: ", m_owner->m_lst_error);
+			return false;
+		}
+	}
+
+	m_mapping = reader.Mapping();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOraclePreparedStatement::Execute(const TMyOracleBinds& binds, TMyOracleRowReader& reader, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer)
+{
+	if (!Run(binds, fetch_size, prefetch_size, timer))
+	{
+		return false;
+	}
+
+	TMyOracle& owner = *m_owner;
+	TMyOracleDriver* driver = owner.m_driver.get();
+
+	if (m_stmt->GetColumnCount() == 0)
+	{
+		owner.m_lst_error = "Statement returned no resultset";
+		TMYORACLE_LOG_ERROR("TMyOraclePreparedStatement::Execute: ", owner.m_lst_error);
+		timer.Fail();
+		return false;
+	}
+
+	// Column names are compared once per statement and mapping, not per row
+	if (m_mapping != reader.Mapping() && !Resolve(reader))
+	{
+		timer.Fail();
+		return false;
+	}
+
+	// Without metrics the loop reads no clock
+	TMyOracleQueryTimer* lap = timer.Enabled() ? &timer : nullptr;
+	const unsigned int fetch_rows = m_stmt->GetFetchSize() > 0 ? m_stmt->GetFetchSize() : 1;
+
+	size_t rows = 0;
+	size_t bytes = 0;
+	size_t round_trips = 0;
+
+	reader.Begin();
+	while (m_stmt->Fetch())
+	{
+		if (lap)
+		{
+			lap->Lap(TMyOraclePhase::FETCH);
+		}
+		if (rows % fetch_rows == 0)
+		{
+			++round_trips;
+		}
+
+		bytes += reader.Read(*m_stmt, m_positions);
+		++rows;
+
+		if (lap)
+		{
+			lap->Lap(TMyOraclePhase::CONVERT);
+		}
+	}
+	reader.End(rows);
+
+	if (lap)
+	{
+		lap->Lap(TMyOraclePhase::FETCH);
+		lap->AddRows(rows, bytes);
+		lap->AddRoundTrips(round_trips);
+	}
+
+	if (m_stmt->FetchFailed())
+	{
+		owner.m_lst_error = driver->GetLastError();
+		owner.LogCallError("fetch");
+		timer.Fail();
+		return false;
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
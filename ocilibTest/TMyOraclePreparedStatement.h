@@ -0,0 +1,88 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEPREPAREDSTATEMENT_H__
+#define __TMYORACLEPREPAREDSTATEMENT_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include "TMyOracleResultSet.h"
+#include "TMyOracleRowMapping.h"
+// -----------------------------------------------------------------------------
+
+// A statement kept prepared on one connection, see TMyOracle::Prepare().
+//
+// The bind variables point at storage owned by this object, so executing
+// again only copies the new values in: there is no new statement, no new
+// parse and no new bind. The statement is prepared again only when the bind
+// layout changes (other names or types, or a string longer than its buffer).
+class TMyOraclePreparedStatement
+{
+	friend class TMyOracle;
+
+public:
+	~TMyOraclePreparedStatement();
+
+	// Prevent copying
+	TMyOraclePreparedStatement(const TMyOraclePreparedStatement&) = delete;
+	TMyOraclePreparedStatement& operator=(const TMyOraclePreparedStatement&) = delete;
+
+	// Binds the values and executes on the owning connection. 0 sizes use the
+	// connection defaults. Returns nullptr on failure.
+	TMyOracleResultSet* ExecuteQuery(const TMyOracleBinds& binds, unsigned int fetch_size = 0, unsigned int prefetch_size = 0);
+
+	const std::string& GetSql() const { return m_sql; }
+	size_t Executions() const { return m_executions; }
+	size_t Prepares() const { return m_prepares; }
+
+private:
+	TMyOraclePreparedStatement(TMyOracle* owner, const std::string& sql);
+
+	// Same as ExecuteQuery() but the caller holds the connection mutex and
+	// times the query
+	TMyOracleResultSet* Execute(const TMyOracleBinds& binds, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer);
+	// Same, decoding the rows with reader instead of into a result set
+	bool Execute(const TMyOracleBinds& binds, TMyOracleRowReader& reader, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer);
+	// Same for a statement without rows, affected receives the rows written
+	bool Execute(const TMyOracleBinds& binds, size_t& affected, TMyOracleQueryTimer& timer);
+
+	// Binds, executes and commits a write (see TMyOracle::EndStatement()),
+	// the statement is then ready to fetch
+	bool Run(const TMyOracleBinds& binds, unsigned int fetch_size, unsigned int prefetch_size, TMyOracleQueryTimer& timer);
+	// Positions of the columns of reader in the statement
+	bool Resolve(const TMyOracleRowReader& reader);
+
+	bool Matches(const TMyOracleBinds& binds) const;
+	bool Prepare(const TMyOracleBinds& binds);
+	void Assign(const TMyOracleBinds& binds);
+	void Release();
+
+	// Storage a bind variable points at
+	struct Slot
+	{
+		std::string name;
+		size_t type = 0;		// TMyOracleValue index
+		int64_t number = 0;
+		double real = 0.0;
+		std::string text;
+		unsigned int capacity = 0;	// max string length
+	};
+
+	TMyOracle* m_owner;
+	std::string m_sql;
+	// See TMyOracle::IsReadOnly()
+	bool m_read_only;
+
+	std::unique_ptr<TMyOracleDriverStatement> m_stmt;
+
+	// Sized once per prepare so that bound addresses never move
+	std::vector<Slot> m_slots;
+
+	// Column positions of the last row mapping, see TMyOracleRowReader
+	const void* m_mapping = nullptr;
+	std::vector<unsigned int> m_positions;
+
+	size_t m_executions = 0;
+	size_t m_prepares = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,214 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleReferenceCache.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <cctype>
+// -----------------------------------------------------------------------------
+static bool EqualsNoCase(const std::string& a, const std::string& b)
+{
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+	{
+		return std::toupper(static_cast<unsigned char>(x)) == std::toupper(static_cast<unsigned char>(y));
+	});
+}
+// -----------------------------------------------------------------------------
+TMyOracleReferenceTable::TMyOracleReferenceTable(const std::string& name, std::unique_ptr<TMyOracleResultSet> rows, const std::string& key_column, uint64_t version)
+	: m_name(name), m_rows(std::move(rows)), m_version(version), m_loaded_at(std::chrono::system_clock::now())
+{
+	if (!m_rows)
+	{
+		return;
+	}
+
+	const size_t key = m_rows->FindColumn(key_column);
+	if (key >= m_rows->Columns())
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceTable: Key column ", key_column, " is not selected from ", m_name);
+		m_rows.reset();
+		return;
+	}
+
+	const TMyOracleColumn& column = m_rows->m_columns[key];
+	m_index.reserve(m_rows->Rows());
+	for (size_t row = 0; row < m_rows->Rows(); ++row)
+	{
+		if (!column.IsNull(row))
+		{
+			m_index.emplace(column.GetInt64(row), row);
+		}
+	}
+}
+// -----------------------------------------------------------------------------
+size_t TMyOracleReferenceTable::FindColumn(const std::string& name) const
+{
+	if (!m_rows)
+	{
+		return npos;
+	}
+
+	const size_t column = m_rows->FindColumn(name);
+	return column < m_rows->Columns() ? column : npos;
+}
+// -----------------------------------------------------------------------------
+std::string TMyOracleReferenceTable::GetString(int64_t key, size_t column) const
+{
+	const size_t row = Find(key);
+	if (row == npos || !m_rows || column >= m_rows->Columns())
+	{
+		return std::string();
+	}
+	return m_rows->m_columns[column].GetString(row);
+}
+// -----------------------------------------------------------------------------
+int64_t TMyOracleReferenceTable::GetInt64(int64_t key, size_t column) const
+{
+	const size_t row = Find(key);
+	if (row == npos || !m_rows || column >= m_rows->Columns())
+	{
+		return 0;
+	}
+	return m_rows->m_columns[column].GetInt64(row);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleReferenceCache::AddTable(const std::string& name, const std::string& key_column, const std::string& query)
+{
+	if (m_started)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::AddTable: ", name, " declared after the first load");
+		return false;
+	}
+
+	const std::string table = std::to_upper(name);
+	if (std::any_of(m_slots.begin(), m_slots.end(), [&table](const auto& slot) { return slot->name == table; }))
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::AddTable: ", name, " is already declared");
+		return false;
+	}
+
+	auto slot = std::make_unique<Slot>();
+	slot->name = table;
+	slot->key_column = key_column;
+	slot->query = query.empty() ? "SELECT * FROM " + name : query;
+	m_slots.push_back(std::move(slot));
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleReferenceCache::Load(TMyOracle* sql, Slot& slot)
+{
+	// Not through the result cache: the point is to read the table again
+	std::unique_ptr<TMyOracleResultSet> rows(sql->ExecuteQuery(slot.query));
+	if (!rows)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::Load: Failed to read ", slot.name, ": ", sql->GetLastError());
+		return false;
+	}
+
+	auto table = std::make_shared<const TMyOracleReferenceTable>(slot.name, std::move(rows), slot.key_column, slot.loads + 1);
+	if (table->Size() == 0 && slot.table.load())
+	{
+		// Keep the rows we have rather than replacing them with nothing
+		TMYORACLE_LOG_WARN("TMyOracleReferenceCache::Load: ", slot.name, " came back empty, keeping version ", slot.table.load()->Version());
+		return false;
+	}
+
+	slot.table.store(std::move(table));
+	++slot.loads;
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleReferenceCache::Load(TMyOracle* sql)
+{
+	if (!sql)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::Load: SQL connection is null");
+		return false;
+	}
+
+	m_started = true;
+	std::lock_guard<std::mutex> lock(m_load_mutex);
+
+	bool success = true;
+	for (auto& slot : m_slots)
+	{
+		success &= Load(sql, *slot);
+	}
+	return success;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleReferenceCache::Load(TMyOracle* sql, const std::string& name)
+{
+	if (!sql)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::Load: SQL connection is null");
+		return false;
+	}
+
+	m_started = true;
+	std::lock_guard<std::mutex> lock(m_load_mutex);
+
+	for (auto& slot : m_slots)
+	{
+		if (EqualsNoCase(slot->name, name))
+		{
+			return Load(sql, *slot);
+		}
+	}
+
+	TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::Load: ", name, " is not declared");
+	return false;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleReferenceCache::Load(SqlConnection& pool)
+{
+	SqlConnectionLease sql = pool.Acquire();
+	if (!sql)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleReferenceCache::Load: No connection available");
+		return false;
+	}
+	return Load(sql.get());
+}
+// -----------------------------------------------------------------------------
+TMyOracleReferenceCache::Table TMyOracleReferenceCache::Get(const std::string& name) const
+{
+	for (const auto& slot : m_slots)
+	{
+		if (EqualsNoCase(slot->name, name))
+		{
+			return slot->table.load();
+		}
+	}
+	return nullptr;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleReferenceCache::StartRefresh(SqlConnection& pool, std::chrono::milliseconds interval)
+{
+	StopRefresh();
+
+	m_stop = false;
+	m_refresh = std::thread([this, &pool, interval]()
+	{
+		std::unique_lock<std::mutex> lock(m_refresh_mutex);
+		while (!m_refresh_cv.wait_for(lock, interval, [this]() { return m_stop; }))
+		{
+			lock.unlock();
+			Load(pool);
+			lock.lock();
+		}
+	});
+}
+// -----------------------------------------------------------------------------
+void TMyOracleReferenceCache::StopRefresh()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_refresh_mutex);
+		m_stop = true;
+	}
+	m_refresh_cv.notify_all();
+
+	if (m_refresh.joinable())
+	{
+		m_refresh.join();
+	}
+}
+// -----------------------------------------------------------------------------
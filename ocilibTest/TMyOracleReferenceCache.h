@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEREFERENCECACHE_H__
+#define __TMYORACLEREFERENCECACHE_H__
+// -----------------------------------------------------------------------------
+#include "SqlConnection.h"
+#include "TMyOracleResultSet.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Immutable copy of a small table, indexed by its key column. Snapshots are
+// shared by every reader and never change once built.
+class TMyOracleReferenceTable
+{
+public:
+	static constexpr size_t npos = static_cast<size_t>(-1);
+
+	// nullptr rows or a key column that is not selected make an empty table
+	TMyOracleReferenceTable(const std::string& name, std::unique_ptr<TMyOracleResultSet> rows, const std::string& key_column, uint64_t version);
+
+	const std::string& Name() const { return m_name; }
+	size_t Size() const { return m_rows ? m_rows->Rows() : 0; }
+	// Incremented by every load that replaced the table
+	uint64_t Version() const { return m_version; }
+	std::chrono::system_clock::time_point LoadedAt() const { return m_loaded_at; }
+
+	// Row of the key, npos when there is none
+	size_t Find(int64_t key) const
+	{
+		auto it = m_index.find(key);
+		return it != m_index.end() ? it->second : npos;
+	}
+	bool Contains(int64_t key) const { return Find(key) != npos; }
+
+	// Index of the column, npos when there is none by that name
+	size_t FindColumn(const std::string& name) const;
+
+	// Value of a column for the key, empty / 0 when either is unknown
+	std::string GetString(int64_t key, size_t column) const;
+	int64_t GetInt64(int64_t key, size_t column) const;
+	std::string GetString(int64_t key, const std::string& column) const { return GetString(key, FindColumn(column)); }
+	int64_t GetInt64(int64_t key, const std::string& column) const { return GetInt64(key, FindColumn(column)); }
+
+private:
+	std::string m_name;
+	// Only read through the const column accessors, which keep no position
+	std::unique_ptr<TMyOracleResultSet> m_rows;
+	std::unordered_map<int64_t, size_t> m_index;
+	uint64_t m_version;
+	std::chrono::system_clock::time_point m_loaded_at;
+};
+
+// Small, rarely changing tables (DEPARTMENT) replicated on the client so
+// that queries can drop their join to them and look the rows up in memory.
+//
+// Tables are declared with AddTable() before the first Load(). A load reads
+// the whole table into a new snapshot and swaps it in atomically: readers
+// never wait for a load, they keep the snapshot they got from Get() for as
+// long as they hold it, and the old snapshot goes away with its last reader.
+// Tables are reloaded on demand with Load(), or every interval by the
+// StartRefresh() thread.
+class TMyOracleReferenceCache
+{
+public:
+	using Table = std::shared_ptr<const TMyOracleReferenceTable>;
+
+	TMyOracleReferenceCache() = default;
+	~TMyOracleReferenceCache() { StopRefresh(); }
+
+	// Prevent copying
+	TMyOracleReferenceCache(const TMyOracleReferenceCache&) = delete;
+	TMyOracleReferenceCache& operator=(const TMyOracleReferenceCache&) = delete;
+
+	// Declares a replicated table. query reads it, SELECT * FROM name when
+	// empty. False if the table is already declared or loading has started.
+	bool AddTable(const std::string& name, const std::string& key_column, const std::string& query = std::string());
+
+	// Loads every table, or one. A table that fails keeps its previous
+	// snapshot; false if any failed.
+	bool Load(TMyOracle* sql);
+	bool Load(TMyOracle* sql, const std::string& name);
+	// Same on a connection leased from the pool
+	bool Load(SqlConnection& pool);
+
+	// Latest snapshot of the table, nullptr when it is not declared or not
+	// loaded yet. Does not wait for a load in progress; the standard
+	// libraries guard std::atomic<std::shared_ptr> with a short internal
+	// lock, held for the copy of the pointer only, so it is not lock free.
+	Table Get(const std::string& name) const;
+
+	// Reloads every table each interval on a background thread
+	void StartRefresh(SqlConnection& pool, std::chrono::milliseconds interval);
+	void StopRefresh();
+
+private:
+	struct Slot
+	{
+		std::string name;
+		std::string key_column;
+		std::string query;
+		std::atomic<std::shared_ptr<const TMyOracleReferenceTable>> table;
+		// Snapshots stored, under m_load_mutex
+		uint64_t loads = 0;
+	};
+
+	bool Load(TMyOracle* sql, Slot& slot);
+
+	// Fixed once loading starts, so readers can scan it without a lock
+	std::vector<std::unique_ptr<Slot>> m_slots;
+	std::atomic<bool> m_started{ false };
+	// One load at a time
+	std::mutex m_load_mutex;
+
+	std::thread m_refresh;
+	std::mutex m_refresh_mutex;
+	std::condition_variable m_refresh_cv;
+	bool m_stop = false;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,347 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleResultCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+// -----------------------------------------------------------------------------
+// Words that follow a table name where an alias could be
+static bool IsClauseKeyword(const std::string& word)
+{
+	static const char* const KEYWORDS[] =
+	{
+		"WHERE", "INNER", "LEFT", "RIGHT", "FULL", "CROSS", "NATURAL", "JOIN", "ON", "USING",
+		"GROUP", "ORDER", "HAVING", "CONNECT", "START", "UNION", "MINUS", "INTERSECT",
+		"FETCH", "OFFSET", "FOR", "SET", "VALUES", "SELECT", "WITH", "PARTITION"
+	};
+	return std::find_if(std::begin(KEYWORDS), std::end(KEYWORDS), [&word](const char* keyword) { return word == keyword; }) != std::end(KEYWORDS);
+}
+// -----------------------------------------------------------------------------
+// DEV."EMPLOYEE" -> EMPLOYEE
+static std::string TableName(const std::string& word)
+{
+	std::string name = word.substr(word.rfind('.') == std::string::npos ? 0 : word.rfind('.') + 1);
+	name.erase(std::remove(name.begin(), name.end(), '"'), name.end());
+	return std::to_upper(name);
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultCache::TMyOracleResultCache(size_t max_bytes, std::chrono::milliseconds ttl)
+	: m_max_bytes(max_bytes), m_ttl(ttl), m_shard_bytes(max_bytes / SHARDS)
+{
+}
+// -----------------------------------------------------------------------------
+std::string TMyOracleResultCache::MakeKey(const std::string& query, const TMyOracleBinds& binds)
+{
+	std::string key;
+	key.reserve(query.size() + binds.size() * 16);
+
+	// Collapse whitespace and fold case, literals and quoted identifiers
+	// are kept as written
+	char quote = 0;
+	bool space = false;
+	for (const char c : query)
+	{
+		if (quote)
+		{
+			key += c;
+			if (c == quote)
+			{
+				quote = 0;
+			}
+			continue;
+		}
+
+		if (std::isspace(static_cast<unsigned char>(c)))
+		{
+			space = !key.empty();
+			continue;
+		}
+		if (space)
+		{
+			key += ' ';
+			space = false;
+		}
+
+		if (c == '\'' || c == '"')
+		{
+			quote = c;
+		}
+		key += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+	}
+
+	// Binds after a separator that cannot appear in SQL text. Strings are
+	// length prefixed so that no two bind lists give the same key.
+	char number[32];
+	for (const auto& bind : binds)
+	{
+		key += '\x1f';
+		key += bind.name;
+		key += '=';
+		switch (bind.value.index())
+		{
+		case 1:
+			key += 'i';
+			key += std::to_string(std::get<int64_t>(bind.value));
+			break;
+		case 2:
+			std::snprintf(number, sizeof(number), "d%a", std::get<double>(bind.value));
+			key += number;
+			break;
+		case 3:
+			key += 's';
+			key += std::to_string(std::get<std::string>(bind.value).size());
+			key += ':';
+			key += std::get<std::string>(bind.value);
+			break;
+		default:
+			key += 'n';
+			break;
+		}
+	}
+
+	return key;
+}
+// -----------------------------------------------------------------------------
+std::vector<std::string> TMyOracleResultCache::Tables(const std::string& query)
+{
+	// Words, with commas and parentheses as words of their own
+	std::vector<std::string> words;
+	std::string word;
+	char quote = 0;
+	for (const char c : query)
+	{
+		if (quote)
+		{
+			word += c;
+			quote = c == quote ? 0 : quote;
+			continue;
+		}
+		if (std::isspace(static_cast<unsigned char>(c)) || c == ',' || c == '(' || c == ')')
+		{
+			if (!word.empty())
+			{
+				words.push_back(std::move(word));
+				word.clear();
+			}
+			if (c == ',' || c == '(' || c == ')')
+			{
+				words.emplace_back(1, c);
+			}
+			continue;
+		}
+		if (c == '\'' || c == '"')
+		{
+			quote = c;
+		}
+		word += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+	}
+	if (!word.empty())
+	{
+		words.push_back(std::move(word));
+	}
+
+	std::vector<std::string> tables;
+	auto Add = [&tables](const std::string& word)
+	{
+		const std::string name = TableName(word);
+		if (!name.empty() && std::find(tables.begin(), tables.end(), name) == tables.end())
+		{
+			tables.push_back(name);
+		}
+	};
+	// A table name, not a subquery or a literal
+	auto IsName = [&words](size_t i)
+	{
+		return i < words.size() && words[i][0] != '(' && words[i][0] != '\'' && words[i][0] != ',' && !IsClauseKeyword(words[i]);
+	};
+
+	for (size_t i = 0; i + 1 < words.size(); ++i)
+	{
+		const std::string& keyword = words[i];
+		if (keyword == "JOIN" || keyword == "INTO" || keyword == "UPDATE")
+		{
+			if (IsName(i + 1))
+			{
+				Add(words[++i]);
+			}
+		}
+		else if (keyword == "FROM")
+		{
+			// FROM a x, b y, ...
+			size_t next = i + 1;
+			while (IsName(next))
+			{
+				Add(words[next++]);
+				if (IsName(next))
+				{
+					++next;	// alias
+				}
+				if (next < words.size() && words[next] == ",")
+				{
+					++next;
+					continue;
+				}
+				break;
+			}
+			i = next - 1;
+		}
+	}
+
+	return tables;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleResultCache::IsWrite(const std::string& query)
+{
+	size_t start = 0;
+	while (start < query.size() && (std::isspace(static_cast<unsigned char>(query[start])) || query[start] == '('))
+	{
+		++start;
+	}
+	size_t end = start;
+	while (end < query.size() && std::isalpha(static_cast<unsigned char>(query[end])))
+	{
+		++end;
+	}
+
+	const std::string verb = std::to_upper(query.substr(start, end - start));
+	return verb == "INSERT" || verb == "UPDATE" || verb == "DELETE" || verb == "MERGE" || verb == "TRUNCATE";
+}
+// -----------------------------------------------------------------------------
+void TMyOracleResultCache::Erase(Shard& shard, std::list<Entry>::iterator it)
+{
+	shard.bytes -= it->bytes;
+	shard.index.erase(it->key);
+	shard.lru.erase(it);
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultCache::Result TMyOracleResultCache::Get(const std::string& key)
+{
+	Shard& shard = ShardOf(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto found = shard.index.find(key);
+	if (found == shard.index.end())
+	{
+		++shard.misses;
+		return nullptr;
+	}
+
+	auto it = found->second;
+	if (it->expires <= Clock::now())
+	{
+		Erase(shard, it);
+		++shard.expirations;
+		++shard.misses;
+		return nullptr;
+	}
+
+	shard.lru.splice(shard.lru.begin(), shard.lru, it);
+	++shard.hits;
+	return it->result;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleResultCache::Put(const std::string& key, Result result, const std::vector<std::string>& tables, std::chrono::milliseconds ttl, uint64_t epoch)
+{
+	if (!result)
+	{
+		return;
+	}
+
+	const size_t bytes = result->Bytes() + result->Columns() * sizeof(TMyOracleColumn) + key.size() * 2 + sizeof(Entry);
+
+	Shard& shard = ShardOf(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	// Checked under the shard lock: an Invalidate() that bumped the epoch
+	// after this has not reached the shard yet and drops the entry
+	if (bytes > m_shard_bytes || m_epoch.load() != epoch)
+	{
+		++shard.rejected;
+		return;
+	}
+
+	auto found = shard.index.find(key);
+	if (found != shard.index.end())
+	{
+		Erase(shard, found->second);
+	}
+
+	// Least recently used entries go first
+	while (!shard.lru.empty() && shard.bytes + bytes > m_shard_bytes)
+	{
+		Erase(shard, std::prev(shard.lru.end()));
+		++shard.evictions;
+	}
+
+	shard.lru.push_front({ key, std::move(result), tables, Clock::now() + (ttl.count() > 0 ? ttl : m_ttl), bytes });
+	shard.index.emplace(key, shard.lru.begin());
+	shard.bytes += bytes;
+	++shard.inserts;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleResultCache::Invalidate(const std::vector<std::string>& tables)
+{
+	if (tables.empty())
+	{
+		return;
+	}
+
+	std::vector<std::string> names;
+	for (const auto& table : tables)
+	{
+		names.push_back(std::to_upper(table));
+	}
+
+	// Queries running now must not store what they read
+	m_epoch.fetch_add(1);
+
+	for (Shard& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto it = shard.lru.begin(); it != shard.lru.end();)
+		{
+			auto next = std::next(it);
+			if (std::find_first_of(it->tables.begin(), it->tables.end(), names.begin(), names.end()) != it->tables.end())
+			{
+				Erase(shard, it);
+				++shard.invalidations;
+			}
+			it = next;
+		}
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleResultCache::Clear()
+{
+	m_epoch.fetch_add(1);
+
+	for (Shard& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.invalidations += shard.lru.size();
+		shard.lru.clear();
+		shard.index.clear();
+		shard.bytes = 0;
+	}
+}
+// -----------------------------------------------------------------------------
+TMyOracleResultCacheStats TMyOracleResultCache::GetStats() const
+{
+	TMyOracleResultCacheStats stats;
+
+	for (const Shard& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		stats.hits += shard.hits;
+		stats.misses += shard.misses;
+		stats.inserts += shard.inserts;
+		stats.evictions += shard.evictions;
+		stats.expirations += shard.expirations;
+		stats.invalidations += shard.invalidations;
+		stats.rejected += shard.rejected;
+		stats.entries += shard.lru.size();
+		stats.bytes += shard.bytes;
+	}
+
+	return stats;
+}
+// -----------------------------------------------------------------------------
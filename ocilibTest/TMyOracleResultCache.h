@@ -0,0 +1,135 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLERESULTCACHE_H__
+#define __TMYORACLERESULTCACHE_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include "TMyOracleResultSet.h"
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+struct TMyOracleResultCacheStats
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t inserts = 0;
+	// Dropped to stay under the size bound
+	uint64_t evictions = 0;
+	// Found past their TTL
+	uint64_t expirations = 0;
+	// Dropped by Invalidate()
+	uint64_t invalidations = 0;
+	// Not stored: larger than a shard, or invalidated while the query ran
+	uint64_t rejected = 0;
+
+	size_t entries = 0;
+	size_t bytes = 0;
+
+	double HitRatio() const { return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+};
+
+// Read-through cache of query results, see TMyOracle::ExecuteCachedQuery().
+//
+// Results are keyed by the normalized SQL text and the bind values, and are
+// shared: a hit hands out the same immutable result set to every reader,
+// nothing is copied. Entries expire after their TTL and the least recently
+// used ones are dropped once the cache holds more than max_bytes.
+//
+// The cache is split into shards with a lock each, picked by key hash, so
+// connections on different cores rarely wait on one another. Every entry is
+// tagged with the tables its query reads; Invalidate() drops the entries of
+// a table. TMyOracle invalidates the tables its own INSERT / UPDATE / DELETE
+// / MERGE statements write to, changes made by other clients are only seen
+// once the TTL expired.
+class TMyOracleResultCache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Result = std::shared_ptr<const TMyOracleResultSet>;
+
+	static constexpr size_t SHARDS = 16;
+
+	explicit TMyOracleResultCache(size_t max_bytes = 64 * 1024 * 1024, std::chrono::milliseconds ttl = std::chrono::milliseconds(60000));
+
+	// Prevent copying
+	TMyOracleResultCache(const TMyOracleResultCache&) = delete;
+	TMyOracleResultCache& operator=(const TMyOracleResultCache&) = delete;
+
+	// Normalized query (whitespace collapsed, upper case outside of string
+	// literals) followed by the bind names and values
+	static std::string MakeKey(const std::string& query, const TMyOracleBinds& binds);
+	// Upper case names of the tables after FROM, JOIN, INTO and UPDATE
+	static std::vector<std::string> Tables(const std::string& query);
+	// INSERT, UPDATE, DELETE, MERGE or TRUNCATE
+	static bool IsWrite(const std::string& query);
+
+	// nullptr on a miss or when the entry expired
+	Result Get(const std::string& key);
+
+	// Stores result unless an invalidation happened since epoch was read
+	// from Epoch(), which means it may hold rows that changed meanwhile. A 0
+	// ttl uses the cache default.
+	void Put(const std::string& key, Result result, const std::vector<std::string>& tables, std::chrono::milliseconds ttl, uint64_t epoch);
+
+	// Read before running the query whose result goes to Put()
+	uint64_t Epoch() const { return m_epoch.load(); }
+
+	// Drops the entries that read any of the tables
+	void Invalidate(const std::vector<std::string>& tables);
+	void Invalidate(const std::string& table) { Invalidate(std::vector<std::string>{ table }); }
+	void Clear();
+
+	TMyOracleResultCacheStats GetStats() const;
+	size_t GetMaxBytes() const { return m_max_bytes; }
+	std::chrono::milliseconds GetTtl() const { return m_ttl; }
+
+private:
+	struct Entry
+	{
+		std::string key;
+		Result result;
+		std::vector<std::string> tables;
+		Clock::time_point expires;
+		size_t bytes = 0;
+	};
+
+	struct Shard
+	{
+		mutable std::mutex mutex;
+		// Most recently used first
+		std::list<Entry> lru;
+		std::unordered_map<std::string, std::list<Entry>::iterator> index;
+		size_t bytes = 0;
+
+		// Counted under the shard lock, summed by GetStats()
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t inserts = 0;
+		uint64_t evictions = 0;
+		uint64_t expirations = 0;
+		uint64_t invalidations = 0;
+		uint64_t rejected = 0;
+	};
+
+	Shard& ShardOf(const std::string& key) { return m_shards[std::hash<std::string>()(key) % SHARDS]; }
+	// Caller holds the shard lock
+	static void Erase(Shard& shard, std::list<Entry>::iterator it);
+
+	const size_t m_max_bytes;
+	const std::chrono::milliseconds m_ttl;
+	// Bound of each shard, max_bytes / SHARDS
+	const size_t m_shard_bytes;
+
+	std::atomic<uint64_t> m_epoch{ 0 };
+	Shard m_shards[SHARDS];
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -1,106 +1,490 @@
 //----------------------------------------------------------------------------
 #include "TMyOracleResultSet.h"
+#include "TMyOracleArena.h"
+#include "TMyOracleDriver.h"
+#include "TMyOracleMetrics.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
 //----------------------------------------------------------------------------
-void TMyOracleResultSet::AddRow(const std::vector<std::string>& row) 
+std::string TMyOracleDate::ToString() const
 {
-    m_rows.emplace_back(row);
+	char str[32];
+	return std::string(str, Format(str, sizeof(str)));
 }
 //----------------------------------------------------------------------------
-TMyOracleResultSet* TMyOracleResultSet::ExtractResultSet(OCI_Resultset* rs)
+size_t TMyOracleDate::Format(char* buffer, size_t size) const
 {
-	if (!rs)
+	const int length = std::snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, minute, second);
+	return length > 0 ? std::min(static_cast<size_t>(length), size - 1) : 0;
+}
+//----------------------------------------------------------------------------
+static std::pmr::memory_resource* Resource(const std::shared_ptr<std::pmr::memory_resource>& memory)
+{
+	return memory ? memory.get() : std::pmr::get_default_resource();
+}
+//----------------------------------------------------------------------------
+// Grows a buffer at least twice: results are reserved one fetch array at a
+// time, and in an arena the old buffers are only freed with it
+template<typename Buffer>
+static void Grow(Buffer& buffer, size_t size)
+{
+	if (size > buffer.capacity())
+	{
+		buffer.reserve(std::max(size, buffer.capacity() * 2));
+	}
+}
+//----------------------------------------------------------------------------
+TMyOracleColumn::TMyOracleColumn(const std::string& name, TMyOracleColumnType type, std::shared_ptr<std::pmr::memory_resource> memory)
+	: m_memory(std::move(memory)), m_name(name), m_type(type),
+	m_nulls(Resource(m_memory)), m_ints(Resource(m_memory)), m_doubles(Resource(m_memory)),
+	m_dates(Resource(m_memory)), m_arena(Resource(m_memory)), m_offsets(Resource(m_memory))
+{
+	if (m_type == TMyOracleColumnType::String)
+	{
+		m_offsets.push_back(0);
+	}
+}
+//----------------------------------------------------------------------------
+TMyOracleColumn::TMyOracleColumn(const TMyOracleColumn& other)
+	: m_name(other.m_name), m_type(other.m_type), m_size(other.m_size),
+	m_nulls(other.m_nulls), m_ints(other.m_ints), m_doubles(other.m_doubles),
+	m_dates(other.m_dates), m_arena(other.m_arena), m_offsets(other.m_offsets)
+{
+}
+//----------------------------------------------------------------------------
+TMyOracleColumn& TMyOracleColumn::operator=(const TMyOracleColumn& other)
+{
+	// The buffers stay in the memory of this column
+	m_name = other.m_name;
+	m_type = other.m_type;
+	m_size = other.m_size;
+	m_nulls = other.m_nulls;
+	m_ints = other.m_ints;
+	m_doubles = other.m_doubles;
+	m_dates = other.m_dates;
+	m_arena = other.m_arena;
+	m_offsets = other.m_offsets;
+	return *this;
+}
+//----------------------------------------------------------------------------
+TMyOracleColumn& TMyOracleColumn::operator=(TMyOracleColumn&& other)
+{
+	// Buffers of the same memory are taken over, the others copied
+	m_name = std::move(other.m_name);
+	m_type = other.m_type;
+	m_size = other.m_size;
+	m_nulls = std::move(other.m_nulls);
+	m_ints = std::move(other.m_ints);
+	m_doubles = std::move(other.m_doubles);
+	m_dates = std::move(other.m_dates);
+	m_arena = std::move(other.m_arena);
+	m_offsets = std::move(other.m_offsets);
+	return *this;
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::Reserve(size_t rows)
+{
+	Grow(m_nulls, (rows + 63) / 64);
+
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		Grow(m_ints, rows);
+		break;
+	case TMyOracleColumnType::Double:
+		Grow(m_doubles, rows);
+		break;
+	case TMyOracleColumnType::Date:
+		Grow(m_dates, rows);
+		break;
+	case TMyOracleColumnType::String:
+		Grow(m_offsets, rows + 1);
+		break;
+	}
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::Clear()
+{
+	m_size = 0;
+	m_nulls.clear();
+	m_ints.clear();
+	m_doubles.clear();
+	m_dates.clear();
+	m_arena.clear();
+	m_offsets.clear();
+	if (m_type == TMyOracleColumnType::String)
+	{
+		m_offsets.push_back(0);
+	}
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::PushNullBit(bool isNull)
+{
+	if ((m_size & 63) == 0)
+	{
+		m_nulls.push_back(0);
+	}
+	if (isNull)
+	{
+		m_nulls.back() |= uint64_t(1) << (m_size & 63);
+	}
+	++m_size;
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendNull()
+{
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		m_ints.push_back(0);
+		break;
+	case TMyOracleColumnType::Double:
+		m_doubles.push_back(0.0);
+		break;
+	case TMyOracleColumnType::Date:
+		m_dates.emplace_back();
+		break;
+	case TMyOracleColumnType::String:
+		m_offsets.push_back(static_cast<uint32_t>(m_arena.size()));
+		break;
+	}
+	PushNullBit(true);
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendInt64(int64_t value)
+{
+	m_ints.push_back(value);
+	PushNullBit(false);
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendDouble(double value)
+{
+	m_doubles.push_back(value);
+	PushNullBit(false);
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendDate(const TMyOracleDate& value)
+{
+	m_dates.push_back(value);
+	PushNullBit(false);
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendString(const char* value, size_t length)
+{
+	m_arena.append(value, length);
+	m_offsets.push_back(static_cast<uint32_t>(m_arena.size()));
+	PushNullBit(false);
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendText(const std::string& value)
+{
+	if (value.empty())
+	{
+		AppendNull();
+		return;
+	}
+
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		AppendInt64(std::strtoll(value.c_str(), nullptr, 10));
+		break;
+	case TMyOracleColumnType::Double:
+		AppendDouble(std::strtod(value.c_str(), nullptr));
+		break;
+	case TMyOracleColumnType::Date:
+	{
+		int y = 0, m = 0, d = 0, h = 0, mi = 0, s = 0;
+		std::sscanf(value.c_str(), "%d-%d-%d %d:%d:%d", &y, &m, &d, &h, &mi, &s);
+		AppendDate(TMyOracleDate::Make(y, m, d, h, mi, s));
+		break;
+	}
+	case TMyOracleColumnType::String:
+		AppendString(value.data(), value.size());
+		break;
+	}
+}
+//----------------------------------------------------------------------------
+void TMyOracleColumn::AppendFrom(const TMyOracleColumn& src, size_t row)
+{
+	if (src.IsNull(row))
+	{
+		AppendNull();
+		return;
+	}
+
+	switch (m_type)
 	{
-		std::cerr << "[ERROR] TMyOracleResultSet::ExtractResultSet: Resultset is null" << std::endl;
+	case TMyOracleColumnType::Int64:
+		AppendInt64(src.GetInt64(row));
+		break;
+	case TMyOracleColumnType::Double:
+		AppendDouble(src.GetDouble(row));
+		break;
+	case TMyOracleColumnType::Date:
+		AppendDate(src.GetDate(row));
+		break;
+	case TMyOracleColumnType::String:
+		if (src.m_type == TMyOracleColumnType::String)
+		{
+			const std::string_view text = src.GetView(row);
+			AppendString(text.data(), text.size());
+		}
+		else
+		{
+			AppendText(src.GetString(row));
+		}
+		break;
+	}
+}
+//----------------------------------------------------------------------------
+int64_t TMyOracleColumn::GetInt64(size_t row) const
+{
+	if (IsNull(row))
+	{
+		return 0;
+	}
+
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		return m_ints[row];
+	case TMyOracleColumnType::Double:
+		return static_cast<int64_t>(m_doubles[row]);
+	case TMyOracleColumnType::String:
+		return std::strtoll(GetString(row).c_str(), nullptr, 10);
+	default:
+		return 0;
+	}
+}
+//----------------------------------------------------------------------------
+double TMyOracleColumn::GetDouble(size_t row) const
+{
+	if (IsNull(row))
+	{
+		return 0.0;
+	}
+
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		return static_cast<double>(m_ints[row]);
+	case TMyOracleColumnType::Double:
+		return m_doubles[row];
+	case TMyOracleColumnType::String:
+		return std::strtod(GetString(row).c_str(), nullptr);
+	default:
+		return 0.0;
+	}
+}
+//----------------------------------------------------------------------------
+TMyOracleDate TMyOracleColumn::GetDate(size_t row) const
+{
+	if (IsNull(row) || m_type != TMyOracleColumnType::Date)
+	{
+		return {};
+	}
+	return m_dates[row];
+}
+//----------------------------------------------------------------------------
+std::string TMyOracleColumn::GetString(size_t row) const
+{
+	if (IsNull(row))
+	{
+		return {};
+	}
+
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		return std::to_string(m_ints[row]);
+	case TMyOracleColumnType::Double:
+	{
+		char str[32];
+		std::snprintf(str, sizeof(str), "%.15g", m_doubles[row]);
+		return str;
+	}
+	case TMyOracleColumnType::Date:
+		return m_dates[row].ToString();
+	case TMyOracleColumnType::String:
+		return std::string(GetView(row));
+	}
+	return {};
+}
+//----------------------------------------------------------------------------
+std::string_view TMyOracleColumn::GetView(size_t row) const
+{
+	if (m_type != TMyOracleColumnType::String || IsNull(row))
+	{
+		return {};
+	}
+	return std::string_view(m_arena.data() + m_offsets[row], m_offsets[row + 1] - m_offsets[row]);
+}
+//----------------------------------------------------------------------------
+std::string_view TMyOracleColumn::GetView(size_t row, TMyOracleTextBuffer& buffer) const
+{
+	if (IsNull(row))
+	{
+		return {};
+	}
+
+	int length = 0;
+	switch (m_type)
+	{
+	case TMyOracleColumnType::Int64:
+		length = std::snprintf(buffer.data(), buffer.size(), "%lld", static_cast<long long>(m_ints[row]));
+		break;
+	case TMyOracleColumnType::Double:
+		length = std::snprintf(buffer.data(), buffer.size(), "%.15g", m_doubles[row]);
+		break;
+	case TMyOracleColumnType::Date:
+		length = static_cast<int>(m_dates[row].Format(buffer.data(), buffer.size()));
+		break;
+	case TMyOracleColumnType::String:
+		return GetView(row);
+	}
+	return std::string_view(buffer.data(), length > 0 ? std::min(static_cast<size_t>(length), buffer.size() - 1) : 0);
+}
+//----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracleResultSet::Create()
+{
+	TMyOracleResultSet* resultSet = new TMyOracleResultSet();
+	if (TMyOracleArena::IsEnabled())
+	{
+		resultSet->m_memory = std::make_shared<TMyOracleArena>();
+	}
+	else
+	{
+		resultSet->m_memory = TMyOracleArena::Heap();
+	}
+	return resultSet;
+}
+//----------------------------------------------------------------------------
+void TMyOracleResultSet::AddRow(const std::vector<std::string>& row)
+{
+	for (size_t i = 0; i < m_columns.size(); ++i)
+	{
+		m_columns[i].AppendText(i < row.size() ? row[i] : std::string());
+	}
+	++m_rowCount;
+}
+//----------------------------------------------------------------------------
+void TMyOracleResultSet::Describe(TMyOracleDriverStatement& stmt)
+{
+	m_columns.clear();
+
+	const unsigned int colCount = stmt.GetColumnCount();
+	m_columns.reserve(colCount);
+	for (unsigned int i = 1; i <= colCount; ++i)
+	{
+		m_columns.emplace_back(std::to_upper(stmt.GetColumnName(i)), stmt.GetColumnType(i), m_memory);
+	}
+}
+//----------------------------------------------------------------------------
+void TMyOracleResultSet::AppendRow(TMyOracleDriverStatement& stmt)
+{
+	for (unsigned int i = 1; i <= m_columns.size(); ++i)
+	{
+		TMyOracleColumn& column = m_columns[i - 1];
+
+		if (stmt.IsNull(i))
+		{
+			column.AppendNull();
+			continue;
+		}
+
+		switch (column.Type())
+		{
+		case TMyOracleColumnType::Int64:
+			column.AppendInt64(stmt.GetInt64(i));
+			break;
+		case TMyOracleColumnType::Double:
+			column.AppendDouble(stmt.GetDouble(i));
+			break;
+		case TMyOracleColumnType::Date:
+			column.AppendDate(stmt.GetDate(i));
+			break;
+		case TMyOracleColumnType::String:
+		{
+			size_t length = 0;
+			const char* str = stmt.GetString(i, length);
+			column.AppendString(str, length);
+			break;
+		}
+		}
+	}
+
+	++m_rowCount;
+}
+//----------------------------------------------------------------------------
+TMyOracleResultSet* TMyOracleResultSet::ExtractResultSet(TMyOracleDriverStatement& stmt, unsigned int fetch_size, TMyOracleQueryTimer* timer)
+{
+	if (stmt.GetColumnCount() == 0)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleResultSet::ExtractResultSet: Statement returned no resultset");
 		return nullptr;
 	}
 
+	if (fetch_size == 0)
+	{
+		fetch_size = stmt.GetFetchSize();
+	}
+
 	// Create a new result set object
-    TMyOracleResultSet* resultSet = new TMyOracleResultSet();
-
-    while (OCI_FetchNext(rs)) 
-    {
-        std::vector<std::string> row;
-        const unsigned int colCount = OCI_GetColumnCount(rs);
-        for (unsigned int i = 1; i <= colCount; ++i)
-        {
-            OCI_Column* col = OCI_GetColumn(rs, i);
-        
-            auto column = OCI_GetColumn(rs, i);
-            const auto type = OCI_ColumnGetType(col);
-            const auto name = OCI_ColumnGetName(col);
-			resultSet->AddColumn(std::to_upper(name));
-
-            if (OCI_IsNull(rs, i)) 
-            {
-                row.emplace_back("");
-                continue;
-            }
-
-            switch (type)
-            {           
-            case OCI_CDT_DATETIME: 
-            {
-                OCI_Date* dt = OCI_GetDate(rs, i);
-
-				constexpr size_t SIZE_STR = 260;
-                std::array<otext, SIZE_STR> str{};
-
-				OCI_DateToText(dt, "YYYY-MM-DD HH24:MI:SS", SIZE_STR, str.data());                
-                row.emplace_back(str.data());
-
-                break;
-            }
-            default:
-                row.emplace_back(std::string(OCI_GetString(rs, i)));
-                break;
-            }
-        }
-
-        resultSet->AddRow(row);
-    }
-
-    return resultSet;
-}
-//----------------------------------------------------------------------------
-TMyOracleResultSet* TMyOracleResultSet::ExtractResultSet(ocilib::Resultset* rs)
-{
-	if (!rs)
-	{
-		std::cerr << "[ERROR] TMyOracleResultSet::ExtractResultSet: Resultset is null" << std::endl;
-		return nullptr;
+	TMyOracleResultSet* resultSet = Create();
+
+	// Describe the columns once, not once per fetched row
+	resultSet->Describe(stmt);
+
+	// Without a timer (or with metrics off) the loop reads no clock
+	if (timer && !timer->Enabled())
+	{
+		timer = nullptr;
 	}
-	if (rs->IsNull())
+
+	// Fetch() only goes back to the server once the rows of the current
+	// fetch array are consumed, so size storage a batch at a time.
+	while (stmt.Fetch())
 	{
-		std::cerr << "[ERROR] TMyOracleResultSet::ExtractResultSet: Resultset is empty" << std::endl;
-		return nullptr;
+		if (timer)
+		{
+			timer->Lap(TMyOraclePhase::FETCH);
+		}
+
+		if (resultSet->m_rowCount % fetch_size == 0)
+		{
+			resultSet->Reserve(resultSet->m_rowCount + fetch_size);
+			++resultSet->m_fetchRoundTrips;
+		}
+
+		resultSet->AppendRow(stmt);
+
+		if (timer)
+		{
+			timer->Lap(TMyOraclePhase::CONVERT);
+		}
 	}
 
-	TMyOracleResultSet* resultSet = new TMyOracleResultSet();
-	while (rs->Next())
+	if (timer)
 	{
-		std::vector<std::string> row;
-		const unsigned int colCount = rs->GetColumnCount();
-		for (unsigned int i = 1; i <= colCount; ++i)
+		// The last Fetch() found the end of the rows
+		timer->Lap(TMyOraclePhase::FETCH);
+		timer->AddRows(resultSet->m_rowCount, resultSet->Bytes());
+		timer->AddRoundTrips(resultSet->m_fetchRoundTrips);
+	}
+
+	if (stmt.FetchFailed())
+	{
+		if (timer)
 		{
-			const auto col = rs->GetColumn(i);
-			const auto name = col.GetName();
-			const auto type = col.GetType();
-            resultSet->AddColumn(std::to_upper(name));
-
-
-			if (type == OCI_CDT_DATETIME)
-			{
-				ocilib::Date dt = rs->Get<ocilib::Date>(i);
-				std::string dateStr = dt.ToString("YYYY-MM-DD HH24:MI:SS");
-				row.emplace_back(dateStr);				
-			}
-            else
-            {
-                rs->IsNull() ? row.emplace_back("") : row.emplace_back(rs->Get<std::string>(i));
-            }			
+			timer->Fail();
 		}
-		resultSet->AddRow(row);
+		delete resultSet;
+		return nullptr;
 	}
-	return resultSet;	    
+	return resultSet;
 }
-//----------------------------------------------------------------------------
\ No newline at end of file
+//----------------------------------------------------------------------------
@@ -1,51 +1,182 @@
 #ifndef __TMyOracleResultSetH__
 #define __TMyOracleResultSetH__
 // -----------------------------------------------------------------------------
-#include "ocilib.hpp"
 #include "utils.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
 // -----------------------------------------------------------------------------
+enum class TMyOracleColumnType
+{
+	String = 1,	// VARCHAR2, CHAR, anything without a typed buffer and NUMBER
+				// too wide for the others, as its exact text
+	Int64 = 2,	// NUMBER with scale 0, up to 18 digits
+	Double = 3,	// any other NUMBER up to 15 digits, FLOAT
+	Date = 4	// DATE
+};
+// -----------------------------------------------------------------------------
+// Packed DATE value, 8 bytes per cell
+struct TMyOracleDate
+{
+	int16_t year = 0;
+	uint8_t month = 0;
+	uint8_t day = 0;
+	uint8_t hour = 0;
+	uint8_t minute = 0;
+	uint8_t second = 0;
+	uint8_t reserved = 0;
+
+	static TMyOracleDate Make(int year, int month, int day, int hour, int minute, int second)
+	{
+		TMyOracleDate date;
+		date.year = static_cast<int16_t>(year);
+		date.month = static_cast<uint8_t>(month);
+		date.day = static_cast<uint8_t>(day);
+		date.hour = static_cast<uint8_t>(hour);
+		date.minute = static_cast<uint8_t>(minute);
+		date.second = static_cast<uint8_t>(second);
+		return date;
+	}
+
+	// Same text as OCI_DateToText(..., "YYYY-MM-DD HH24:MI:SS")
+	std::string ToString() const;
+	// Same text written to buffer, returns its length
+	size_t Format(char* buffer, size_t size) const;
+};
+// -----------------------------------------------------------------------------
+// Room for the text of a typed cell, see TMyOracleColumn::GetView()
+using TMyOracleTextBuffer = std::array<char, 32>;
+// -----------------------------------------------------------------------------
+class TMyOracleDriverStatement;
+class TMyOracleQueryTimer;
+// -----------------------------------------------------------------------------
+// One column of a result set: a contiguous buffer of the column type, a
+// string arena with offsets for text, and a null bitmap. NULL cells still
+// take a (zero) slot so that row indexes line up across buffers.
+//
+// The buffers are allocated from memory, see TMyOracleArena, which the
+// column keeps alive (the default heap when nullptr). A copy is on the
+// default heap, a move keeps the memory of its source. Assigning keeps the
+// memory of the target and copies the values into it.
+class TMyOracleColumn
+{
+public:
+	TMyOracleColumn(const std::string& name, TMyOracleColumnType type, std::shared_ptr<std::pmr::memory_resource> memory = nullptr);
+	TMyOracleColumn(const TMyOracleColumn& other);
+	TMyOracleColumn(TMyOracleColumn&& other) noexcept = default;
+	TMyOracleColumn& operator=(const TMyOracleColumn& other);
+	TMyOracleColumn& operator=(TMyOracleColumn&& other);
+
+	const std::string& Name() const { return m_name; }
+	TMyOracleColumnType Type() const { return m_type; }
+	size_t Size() const { return m_size; }
+	// Bytes of values held: 8 per typed cell, the text of string cells
+	size_t Bytes() const { return m_type == TMyOracleColumnType::String ? m_arena.size() : m_size * 8; }
+
+	void Reserve(size_t rows);
+	// Drops the values but keeps the allocated buffers
+	void Clear();
+
+	void AppendNull();
+	void AppendInt64(int64_t value);
+	void AppendDouble(double value);
+	void AppendDate(const TMyOracleDate& value);
+	void AppendString(const char* value, size_t length);
+	// Parses text into the column type, used by TMyOracleResultSet::AddRow
+	void AppendText(const std::string& value);
+	// Copies one cell of a column of the same type
+	void AppendFrom(const TMyOracleColumn& src, size_t row);
+
+	bool IsNull(size_t row) const
+	{
+		return row >= m_size || (m_nulls[row >> 6] >> (row & 63)) & 1;
+	}
+
+	int64_t GetInt64(size_t row) const;
+	double GetDouble(size_t row) const;
+	TMyOracleDate GetDate(size_t row) const;
+	// Text of the cell, formatted on demand for typed columns
+	std::string GetString(size_t row) const;
+	// Text of a string cell in place, without a copy. The view is valid
+	// until the column is changed or destroyed. Typed cells have no text to
+	// view and read as empty, like NULL.
+	std::string_view GetView(size_t row) const;
+	// Any cell: string cells are viewed in place, typed cells are formatted
+	// into buffer (same text as GetString()) and viewed there
+	std::string_view GetView(size_t row, TMyOracleTextBuffer& buffer) const;
+
+private:
+	void PushNullBit(bool isNull);
+
+	// Declared first, destroyed after the buffers it holds
+	std::shared_ptr<std::pmr::memory_resource> m_memory;
 
-// This class is a placeholder for the actual implementation of TMyOracleResultSet.
+	std::string m_name;
+	TMyOracleColumnType m_type;
+	size_t m_size = 0;
+
+	std::pmr::vector<uint64_t> m_nulls;
+	std::pmr::vector<int64_t> m_ints;
+	std::pmr::vector<double> m_doubles;
+	std::pmr::vector<TMyOracleDate> m_dates;
+	std::pmr::string m_arena;
+	std::pmr::vector<uint32_t> m_offsets;
+};
+// -----------------------------------------------------------------------------
 class TMyOracleResultSet
 {
 public:
-    
+	TMyOracleResultSet() = default;
+
+	// Result set handed to a caller: its values are built in an arena of
+	// their own when arenas are enabled, else on the counted heap (see
+	// TMyOracleArena). Either way it is freed with delete.
+	static TMyOracleResultSet* Create();
+
     void AddRow(const std::vector<std::string>& row);
-	      	
-    const size_t Rows() const { return m_rows.size(); }	    
 
-    const size_t Columns() const { return m_cols.size(); }
+    const size_t Rows() const { return m_rowCount; }
+
+    const size_t Columns() const { return m_columns.size(); }
 
-    void AddColumn(const std::string& colName) 
-    { 
+    void AddColumn(const std::string& colName, TMyOracleColumnType type = TMyOracleColumnType::String)
+    {
 		if (GetColumnName(colName).empty())
 		{
-            m_cols.push_back(colName);
-		}        
+            m_columns.emplace_back(colName, type, m_memory);
+		}
     }
-    std::string GetColumnName(size_t index) const 
+    std::string GetColumnName(size_t index) const
     {
-        if (index <= m_cols.size())
+        if (index < m_columns.size())
         {
-            return m_cols.at(index);
+            return m_columns.at(index).Name();
         }
-        
+
 		return "";
     }
-    std::string GetColumnName(const std::string name) const 
+    std::string GetColumnName(const std::string name) const
     {
-		for (const auto& it : m_cols)
+		for (const auto& it : m_columns)
 		{
-			if (it == name)
-				return it;
+			if (it.Name() == name)
+				return it.Name();
 		}
 
         return "";
     }
+	TMyOracleColumnType GetColumnType(size_t index) const
+	{
+		return m_columns.at(index).Type();
+	}
 
 	const bool First()
     {
-		if (m_rows.size() > 0)
+		if (m_rowCount > 0)
 		{
 			m_currentRow = 0;
 			return true;
@@ -55,15 +186,15 @@ public:
 
 	const bool Next()
 	{
-		if (m_currentRow < m_rows.size())
+		if (m_currentRow < m_rowCount)
 		{
 			m_currentRow++;
 			return true;
 		}
 		return false;
-	}   
+	}
     const bool Prev()
-    {        
+    {
         if (m_currentRow > 0)
         {
 			--m_currentRow;
@@ -75,43 +206,159 @@ public:
 
 	bool Eof() const
 	{
-		return m_currentRow >= m_rows.size();
+		return m_currentRow >= m_rowCount;
 	}
 
 	std::string Get(size_t colIndex) const
-	{		
-		if (colIndex < m_cols.size())
-		{
-			if (m_currentRow < m_rows.size())
-			{
-				return m_rows.at(m_currentRow).at(colIndex);
-			}			
-		}
-		return {};
+	{
+		return Get(m_currentRow, colIndex);
 	}
 
 	std::string Get(const std::string& field_name) const
     {
-        for (size_t i = 0; i < m_cols.size(); ++i)
-        {
-            if (m_cols[i] == std::to_upper(field_name))
-            {
-                return m_rows.at(m_currentRow).at(i);
-            }
-        }
-        return {};
+		return Get(FindColumn(field_name));
     }
-               
-    static TMyOracleResultSet* ExtractResultSet(OCI_Resultset* rs);
-	static TMyOracleResultSet* ExtractResultSet(ocilib::Resultset* rs);
 
-	std::vector<std::vector<std::string>> m_rows;
-    std::vector<std::string> m_cols;
+	// Zero-copy text of the current row, see TMyOracleColumn::GetView().
+	// The view points into the result set and is valid until the result set
+	// is changed or destroyed, moving between rows does not invalidate it.
+	// Prefer indexes, the name lookup builds the upper case name.
+	std::string_view GetView(size_t colIndex) const { return GetView(m_currentRow, colIndex); }
+	std::string_view GetView(size_t colIndex, TMyOracleTextBuffer& buffer) const { return GetView(m_currentRow, colIndex, buffer); }
+	std::string_view GetView(const std::string& field_name) const { return GetView(FindColumn(field_name)); }
+	std::string_view GetView(const std::string& field_name, TMyOracleTextBuffer& buffer) const { return GetView(FindColumn(field_name), buffer); }
+
+	// Typed accessors on the current row. NULL reads as 0 / an empty date.
+	bool IsNull(size_t colIndex) const { return IsNull(m_currentRow, colIndex); }
+	int64_t GetInt64(size_t colIndex) const { return GetInt64(m_currentRow, colIndex); }
+	double GetDouble(size_t colIndex) const { return GetDouble(m_currentRow, colIndex); }
+	TMyOracleDate GetDate(size_t colIndex) const { return GetDate(m_currentRow, colIndex); }
+	bool IsNull(const std::string& field_name) const { return IsNull(FindColumn(field_name)); }
+	int64_t GetInt64(const std::string& field_name) const { return GetInt64(FindColumn(field_name)); }
+	double GetDouble(const std::string& field_name) const { return GetDouble(FindColumn(field_name)); }
+	TMyOracleDate GetDate(const std::string& field_name) const { return GetDate(FindColumn(field_name)); }
+
+	// The same on any row, without moving the current one: a result set
+	// shared read-only, see TMyOracle::ExecuteCachedQuery(), is read with
+	// these. Rows past Rows() read as NULL.
+	std::string Get(size_t row, size_t colIndex) const
+	{
+		return colIndex < m_columns.size() && row < m_rowCount ? m_columns[colIndex].GetString(row) : std::string();
+	}
+	std::string_view GetView(size_t row, size_t colIndex) const
+	{
+		return colIndex < m_columns.size() ? m_columns[colIndex].GetView(row) : std::string_view();
+	}
+	std::string_view GetView(size_t row, size_t colIndex, TMyOracleTextBuffer& buffer) const
+	{
+		return colIndex < m_columns.size() ? m_columns[colIndex].GetView(row, buffer) : std::string_view();
+	}
+	bool IsNull(size_t row, size_t colIndex) const
+	{
+		return colIndex >= m_columns.size() || m_columns[colIndex].IsNull(row);
+	}
+	int64_t GetInt64(size_t row, size_t colIndex) const
+	{
+		return colIndex < m_columns.size() ? m_columns[colIndex].GetInt64(row) : 0;
+	}
+	double GetDouble(size_t row, size_t colIndex) const
+	{
+		return colIndex < m_columns.size() ? m_columns[colIndex].GetDouble(row) : 0.0;
+	}
+	TMyOracleDate GetDate(size_t row, size_t colIndex) const
+	{
+		return colIndex < m_columns.size() ? m_columns[colIndex].GetDate(row) : TMyOracleDate{};
+	}
+	std::string Get(size_t row, const std::string& field_name) const { return Get(row, FindColumn(field_name)); }
+	std::string_view GetView(size_t row, const std::string& field_name) const { return GetView(row, FindColumn(field_name)); }
+	bool IsNull(size_t row, const std::string& field_name) const { return IsNull(row, FindColumn(field_name)); }
+	int64_t GetInt64(size_t row, const std::string& field_name) const { return GetInt64(row, FindColumn(field_name)); }
+	double GetDouble(size_t row, const std::string& field_name) const { return GetDouble(row, FindColumn(field_name)); }
+	TMyOracleDate GetDate(size_t row, const std::string& field_name) const { return GetDate(row, FindColumn(field_name)); }
+
+	// Index of the column, or Columns() when there is none by that name
+	size_t FindColumn(const std::string& field_name) const
+	{
+		const std::string name = std::to_upper(field_name);
+		for (size_t i = 0; i < m_columns.size(); ++i)
+		{
+			if (m_columns[i].Name() == name)
+			{
+				return i;
+			}
+		}
+		return m_columns.size();
+	}
+
+	// Number of fetch round trips it took to pull the rows from the server
+	size_t FetchRoundTrips() const { return m_fetchRoundTrips; }
+	// Bytes of values held by all columns
+	size_t Bytes() const
+	{
+		size_t bytes = 0;
+		for (const auto& column : m_columns)
+		{
+			bytes += column.Bytes();
+		}
+		return bytes;
+	}
+
+	// Row-at-a-time building blocks shared by ExtractResultSet and
+	// TMyOracleCursor: Describe() creates the columns from the statement
+	// metadata, AppendRow() copies the row the statement is positioned on.
+	void Describe(TMyOracleDriverStatement& stmt);
+	void AppendRow(TMyOracleDriverStatement& stmt);
+	// Same columns as other, without its rows
+	void DescribeLike(const TMyOracleResultSet& other)
+	{
+		m_columns.clear();
+		for (const auto& column : other.m_columns)
+		{
+			m_columns.emplace_back(column.Name(), column.Type(), m_memory);
+		}
+	}
+	// Copies one row of a result set described the same way
+	void AppendRow(const TMyOracleResultSet& src, size_t row)
+	{
+		for (size_t i = 0; i < m_columns.size(); ++i)
+		{
+			m_columns[i].AppendFrom(src.m_columns[i], row);
+		}
+		++m_rowCount;
+	}
+	void Reserve(size_t rows)
+	{
+		for (auto& column : m_columns)
+		{
+			column.Reserve(rows);
+		}
+	}
+	// Drops the rows, keeps the columns and their buffers for reuse
+	void Clear()
+	{
+		for (auto& column : m_columns)
+		{
+			column.Clear();
+		}
+		m_rowCount = 0;
+		m_currentRow = 0;
+	}
+
+	// fetch_size is the statement fetch array size; rows are reserved one
+	// fetched batch at a time. 0 means the fetch size of the statement.
+	// nullptr if the statement returned no rows or the fetch failed. With a
+	// timer, fetching and copying are timed row by row and the rows counted.
+	static TMyOracleResultSet* ExtractResultSet(TMyOracleDriverStatement& stmt, unsigned int fetch_size = 0, TMyOracleQueryTimer* timer = nullptr);
+
+	// Where new columns allocate, nullptr for the default heap
+	std::shared_ptr<std::pmr::memory_resource> m_memory;
+	std::vector<TMyOracleColumn> m_columns;
+	size_t m_rowCount = 0;
 	size_t m_currentRow = 0;
+	size_t m_fetchRoundTrips = 0;
 
 };
 
 // -----------------------------------------------------------------------------
 #endif
 // -----------------------------------------------------------------------------
-
@@ -0,0 +1,177 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLEROWMAPPING_H__
+#define __TMYORACLEROWMAPPING_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleDriver.h"
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+// -----------------------------------------------------------------------------
+
+// Decodes the rows of a query straight from the driver statement, see
+// TMyOracle::ExecuteRows(). The columns it reads are named once; their
+// positions are resolved when a statement first runs with a mapping and
+// kept for the later executions of the same statement.
+class TMyOracleRowReader
+{
+public:
+	virtual ~TMyOracleRowReader() = default;
+
+	// Identifies the mapping: positions resolved for one key are reused by
+	// every reader returning the same key
+	virtual const void* Mapping() const = 0;
+
+	// Columns read, in the order of the positions passed to Read()
+	virtual size_t Fields() const = 0;
+	virtual const char* Column(size_t field) const = 0;
+
+	// Before the first row. A reader must be restartable: when the session
+	// is lost mid-fetch the query runs again and Begin() is called again,
+	// the rows read so far being discarded.
+	virtual void Begin() {}
+	// Decodes the row the statement is positioned on. positions are the
+	// 1-based statement columns of the fields. Returns the bytes of values
+	// read, for the metrics.
+	virtual size_t Read(TMyOracleDriverStatement& stmt, const std::vector<unsigned int>& positions) = 0;
+	// After the last row, rows being the number read
+	virtual void End(size_t rows) { (void)rows; }
+};
+
+// One column of a typed row: the column name and the member it goes into.
+// A row type lists its fields in a static constexpr Fields() function:
+//
+//	struct EmployeeRow
+//	{
+//		int64_t id = 0;
+//		std::string name;
+//
+//		static constexpr auto Fields()
+//		{
+//			return std::make_tuple(
+//				TMyOracleField{ "ID", &EmployeeRow::id },
+//				TMyOracleField{ "NAME", &EmployeeRow::name });
+//		}
+//	};
+//
+// Members may be integers, floating point, std::string or TMyOracleDate,
+// they are read with the driver getter of that type. NULL reads as 0, an
+// empty string or an empty date.
+template<typename T, typename M>
+struct TMyOracleField
+{
+	const char* column;
+	M T::* member;
+};
+
+template<typename T, typename M>
+TMyOracleField(const char*, M T::*) -> TMyOracleField<T, M>;
+
+// TMyOracleRowReader of a row type with Fields(), decoding into a vector.
+// Rows already in the vector are overwritten in place, so a vector reused
+// across queries keeps its capacity and the buffers of its strings.
+template<typename T>
+class TMyOracleRowMapper : public TMyOracleRowReader
+{
+public:
+	explicit TMyOracleRowMapper(std::vector<T>& rows) : m_rows(rows) {}
+
+	const void* Mapping() const override
+	{
+		// One address per row type
+		static const char key = 0;
+		return &key;
+	}
+
+	size_t Fields() const override
+	{
+		return std::tuple_size_v<decltype(T::Fields())>;
+	}
+
+	const char* Column(size_t field) const override
+	{
+		return std::apply([field](const auto&... fields)
+		{
+			const char* columns[] = { fields.column... };
+			return columns[field];
+		}, T::Fields());
+	}
+
+	void Begin() override
+	{
+		m_count = 0;
+	}
+
+	size_t Read(TMyOracleDriverStatement& stmt, const std::vector<unsigned int>& positions) override
+	{
+		if (m_count == m_rows.size())
+		{
+			m_rows.emplace_back();
+		}
+		T& row = m_rows[m_count++];
+
+		size_t bytes = 0;
+		std::apply([&](const auto&... fields)
+		{
+			size_t field = 0;
+			((bytes += ReadField(stmt, positions[field++], row.*(fields.member))), ...);
+		}, T::Fields());
+		return bytes;
+	}
+
+	void End(size_t rows) override
+	{
+		m_rows.resize(rows);
+	}
+
+private:
+	template<typename M>
+	static size_t ReadField(TMyOracleDriverStatement& stmt, unsigned int index, M& value)
+	{
+		if constexpr (std::is_same_v<M, std::string>)
+		{
+			if (stmt.IsNull(index))
+			{
+				value.clear();
+				return 0;
+			}
+			size_t length = 0;
+			const char* text = stmt.GetString(index, length);
+			value.assign(text ? text : "", text ? length : 0);
+			return value.size();
+		}
+		else if constexpr (std::is_same_v<M, TMyOracleDate>)
+		{
+			value = stmt.IsNull(index) ? TMyOracleDate{} : stmt.GetDate(index);
+			return sizeof(value);
+		}
+		else if constexpr (std::is_same_v<M, bool>)
+		{
+			value = !stmt.IsNull(index) && stmt.GetInt64(index) != 0;
+			return sizeof(int64_t);
+		}
+		else if constexpr (std::is_integral_v<M> || std::is_enum_v<M>)
+		{
+			value = stmt.IsNull(index) ? M{} : static_cast<M>(stmt.GetInt64(index));
+			return sizeof(int64_t);
+		}
+		else if constexpr (std::is_floating_point_v<M>)
+		{
+			value = stmt.IsNull(index) ? M{} : static_cast<M>(stmt.GetDouble(index));
+			return sizeof(double);
+		}
+		else
+		{
+			static_assert(std::is_same_v<M, void>, "TMyOracleField: unsupported member type");
+			return 0;
+		}
+	}
+
+	std::vector<T>& m_rows;
+	size_t m_count = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
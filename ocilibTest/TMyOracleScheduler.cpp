@@ -0,0 +1,92 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleScheduler.h"
+#include "TMyOracleLog.h"
+// -----------------------------------------------------------------------------
+// A spawned coroutine has no awaiter to rethrow its exception to
+static void LogUnhandledException(const std::exception_ptr& exception)
+{
+	try
+	{
+		std::rethrow_exception(exception);
+	}
+	catch (const std::exception& ex)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleScheduler: Spawned coroutine failed: ", ex.what());
+	}
+	catch (...)
+	{
+		TMYORACLE_LOG_ERROR("[EXCEPTION] TMyOracleScheduler: Spawned coroutine failed with an unknown exception");
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleScheduler::QueryAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+	// The coroutine is parked; the completion queues it back on the scheduler
+	m_scheduler->m_executor->ExecuteQueryAsync(m_query, m_binds, [this, handle](std::unique_ptr<TMyOracleResultSet> result, const std::string& error)
+	{
+		m_result = std::move(result);
+		m_error = error;
+		m_scheduler->Post(handle);
+	});
+}
+// -----------------------------------------------------------------------------
+void TMyOracleScheduler::Spawn(TMyOracleTask<void> task)
+{
+	if (task.Done())
+	{
+		return;
+	}
+
+	std::coroutine_handle<> handle = task.Handle();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	Post(handle);
+}
+// -----------------------------------------------------------------------------
+void TMyOracleScheduler::Post(std::coroutine_handle<> handle)
+{
+	// Notified under the lock: once Run() sees the last coroutine done it
+	// returns, and the scheduler may be gone right after
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_ready.push_back(handle);
+	m_cv.notify_one();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleScheduler::Run()
+{
+	while (true)
+	{
+		std::coroutine_handle<> handle;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			// Drop the coroutines that ran to completion
+			m_tasks.remove_if([](const TMyOracleTask<void>& task)
+			{
+				if (!task.Done())
+				{
+					return false;
+				}
+				if (task.Handle() && task.Handle().promise().exception)
+				{
+					LogUnhandledException(task.Handle().promise().exception);
+				}
+				return true;
+			});
+
+			m_cv.wait(lock, [this]() { return !m_ready.empty() || m_tasks.empty(); });
+			if (m_ready.empty())
+			{
+				break;
+			}
+
+			handle = m_ready.front();
+			m_ready.pop_front();
+		}
+
+		handle.resume();
+	}
+}
+// -----------------------------------------------------------------------------
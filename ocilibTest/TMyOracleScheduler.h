@@ -0,0 +1,82 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLESCHEDULER_H__
+#define __TMYORACLESCHEDULER_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleExecutor.h"
+#include "TMyOracleTask.h"
+#include <list>
+// -----------------------------------------------------------------------------
+
+// Resumes coroutines whose queries completed on a TMyOracleExecutor.
+//
+// A coroutine that awaits ExecuteQuery() is parked while the query runs on a
+// pool connection; no thread is blocked on its behalf. When the query
+// completes the coroutine is queued here, and Run() resumes it. Run() must be
+// called from a single thread, which is where all spawned coroutines run.
+class TMyOracleScheduler
+{
+public:
+	explicit TMyOracleScheduler(TMyOracleExecutor* executor) : m_executor(executor) {}
+
+	// Prevent copying
+	TMyOracleScheduler(const TMyOracleScheduler&) = delete;
+	TMyOracleScheduler& operator=(const TMyOracleScheduler&) = delete;
+
+	// co_await scheduler.ExecuteQuery(sql, binds) yields the result set, or
+	// nullptr on failure with the error in Error()
+	class QueryAwaiter
+	{
+	public:
+		QueryAwaiter(TMyOracleScheduler* scheduler, std::string query, TMyOracleBinds binds)
+			: m_scheduler(scheduler), m_query(std::move(query)), m_binds(std::move(binds))
+		{
+		}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		std::unique_ptr<TMyOracleResultSet> await_resume() { return std::move(m_result); }
+
+		const std::string& Error() const { return m_error; }
+
+	private:
+		TMyOracleScheduler* m_scheduler;
+		std::string m_query;
+		TMyOracleBinds m_binds;
+		std::unique_ptr<TMyOracleResultSet> m_result;
+		std::string m_error;
+	};
+
+	QueryAwaiter ExecuteQuery(const std::string& query, const TMyOracleBinds& binds = {})
+	{
+		return QueryAwaiter(this, query, binds);
+	}
+
+	// Starts a top-level coroutine; the scheduler owns it until it finishes.
+	// An exception escaping it is logged when Run() drops it.
+	void Spawn(TMyOracleTask<void> task);
+
+	// Queues a parked coroutine for Run(), callable from any thread
+	void Post(std::coroutine_handle<> handle);
+
+	// Resumes coroutines as their queries complete, until every spawned
+	// coroutine has finished
+	void Run();
+
+	size_t Active() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_tasks.size();
+	}
+
+private:
+	TMyOracleExecutor* m_executor;
+
+	std::list<TMyOracleTask<void>> m_tasks;
+	std::deque<std::coroutine_handle<>> m_ready;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cv;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
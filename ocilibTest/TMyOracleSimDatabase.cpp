@@ -0,0 +1,378 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleSimDatabase.h"
+#include "TMyOracleSimQuery.h"
+#include "TMyOracleLog.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <regex>
+#include <thread>
+// -----------------------------------------------------------------------------
+static std::mutex g_databases_mutex;
+static std::unordered_map<std::string, std::shared_ptr<TMyOracleSimDatabase>> g_databases;
+// -----------------------------------------------------------------------------
+static std::mt19937_64& Random()
+{
+	thread_local std::mt19937_64 rng(std::random_device{}() ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
+	return rng;
+}
+// -----------------------------------------------------------------------------
+// Stores a value in the type of the column
+static void AppendValue(TMyOracleColumn& column, const TMyOracleValue& value)
+{
+	if (value.index() == 0)
+	{
+		column.AppendNull();
+		return;
+	}
+
+	switch (column.Type())
+	{
+	case TMyOracleColumnType::Int64:
+		if (value.index() == 1)
+		{
+			column.AppendInt64(std::get<int64_t>(value));
+		}
+		else if (value.index() == 2)
+		{
+			column.AppendInt64(static_cast<int64_t>(std::get<double>(value)));
+		}
+		else
+		{
+			column.AppendText(std::get<std::string>(value));
+		}
+		break;
+	case TMyOracleColumnType::Double:
+		if (value.index() == 1)
+		{
+			column.AppendDouble(static_cast<double>(std::get<int64_t>(value)));
+		}
+		else if (value.index() == 2)
+		{
+			column.AppendDouble(std::get<double>(value));
+		}
+		else
+		{
+			column.AppendText(std::get<std::string>(value));
+		}
+		break;
+	default:
+		if (value.index() == 1)
+		{
+			column.AppendText(std::to_string(std::get<int64_t>(value)));
+		}
+		else if (value.index() == 2)
+		{
+			column.AppendText(std::to_string(std::get<double>(value)));
+		}
+		else
+		{
+			column.AppendText(std::get<std::string>(value));
+		}
+		break;
+	}
+}
+// -----------------------------------------------------------------------------
+// The conversion errors of storing value in the column
+static bool CheckValue(const TMyOracleColumn& column, const TMyOracleValue& value, std::string& error)
+{
+	if (value.index() != 3)
+	{
+		return true;
+	}
+
+	const std::string& text = std::get<std::string>(value);
+	char* end = nullptr;
+	switch (column.Type())
+	{
+	case TMyOracleColumnType::Int64:
+	case TMyOracleColumnType::Double:
+		std::strtod(text.c_str(), &end);
+		if (end == text.c_str() || *end != '\0')
+		{
+			error = "ORA-01722: invalid number";
+			return false;
+		}
+		break;
+	case TMyOracleColumnType::Date:
+	{
+		int y = 0, m = 0, d = 0;
+		if (std::sscanf(text.c_str(), "%d-%d-%d", &y, &m, &d) != 3)
+		{
+			error = "ORA-01861: literal does not match format string";
+			return false;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimTable::AddColumn(const std::string& name, TMyOracleColumnType type)
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+	m_data.m_columns.emplace_back(std::to_upper(name), type);
+	m_indexes.emplace_back();
+	m_unique.emplace_back();
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimTable::AddUniqueIndex(const std::string& name, size_t column)
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+	if (column < m_unique.size() && m_data.m_columns[column].Type() == TMyOracleColumnType::Int64)
+	{
+		m_unique[column] = std::to_upper(name);
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimTable::Insert(const std::vector<TMyOracleValue>& values, std::string& error)
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+	for (size_t i = 0; i < values.size() && i < m_data.m_columns.size(); ++i)
+	{
+		if (!CheckValue(m_data.m_columns[i], values[i], error))
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < m_unique.size(); ++i)
+	{
+		if (!m_unique[i].empty() && i < values.size() && values[i].index() != 0)
+		{
+			// The value as the column stores it
+			TMyOracleColumn key(m_data.m_columns[i].Name(), TMyOracleColumnType::Int64);
+			AppendValue(key, values[i]);
+			if (!key.IsNull(0) && m_indexes[i].count(key.GetInt64(0)) > 0)
+			{
+				error = "ORA-00001: unique constraint (" + m_unique[i] + ") violated";
+				return false;
+			}
+		}
+	}
+
+	const size_t row = m_data.Rows();
+	for (size_t i = 0; i < m_data.m_columns.size(); ++i)
+	{
+		TMyOracleColumn& column = m_data.m_columns[i];
+		const TMyOracleValue& value = i < values.size() ? values[i] : TMyOracleValue(nullptr);
+
+		AppendValue(column, value);
+
+		if (column.Type() == TMyOracleColumnType::Int64 && !column.IsNull(row))
+		{
+			m_indexes[i].emplace(column.GetInt64(row), row);
+		}
+	}
+	++m_data.m_rowCount;
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDatabase::Register(const std::string& db, std::shared_ptr<TMyOracleSimDatabase> database)
+{
+	std::lock_guard<std::mutex> lock(g_databases_mutex);
+	g_databases[std::to_upper(db)] = std::move(database);
+}
+// -----------------------------------------------------------------------------
+std::shared_ptr<TMyOracleSimDatabase> TMyOracleSimDatabase::Find(const std::string& db)
+{
+	std::lock_guard<std::mutex> lock(g_databases_mutex);
+	auto it = g_databases.find(std::to_upper(db));
+	return it != g_databases.end() ? it->second : nullptr;
+}
+// -----------------------------------------------------------------------------
+TMyOracleSimTable* TMyOracleSimDatabase::FindTable(const std::string& name) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_tables_mutex);
+	auto it = m_tables.find(std::to_upper(name));
+	return it != m_tables.end() ? it->second.get() : nullptr;
+}
+// -----------------------------------------------------------------------------
+TMyOracleSimTable* TMyOracleSimDatabase::CreateTable(const std::string& name)
+{
+	std::unique_lock<std::shared_mutex> lock(m_tables_mutex);
+	auto& table = m_tables[std::to_upper(name)];
+	if (!table)
+	{
+		table = std::make_unique<TMyOracleSimTable>(std::to_upper(name));
+	}
+	return table.get();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDatabase::LoadScript(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		TMYORACLE_LOG_ERROR("TMyOracleSimDatabase::LoadScript: Cannot open ", path);
+		return false;
+	}
+
+	// CREATE TABLE "DEV"."EMPLOYEE" and its column lines, "ID" NUMBER(24,0) ...
+	static const std::regex CREATE_TABLE(R"re(CREATE\s+TABLE\s+(?:"?\w+"?\.)?"?(\w+)"?)re", std::regex::icase);
+	static const std::regex COLUMN(R"re(^\s*\(?\s*"(\w+)"\s+(\w+)(?:\((\d+)(?:\s*,\s*(-?\d+))?[^)]*\))?)re");
+	// CREATE UNIQUE INDEX "DEV"."EMPLOYEE_PK" ON "DEV"."EMPLOYEE" ("ID"), one column only
+	static const std::regex UNIQUE_INDEX(R"re(CREATE\s+UNIQUE\s+INDEX\s+(?:"?(\w+)"?\.)?"?(\w+)"?\s+ON\s+(?:"?\w+"?\.)?"?(\w+)"?\s*\(\s*"?(\w+)"?\s*\))re", std::regex::icase);
+
+	TMyOracleSimTable* creating = nullptr;
+	bool new_table = false;
+	size_t inserted = 0;
+	size_t failed = 0;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		std::smatch match;
+		if (std::regex_search(line, match, CREATE_TABLE))
+		{
+			new_table = !FindTable(match[1]);
+			creating = CreateTable(match[1]);
+			continue;
+		}
+
+		if (std::regex_search(line, match, UNIQUE_INDEX))
+		{
+			TMyOracleSimTable* table = FindTable(match[3]);
+			if (table && table->FindColumn(match[4]) < table->Columns())
+			{
+				table->AddUniqueIndex(match[1].matched ? match[1].str() + "." + match[2].str() : match[2].str(), table->FindColumn(match[4]));
+			}
+			continue;
+		}
+
+		if (creating)
+		{
+			if (std::regex_search(line, match, COLUMN))
+			{
+				if (new_table)
+				{
+					const std::string type = std::to_upper(match[2]);
+					const bool has_scale = match[4].matched;
+					TMyOracleColumnType column_type = TMyOracleColumnType::String;
+					if (type == "NUMBER" || type == "INTEGER")
+					{
+						// NUMBER(p) has scale 0 too
+						column_type = (type == "INTEGER" || (match[3].matched && (!has_scale || std::stoi(match[4]) == 0)))
+							? TMyOracleColumnType::Int64 : TMyOracleColumnType::Double;
+					}
+					else if (type == "FLOAT" || type == "BINARY_DOUBLE" || type == "BINARY_FLOAT")
+					{
+						column_type = TMyOracleColumnType::Double;
+					}
+					else if (type == "DATE" || type == "TIMESTAMP")
+					{
+						column_type = TMyOracleColumnType::Date;
+					}
+					creating->AddColumn(match[1], column_type);
+				}
+			}
+			else if (line.find(')') != std::string::npos)
+			{
+				creating = nullptr;
+			}
+			continue;
+		}
+
+		if (line.size() > 11 && std::to_upper(line.substr(0, 11)) == "INSERT INTO")
+		{
+			TMyOracleSimQuery query;
+			TMyOracleResultSet result;
+			std::string error;
+			size_t affected = 0;
+			if (query.Parse(*this, line, error) && query.Execute({}, result, affected, error))
+			{
+				inserted += affected;
+			}
+			else
+			{
+				if (failed++ == 0)
+				{
+					TMYORACLE_LOG_WARN("TMyOracleSimDatabase::LoadScript: ", error, " in ", line);
+				}
+			}
+		}
+	}
+
+	if (failed > 0)
+	{
+		TMYORACLE_LOG_INFO("Loaded ", inserted, " row(s) from ", path, ", ", failed, " statement(s) failed");
+	}
+	else
+	{
+		TMYORACLE_LOG_INFO("Loaded ", inserted, " row(s) from ", path);
+	}
+
+	return failed == 0;
+}
+// -----------------------------------------------------------------------------
+TMyOracleSimStats TMyOracleSimDatabase::GetStats() const
+{
+	TMyOracleSimStats stats;
+	stats.logons = m_counters[LOGONS].load(std::memory_order_relaxed);
+	stats.round_trips = m_counters[ROUND_TRIPS].load(std::memory_order_relaxed);
+	stats.parses = m_counters[PARSES].load(std::memory_order_relaxed);
+	stats.executes = m_counters[EXECUTES].load(std::memory_order_relaxed);
+	stats.fetches = m_counters[FETCHES].load(std::memory_order_relaxed);
+	stats.rows = m_counters[ROWS].load(std::memory_order_relaxed);
+	stats.commits = m_counters[COMMITS].load(std::memory_order_relaxed);
+	stats.rollbacks = m_counters[ROLLBACKS].load(std::memory_order_relaxed);
+	stats.errors = m_counters[ERRORS].load(std::memory_order_relaxed);
+	stats.breaks = m_counters[BREAKS].load(std::memory_order_relaxed);
+	return stats;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDatabase::ResetStats()
+{
+	for (auto& counter : m_counters)
+	{
+		counter.store(0, std::memory_order_relaxed);
+	}
+}
+// -----------------------------------------------------------------------------
+std::chrono::microseconds TMyOracleSimDatabase::RoundTripTime(std::chrono::microseconds server_time) const
+{
+	const TMyOracleSimConfig config = GetConfig();
+
+	std::chrono::microseconds wait = config.round_trip + server_time;
+	if (config.spike_rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(Random()) < config.spike_rate)
+	{
+		wait = config.spike + server_time;
+	}
+	else if (config.jitter.count() > 0)
+	{
+		wait += std::chrono::microseconds(std::uniform_int_distribution<int64_t>(0, config.jitter.count())(Random()));
+	}
+	return wait;
+}
+// -----------------------------------------------------------------------------
+int TMyOracleSimDatabase::InjectFailure() const
+{
+	const TMyOracleSimConfig config = GetConfig();
+	if (config.disconnect_rate <= 0.0 && config.error_rate <= 0.0)
+	{
+		return 0;
+	}
+
+	const double draw = std::uniform_real_distribution<double>(0.0, 1.0)(Random());
+	if (draw < config.disconnect_rate)
+	{
+		return 3113;
+	}
+	if (draw < config.disconnect_rate + config.error_rate)
+	{
+		return 20000;
+	}
+	return 0;
+}
+// -----------------------------------------------------------------------------
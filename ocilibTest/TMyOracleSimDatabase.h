@@ -0,0 +1,164 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLESIMDATABASE_H__
+#define __TMYORACLESIMDATABASE_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include "TMyOracleResultSet.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+// -----------------------------------------------------------------------------
+
+// Cost model of the simulated server. Every round trip waits round_trip plus
+// a uniform 0..jitter, and spike instead once in a while (spike_rate).
+struct TMyOracleSimConfig
+{
+	std::chrono::microseconds round_trip{ 500 };
+	std::chrono::microseconds jitter{ 100 };
+	// Server time per row sent back by a fetch
+	std::chrono::microseconds fetch_row{ 2 };
+	// Hard parse, paid by the first execute of a prepared statement
+	std::chrono::microseconds parse{ 300 };
+	// Server time per row written by a direct path load, which skips the SQL
+	// engine and undo
+	std::chrono::microseconds direct_path_row{ 1 };
+	// Session creation, on top of its round trip
+	std::chrono::microseconds logon{ 20000 };
+	// Redo flush a COMMIT waits for, not paid by COMMIT WRITE NOWAIT
+	std::chrono::microseconds log_sync{ 250 };
+
+	double spike_rate = 0.0;
+	std::chrono::microseconds spike{ 50000 };
+
+	// Round trips failing with ORA-20000, the session stays usable
+	double error_rate = 0.0;
+	// Round trips failing with ORA-03113, the session is lost
+	double disconnect_rate = 0.0;
+};
+
+// Server side counters
+struct TMyOracleSimStats
+{
+	size_t logons = 0;
+	size_t round_trips = 0;
+	size_t parses = 0;
+	size_t executes = 0;
+	size_t fetches = 0;
+	size_t rows = 0;
+	size_t commits = 0;
+	size_t rollbacks = 0;
+	size_t errors = 0;
+	size_t breaks = 0;
+};
+
+// A table of the simulated database. Rows are stored column-wise in a
+// TMyOracleResultSet and every NUMBER(p,0) column has a hash index, which
+// enforces the single column unique indexes of the script.
+class TMyOracleSimTable
+{
+	friend class TMyOracleSimQuery;
+
+public:
+	explicit TMyOracleSimTable(const std::string& name) : m_name(name) {}
+
+	const std::string& Name() const { return m_name; }
+	size_t Columns() const { return m_data.Columns(); }
+	size_t FindColumn(const std::string& name) const { return m_data.FindColumn(name); }
+	std::string GetColumnName(size_t index) const { return m_data.GetColumnName(index); }
+	size_t Rows() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		return m_data.Rows();
+	}
+
+	void AddColumn(const std::string& name, TMyOracleColumnType type);
+
+	// Makes the column unique, Int64 columns only. Rows already in the
+	// table are not checked.
+	void AddUniqueIndex(const std::string& name, size_t column);
+
+	// values are in column order, missing values are NULL. False with
+	// ORA-00001 when a unique column already holds the value.
+	bool Insert(const std::vector<TMyOracleValue>& values, std::string& error);
+
+private:
+	std::string m_name;
+	TMyOracleResultSet m_data;
+	// Row numbers by value, for Int64 columns only
+	std::vector<std::unordered_multimap<int64_t, size_t>> m_indexes;
+	// Name of the unique index of each column, empty for none
+	std::vector<std::string> m_unique;
+	mutable std::shared_mutex m_mutex;
+};
+
+// In-process stand-in for an Oracle database, served by TMyOracleSimDriver.
+//
+// Tables are loaded from SQL Developer exports (SQL_Tables/*.sql) and
+// queried with a small subset of SQL, see TMyOracleSimQuery. Sessions wait
+// for every round trip as configured, so the client code can be measured
+// without a server. Connect strings name a database registered with
+// Register().
+class TMyOracleSimDatabase
+{
+public:
+	static void Register(const std::string& db, std::shared_ptr<TMyOracleSimDatabase> database);
+	static std::shared_ptr<TMyOracleSimDatabase> Find(const std::string& db);
+
+	// Runs the CREATE TABLE, CREATE UNIQUE INDEX and INSERT statements of a
+	// script
+	bool LoadScript(const std::string& path);
+
+	// Table by name, without schema and in any case. nullptr if none.
+	TMyOracleSimTable* FindTable(const std::string& name) const;
+	TMyOracleSimTable* CreateTable(const std::string& name);
+
+	void SetConfig(const TMyOracleSimConfig& config)
+	{
+		std::lock_guard<std::mutex> lock(m_config_mutex);
+		m_config = config;
+	}
+	TMyOracleSimConfig GetConfig() const
+	{
+		std::lock_guard<std::mutex> lock(m_config_mutex);
+		return m_config;
+	}
+
+	TMyOracleSimStats GetStats() const;
+	void ResetStats();
+
+	// Time one round trip takes, with server_time spent on the server
+	std::chrono::microseconds RoundTripTime(std::chrono::microseconds server_time) const;
+	// ORA error code the current round trip fails with, 0 for none
+	int InjectFailure() const;
+
+	enum Counter
+	{
+		LOGONS,
+		ROUND_TRIPS,
+		PARSES,
+		EXECUTES,
+		FETCHES,
+		ROWS,
+		COMMITS,
+		ROLLBACKS,
+		ERRORS,
+		BREAKS,
+		COUNTERS
+	};
+	void Count(Counter counter, size_t value = 1) { m_counters[counter].fetch_add(value, std::memory_order_relaxed); }
+
+private:
+	std::map<std::string, std::unique_ptr<TMyOracleSimTable>> m_tables;
+	mutable std::shared_mutex m_tables_mutex;
+
+	TMyOracleSimConfig m_config;
+	mutable std::mutex m_config_mutex;
+
+	std::atomic<size_t> m_counters[COUNTERS] = {};
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,616 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleSimDriver.h"
+#include "TMyOracleLog.h"
+#include <algorithm>
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleSimPool> TMyOracleSimPool::Create(const std::string& db, unsigned int min_sessions)
+{
+	std::shared_ptr<TMyOracleSimDatabase> database = TMyOracleSimDatabase::Find(db);
+	if (!database)
+	{
+		TMYORACLE_LOG_FATAL("TMyOracleSimPool::Create: ORA-12154: TNS:could not resolve the connect identifier specified");
+		return nullptr;
+	}
+
+	// The sessions of the pool log on one after the other
+	const TMyOracleSimConfig config = database->GetConfig();
+	for (unsigned int i = 0; i < min_sessions; ++i)
+	{
+		std::this_thread::sleep_for(database->RoundTripTime(config.logon));
+		database->Count(TMyOracleSimDatabase::LOGONS);
+		database->Count(TMyOracleSimDatabase::ROUND_TRIPS);
+	}
+
+	std::unique_ptr<TMyOracleSimPool> pool(new TMyOracleSimPool());
+	pool->m_database = std::move(database);
+	return pool;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Connect(const std::string&, const std::string&, const std::string& db)
+{
+	Disconnect();
+
+	std::shared_ptr<TMyOracleSimDatabase> database = TMyOracleSimDatabase::Find(db);
+	if (!database)
+	{
+		SetLastError("ORA-12154: TNS:could not resolve the connect identifier specified");
+		return false;
+	}
+
+	m_database = std::move(database);
+	ClearLost();
+
+	if (!RoundTrip(m_database->GetConfig().logon))
+	{
+		m_database.reset();
+		return false;
+	}
+	m_database->Count(TMyOracleSimDatabase::LOGONS);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Connect(TMyOracleDriverPool& pool)
+{
+	Disconnect();
+
+	TMyOracleSimPool* sim_pool = dynamic_cast<TMyOracleSimPool*>(&pool);
+	if (!sim_pool)
+	{
+		SetLastError("Not a simulated session pool");
+		return false;
+	}
+
+	// Pooled sessions are already logged on
+	m_database = sim_pool->Database();
+	ClearLost();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Disconnect()
+{
+	if (!m_database)
+	{
+		return false;
+	}
+
+	m_database.reset();
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Commit(TMyOracleCommitMode mode)
+{
+	// NOWAIT does not wait for the redo to be on disk
+	const bool wait = mode == TMyOracleCommitMode::Wait && m_database;
+	if (!RoundTrip(wait ? m_database->GetConfig().log_sync : std::chrono::microseconds(0)))
+	{
+		return false;
+	}
+	m_database->Count(TMyOracleSimDatabase::COMMITS);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Rollback()
+{
+	if (!RoundTrip())
+	{
+		return false;
+	}
+	m_database->Count(TMyOracleSimDatabase::ROLLBACKS);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::Break(std::string&)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_call_mutex);
+		if (!m_in_call)
+		{
+			return true;
+		}
+		m_break = true;
+	}
+	m_call_cv.notify_all();
+	return true;
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverStatement> TMyOracleSimDriver::CreateStatement()
+{
+	if (!IsConnected())
+	{
+		SetLastError("ORA-03114: not connected to ORACLE");
+		return nullptr;
+	}
+	return std::make_unique<TMyOracleSimDriverStatement>(*this);
+}
+// -----------------------------------------------------------------------------
+std::unique_ptr<TMyOracleDriverDirectPath> TMyOracleSimDriver::CreateDirectPath()
+{
+	if (!IsConnected())
+	{
+		SetLastError("ORA-03114: not connected to ORACLE");
+		return nullptr;
+	}
+	return std::make_unique<TMyOracleSimDirectPath>(*this);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriver::RoundTrip(std::chrono::microseconds server_time)
+{
+	if (!IsConnected())
+	{
+		SetLastError("ORA-03114: not connected to ORACLE");
+		return false;
+	}
+
+	const std::chrono::microseconds wait = m_database->RoundTripTime(server_time);
+	{
+		std::unique_lock<std::mutex> lock(m_call_mutex);
+		m_in_call = true;
+		const bool broken = m_call_cv.wait_for(lock, wait, [this]() { return m_break; });
+		m_in_call = false;
+		m_break = false;
+
+		if (broken)
+		{
+			m_database->Count(TMyOracleSimDatabase::BREAKS);
+			m_database->Count(TMyOracleSimDatabase::ERRORS);
+			SetLastError("ORA-01013: user requested cancel of current operation");
+			return false;
+		}
+	}
+	m_database->Count(TMyOracleSimDatabase::ROUND_TRIPS);
+
+	switch (m_database->InjectFailure())
+	{
+	case 3113:
+		// Marks the session lost
+		m_database->Count(TMyOracleSimDatabase::ERRORS);
+		SetLastError("ORA-03113: end-of-file on communication channel");
+		return false;
+	case 20000:
+		m_database->Count(TMyOracleSimDatabase::ERRORS);
+		SetLastError("ORA-20000: simulated failure");
+		return false;
+	default:
+		return true;
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDriverStatement::SetFetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		m_fetch_size = rows;
+	}
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDriverStatement::SetPrefetchSize(unsigned int rows)
+{
+	if (rows > 0)
+	{
+		m_prefetch_size = rows;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::Prepare(const std::string& sql)
+{
+	// Like OCIStmtPrepare this does not go to the server
+	m_sql = sql;
+	m_slots.clear();
+	m_result = TMyOracleResultSet();
+	m_row = m_buffered = 0;
+	m_server_done = true;
+	m_parsed = false;
+
+	m_query = std::make_unique<TMyOracleSimQuery>();
+	std::string error;
+	if (!m_query->Parse(m_driver.Database(), sql, error))
+	{
+		m_query.reset();
+		m_driver.SetLastError(error);
+		return false;
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::Bind(const std::string& name, Slot::Type type, void* value, bool array, unsigned int length)
+{
+	if (!m_query)
+	{
+		m_driver.SetLastError("ORA-24337: statement handle not prepared");
+		return false;
+	}
+
+	Slot slot{ type, value, false, array, length, {} };
+	if (array)
+	{
+		slot.nulls.assign(m_array_size, false);
+	}
+	m_slots[std::to_upper(name)] = std::move(slot);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::SetBindArraySize(unsigned int size)
+{
+	m_array_size = size;
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDriverStatement::SetBindNullAt(const std::string& name, unsigned int row, bool is_null)
+{
+	auto it = m_slots.find(std::to_upper(name));
+	if (it != m_slots.end() && row < it->second.nulls.size())
+	{
+		it->second.nulls[row] = is_null;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::ReadBinds(size_t row, std::vector<TMyOracleValue>& binds, std::string& error) const
+{
+	// By position :1, :2, ... or by name
+	const std::vector<std::string>& names = m_query->Binds();
+	binds.resize(names.size());
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		auto it = m_slots.find(m_by_position ? ":" + std::to_string(i + 1) : names[i]);
+		if (it == m_slots.end())
+		{
+			error = "ORA-01008: not all variables bound";
+			return false;
+		}
+
+		const Slot& slot = it->second;
+		const size_t index = slot.array ? row : 0;
+		if (slot.array ? slot.nulls[row] : slot.is_null)
+		{
+			binds[i] = nullptr;
+		}
+		else if (slot.type == Slot::INT64)
+		{
+			binds[i] = static_cast<int64_t*>(slot.value)[index];
+		}
+		else if (slot.type == Slot::DOUBLE)
+		{
+			binds[i] = static_cast<double*>(slot.value)[index];
+		}
+		else
+		{
+			// '' is NULL in Oracle
+			const std::string str = slot.array
+				? std::string(static_cast<const char*>(slot.value) + index * (slot.length + 1))
+				: *static_cast<std::string*>(slot.value);
+			binds[i] = str.empty() ? TMyOracleValue(nullptr) : TMyOracleValue(str);
+		}
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+void TMyOracleSimDriverStatement::SetBindNull(const std::string& name, bool is_null)
+{
+	auto it = m_slots.find(std::to_upper(name));
+	if (it != m_slots.end())
+	{
+		it->second.is_null = is_null;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::Execute()
+{
+	m_result.Clear();
+	m_row = m_buffered = m_affected = 0;
+	m_server_done = true;
+	m_fetch_failed = false;
+
+	if (!m_query)
+	{
+		m_driver.SetLastError("ORA-24337: statement handle not prepared");
+		return false;
+	}
+
+	std::string error;
+	std::vector<TMyOracleValue> binds;
+	if (!ReadBinds(0, binds, error))
+	{
+		m_driver.SetLastError(error);
+		return false;
+	}
+
+	TMyOracleSimDatabase& database = m_driver.Database();
+	const TMyOracleSimConfig config = database.GetConfig();
+
+	// An insert is applied once its round trip went through: the server
+	// undoes a statement whose call is interrupted or fails
+	const bool write = m_query->GetKind() == TMyOracleSimQuery::Kind::Insert;
+	TMyOracleResultSet result;
+	bool executed = write || m_query->Execute(binds, result, m_affected, error);
+
+	// The execute round trip carries the hard parse and the prefetched rows
+	const size_t prefetched = std::min<size_t>(m_prefetch_size, result.Rows());
+	std::chrono::microseconds server_time = config.fetch_row * static_cast<int64_t>(prefetched);
+	if (!m_parsed)
+	{
+		server_time += config.parse;
+	}
+	if (executed && m_query->GetKind() == TMyOracleSimQuery::Kind::Commit && !m_query->IsNoWait())
+	{
+		server_time += config.log_sync;
+	}
+
+	if (!m_driver.RoundTrip(server_time))
+	{
+		return false;
+	}
+	if (write)
+	{
+		executed = m_query->Execute(binds, result, m_affected, error);
+	}
+	if (!m_parsed)
+	{
+		m_parsed = true;
+		database.Count(TMyOracleSimDatabase::PARSES);
+	}
+	database.Count(TMyOracleSimDatabase::EXECUTES);
+
+	if (!executed)
+	{
+		database.Count(TMyOracleSimDatabase::ERRORS);
+		m_driver.SetLastError(error);
+		return false;
+	}
+
+	switch (m_query->GetKind())
+	{
+	case TMyOracleSimQuery::Kind::Commit:
+		database.Count(TMyOracleSimDatabase::COMMITS);
+		break;
+	case TMyOracleSimQuery::Kind::Rollback:
+		database.Count(TMyOracleSimDatabase::ROLLBACKS);
+		break;
+	default:
+		break;
+	}
+
+	m_result = std::move(result);
+	m_text.assign(m_result.Columns(), TMyOracleTextBuffer());
+
+	// A partial batch tells the client there are no more rows
+	m_buffered = prefetched;
+	m_server_done = m_result.Columns() == 0 || prefetched < m_prefetch_size;
+	database.Count(TMyOracleSimDatabase::ROWS, prefetched);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::ExecuteArray(unsigned int rows)
+{
+	m_result.Clear();
+	m_row = m_buffered = m_affected = 0;
+	m_server_done = true;
+	m_fetch_failed = false;
+	m_batch_errors.clear();
+
+	if (!m_query)
+	{
+		m_driver.SetLastError("ORA-24337: statement handle not prepared");
+		return false;
+	}
+	if (rows > m_array_size)
+	{
+		m_driver.SetLastError("ORA-24333: zero iteration count");
+		return false;
+	}
+
+	TMyOracleSimDatabase& database = m_driver.Database();
+	const TMyOracleSimConfig config = database.GetConfig();
+
+	// The binds are read on the client, before the round trip
+	std::string error;
+	std::vector<std::vector<TMyOracleValue>> binds(rows);
+	for (unsigned int row = 0; row < rows; ++row)
+	{
+		if (!ReadBinds(row, binds[row], error))
+		{
+			m_driver.SetLastError(error);
+			return false;
+		}
+	}
+
+	std::chrono::microseconds server_time = config.fetch_row * static_cast<int64_t>(rows);
+	if (!m_parsed)
+	{
+		server_time += config.parse;
+	}
+	if (!m_driver.RoundTrip(server_time))
+	{
+		return false;
+	}
+
+	// Every row runs on the server within the one round trip, the rows in
+	// error are skipped like in batch error mode. Nothing is written when
+	// the round trip is interrupted or fails.
+	TMyOracleResultSet result;
+	for (unsigned int row = 0; row < rows; ++row)
+	{
+		size_t affected = 0;
+		if (m_query->Execute(binds[row], result, affected, error))
+		{
+			m_affected += affected;
+		}
+		else
+		{
+			m_batch_errors.push_back({ row, std::atoi(error.c_str() + (error.rfind("ORA-", 0) == 0 ? 4 : 0)), error });
+		}
+	}
+	if (!m_parsed)
+	{
+		m_parsed = true;
+		database.Count(TMyOracleSimDatabase::PARSES);
+	}
+	database.Count(TMyOracleSimDatabase::EXECUTES);
+	if (!m_batch_errors.empty())
+	{
+		database.Count(TMyOracleSimDatabase::ERRORS, m_batch_errors.size());
+	}
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDriverStatement::Fetch()
+{
+	m_fetch_failed = false;
+
+	if (m_row < m_buffered)
+	{
+		++m_row;
+		return true;
+	}
+	if (m_server_done)
+	{
+		return false;
+	}
+
+	// One fetch round trip per fetch array
+	const size_t rows = std::min<size_t>(m_fetch_size, m_result.Rows() - m_buffered);
+	TMyOracleSimDatabase& database = m_driver.Database();
+	if (!m_driver.RoundTrip(database.GetConfig().fetch_row * static_cast<int64_t>(rows)))
+	{
+		m_fetch_failed = true;
+		m_server_done = true;
+		return false;
+	}
+	database.Count(TMyOracleSimDatabase::FETCHES);
+	database.Count(TMyOracleSimDatabase::ROWS, rows);
+
+	m_buffered += rows;
+	m_server_done = rows < m_fetch_size;
+
+	if (m_row < m_buffered)
+	{
+		++m_row;
+		return true;
+	}
+	return false;
+}
+// -----------------------------------------------------------------------------
+const char* TMyOracleSimDriverStatement::GetString(unsigned int index, size_t& length)
+{
+	// Strings are read in place, typed cells are formatted per column
+	TMyOracleTextBuffer& buffer = m_text[index - 1];
+	const std::string_view text = Cell(index).GetView(m_row - 1, buffer);
+	length = text.size();
+	return text.data() ? text.data() : "";
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDirectPath::Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool)
+{
+	// The table and its columns are described by the server
+	std::string sql = "INSERT INTO " + table + " (";
+	for (size_t i = 0; i < columns.size(); ++i)
+	{
+		sql += (i > 0 ? ", " : "") + columns[i].name;
+	}
+	sql += ") VALUES (";
+	for (size_t i = 0; i < columns.size(); ++i)
+	{
+		const std::string bind = ":" + std::to_string(i + 1);
+		sql += (i > 0 ? ", " : "") + (columns[i].format.empty() ? bind : "TO_DATE(" + bind + ", '" + columns[i].format + "')");
+	}
+	sql += ")";
+
+	std::string error;
+	if (!m_query.Parse(m_driver.Database(), sql, error))
+	{
+		m_driver.SetLastError(error);
+		return false;
+	}
+	if (!m_driver.RoundTrip(m_driver.Database().GetConfig().parse))
+	{
+		return false;
+	}
+
+	m_rows = rows;
+	m_columns = columns.size();
+	m_buffer_size = buffer_size > 0 ? buffer_size : m_buffer_size;
+	m_values.assign(m_rows * m_columns, nullptr);
+	m_open = true;
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDirectPath::SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length)
+{
+	if (row >= m_rows || column >= m_columns)
+	{
+		m_driver.SetLastError("ORA-39776: fatal Direct Path API error loading table");
+		return false;
+	}
+
+	// '' is NULL in Oracle
+	m_values[row * m_columns + column] = value && length > 0 ? TMyOracleValue(std::string(value, length)) : TMyOracleValue(nullptr);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDirectPath::Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected)
+{
+	loaded = 0;
+	rejected.clear();
+
+	if (!m_open || rows > m_rows)
+	{
+		m_driver.SetLastError("ORA-39776: fatal Direct Path API error loading table");
+		return false;
+	}
+
+	TMyOracleSimDatabase& database = m_driver.Database();
+	const TMyOracleSimConfig config = database.GetConfig();
+
+	std::string error;
+	std::vector<TMyOracleValue> values(m_columns);
+	TMyOracleResultSet result;
+	size_t bytes = 0;
+	for (unsigned int row = 0; row < rows; ++row)
+	{
+		for (size_t i = 0; i < m_columns; ++i)
+		{
+			values[i] = std::move(m_values[row * m_columns + i]);
+			m_values[row * m_columns + i] = nullptr;
+			bytes += 2 + (values[i].index() == 3 ? std::get<std::string>(values[i]).size() : 0);
+		}
+
+		size_t affected = 0;
+		if (m_query.Execute(values, result, affected, error))
+		{
+			loaded += affected;
+		}
+		else
+		{
+			rejected.push_back(row);
+		}
+	}
+
+	// The formatted blocks go up one stream buffer at a time
+	const size_t trips = std::max<size_t>(1, (bytes + m_buffer_size - 1) / m_buffer_size);
+	for (size_t trip = 0; trip < trips; ++trip)
+	{
+		if (!m_driver.RoundTrip(config.direct_path_row * static_cast<int64_t>(rows / trips)))
+		{
+			return false;
+		}
+	}
+	database.Count(TMyOracleSimDatabase::EXECUTES);
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimDirectPath::Finish()
+{
+	if (!m_open)
+	{
+		return false;
+	}
+	m_open = false;
+
+	// Saves the data and rebuilds the indexes
+	if (!m_driver.RoundTrip(m_driver.Database().GetConfig().parse))
+	{
+		return false;
+	}
+	m_driver.Database().Count(TMyOracleSimDatabase::COMMITS);
+	return true;
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,176 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLESIMDRIVER_H__
+#define __TMYORACLESIMDRIVER_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleDriver.h"
+#include "TMyOracleSimQuery.h"
+#include <condition_variable>
+// -----------------------------------------------------------------------------
+class TMyOracleSimPool : public TMyOracleDriverPool
+{
+public:
+	// Logs on min_sessions sessions like an OCI session pool; nullptr if no
+	// database is registered as db
+	static std::unique_ptr<TMyOracleSimPool> Create(const std::string& db, unsigned int min_sessions);
+
+	const std::shared_ptr<TMyOracleSimDatabase>& Database() const { return m_database; }
+
+private:
+	std::shared_ptr<TMyOracleSimDatabase> m_database;
+};
+
+// Driver on a TMyOracleSimDatabase. The connect string is the name the
+// database was registered with, user and password are not checked.
+class TMyOracleSimDriver : public TMyOracleDriver
+{
+public:
+	~TMyOracleSimDriver() override { Disconnect(); }
+
+	bool Connect(const std::string& user, const std::string& password, const std::string& db) override;
+	bool Connect(TMyOracleDriverPool& pool) override;
+	bool Disconnect() override;
+	bool IsConnected() const override { return m_database && !IsLost(); }
+	bool Ping() override { return RoundTrip(); }
+
+	bool Commit(TMyOracleCommitMode mode) override;
+	bool Rollback() override;
+	bool Break(std::string& error) override;
+
+	void SetAutoCommit(bool enabled) override { m_auto_commit = enabled; }
+	void SetStatementCacheSize(unsigned int) override {}
+
+	std::unique_ptr<TMyOracleDriverStatement> CreateStatement() override;
+	std::unique_ptr<TMyOracleDriverDirectPath> CreateDirectPath() override;
+
+	// Waits for one round trip that spends server_time on the server. False
+	// with the ORA error when it is broken or fails.
+	bool RoundTrip(std::chrono::microseconds server_time = std::chrono::microseconds(0));
+
+	TMyOracleSimDatabase& Database() const { return *m_database; }
+	bool GetAutoCommit() const { return m_auto_commit; }
+
+private:
+	std::shared_ptr<TMyOracleSimDatabase> m_database;
+	bool m_auto_commit = false;
+
+	// Round trip in progress, Break() wakes it up
+	std::mutex m_call_mutex;
+	std::condition_variable m_call_cv;
+	bool m_in_call = false;
+	bool m_break = false;
+};
+
+class TMyOracleSimDriverStatement : public TMyOracleDriverStatement
+{
+public:
+	explicit TMyOracleSimDriverStatement(TMyOracleSimDriver& driver) : m_driver(driver) {}
+
+	void SetFetchSize(unsigned int rows) override;
+	void SetPrefetchSize(unsigned int rows) override;
+	unsigned int GetFetchSize() const override { return m_fetch_size; }
+	void SetBindByPosition() override { m_by_position = true; }
+
+	bool Prepare(const std::string& sql) override;
+
+	bool BindInt64(const std::string& name, int64_t* value) override { return Bind(name, Slot::INT64, value, false); }
+	bool BindDouble(const std::string& name, double* value) override { return Bind(name, Slot::DOUBLE, value, false); }
+	bool BindString(const std::string& name, std::string* value, unsigned int) override { return Bind(name, Slot::STRING, value, false); }
+	void SetBindNull(const std::string& name, bool is_null) override;
+
+	bool Execute() override;
+
+	bool SetBindArraySize(unsigned int size) override;
+	bool BindInt64Array(const std::string& name, int64_t* values) override { return Bind(name, Slot::INT64, values, true); }
+	bool BindDoubleArray(const std::string& name, double* values) override { return Bind(name, Slot::DOUBLE, values, true); }
+	bool BindStringArray(const std::string& name, char* values, unsigned int length) override { return Bind(name, Slot::STRING, values, true, length); }
+	void SetBindNullAt(const std::string& name, unsigned int row, bool is_null) override;
+	bool ExecuteArray(unsigned int rows) override;
+
+	std::string GetSql() const override { return m_sql; }
+	unsigned int GetAffectedRows() const override { return static_cast<unsigned int>(m_affected); }
+
+	unsigned int GetColumnCount() const override { return static_cast<unsigned int>(m_result.Columns()); }
+	std::string GetColumnName(unsigned int index) const override { return m_result.GetColumnName(index - 1); }
+	TMyOracleColumnType GetColumnType(unsigned int index) const override { return m_result.GetColumnType(index - 1); }
+
+	bool Fetch() override;
+	bool IsNull(unsigned int index) override { return Cell(index).IsNull(m_row - 1); }
+	int64_t GetInt64(unsigned int index) override { return Cell(index).GetInt64(m_row - 1); }
+	double GetDouble(unsigned int index) override { return Cell(index).GetDouble(m_row - 1); }
+	TMyOracleDate GetDate(unsigned int index) override { return Cell(index).GetDate(m_row - 1); }
+	const char* GetString(unsigned int index, size_t& length) override;
+
+private:
+	// A bound variable, or array of m_array_size of them
+	struct Slot
+	{
+		enum Type { INT64, DOUBLE, STRING } type;
+		void* value;
+		bool is_null = false;
+
+		bool array = false;
+		// Chars per string of an array, without the NUL
+		unsigned int length = 0;
+		std::vector<bool> nulls;
+	};
+
+	bool Bind(const std::string& name, Slot::Type type, void* value, bool array, unsigned int length = 0);
+	// Values of the bound variables for one row of the arrays, false with
+	// the error when one is missing
+	bool ReadBinds(size_t row, std::vector<TMyOracleValue>& binds, std::string& error) const;
+	const TMyOracleColumn& Cell(unsigned int index) const { return m_result.m_columns[index - 1]; }
+
+	TMyOracleSimDriver& m_driver;
+	std::string m_sql;
+	std::unique_ptr<TMyOracleSimQuery> m_query;
+	// The server parses on the first execute
+	bool m_parsed = false;
+
+	bool m_by_position = false;
+	std::unordered_map<std::string, Slot> m_slots;
+	unsigned int m_array_size = 0;
+
+	// OCILIB defaults
+	unsigned int m_fetch_size = 20;
+	unsigned int m_prefetch_size = 20;
+
+	// The rows of the last execute, m_buffered of them made it to the client
+	TMyOracleResultSet m_result;
+	size_t m_affected = 0;
+	size_t m_row = 0;
+	size_t m_buffered = 0;
+	bool m_server_done = true;
+	std::vector<TMyOracleTextBuffer> m_text;
+};
+
+// Direct path load of the simulated database. Rows go through a prepared
+// INSERT but cost direct_path_row each instead of a statement execute, and
+// an array takes one round trip per buffer_size bytes of text. Unlike
+// Oracle, rows are written by Load() (Abort() keeps them) and duplicate
+// keys are rejected rather than leaving the index unusable.
+class TMyOracleSimDirectPath : public TMyOracleDriverDirectPath
+{
+public:
+	explicit TMyOracleSimDirectPath(TMyOracleSimDriver& driver) : m_driver(driver) {}
+
+	bool Prepare(const std::string& table, const std::vector<TMyOracleDirectPathColumn>& columns, unsigned int rows, unsigned int buffer_size, bool parallel) override;
+	bool SetEntry(unsigned int row, unsigned int column, const char* value, unsigned int length) override;
+	bool Load(unsigned int rows, size_t& loaded, std::vector<size_t>& rejected) override;
+	bool Finish() override;
+	void Abort() override { m_open = false; }
+
+private:
+	TMyOracleSimDriver& m_driver;
+	TMyOracleSimQuery m_query;
+	bool m_open = false;
+
+	unsigned int m_rows = 0;
+	size_t m_columns = 0;
+	unsigned int m_buffer_size = 64 * 1024;
+	// m_rows rows of m_columns values
+	std::vector<TMyOracleValue> m_values;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
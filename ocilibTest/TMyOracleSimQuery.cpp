@@ -0,0 +1,1006 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleSimQuery.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+// -----------------------------------------------------------------------------
+enum class TMyOracleSimToken
+{
+	End = 0,
+	Word = 1,		// identifier or keyword, upper case
+	Number = 2,
+	String = 3,		// without the quotes
+	Bind = 4,		// upper case, with the colon
+	Symbol = 5		// ( ) , = * . ;
+};
+// -----------------------------------------------------------------------------
+// Reads a date written with an Oracle format model: DD, MM, YYYY, YY, RR,
+// HH24, HH, MI and SS, anything else is a separator. Returns the text
+// TMyOracleColumn::AppendText() parses.
+static bool ParseDate(const std::string& text, const std::string& format, std::string& date)
+{
+	int year = 1, month = 1, day = 1, hour = 0, minute = 0, second = 0;
+
+	const std::string fmt = std::to_upper(format);
+	size_t t = 0;
+
+	auto Digits = [&text, &t](size_t max_digits, int& value) -> bool
+	{
+		size_t count = 0;
+		value = 0;
+		while (count < max_digits && t < text.size() && std::isdigit(static_cast<unsigned char>(text[t])))
+		{
+			value = value * 10 + (text[t++] - '0');
+			++count;
+		}
+		return count > 0;
+	};
+
+	for (size_t f = 0; f < fmt.size();)
+	{
+		bool ok = true;
+		if (fmt.compare(f, 4, "YYYY") == 0)
+		{
+			ok = Digits(4, year);
+			f += 4;
+		}
+		else if (fmt.compare(f, 4, "HH24") == 0)
+		{
+			ok = Digits(2, hour);
+			f += 4;
+		}
+		else if (fmt.compare(f, 2, "RR") == 0 || fmt.compare(f, 2, "YY") == 0)
+		{
+			// RR puts 00-49 in this century and 50-99 in the previous one
+			ok = Digits(2, year);
+			year += (fmt[f] == 'R' && year >= 50) ? 1900 : 2000;
+			f += 2;
+		}
+		else if (fmt.compare(f, 2, "MM") == 0)
+		{
+			ok = Digits(2, month);
+			f += 2;
+		}
+		else if (fmt.compare(f, 2, "DD") == 0)
+		{
+			ok = Digits(2, day);
+			f += 2;
+		}
+		else if (fmt.compare(f, 2, "HH") == 0)
+		{
+			ok = Digits(2, hour);
+			f += 2;
+		}
+		else if (fmt.compare(f, 2, "MI") == 0)
+		{
+			ok = Digits(2, minute);
+			f += 2;
+		}
+		else if (fmt.compare(f, 2, "SS") == 0)
+		{
+			ok = Digits(2, second);
+			f += 2;
+		}
+		else
+		{
+			++f;
+			++t;
+		}
+
+		if (!ok)
+		{
+			return false;
+		}
+	}
+
+	char str[32];
+	std::snprintf(str, sizeof(str), "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, minute, second);
+	date = str;
+	return true;
+}
+// -----------------------------------------------------------------------------
+static int64_t ToInt64(const TMyOracleValue& value)
+{
+	switch (value.index())
+	{
+	case 1:
+		return std::get<int64_t>(value);
+	case 2:
+		return static_cast<int64_t>(std::get<double>(value));
+	case 3:
+		return std::strtoll(std::get<std::string>(value).c_str(), nullptr, 10);
+	default:
+		return 0;
+	}
+}
+// -----------------------------------------------------------------------------
+static double ToDouble(const TMyOracleValue& value)
+{
+	switch (value.index())
+	{
+	case 1:
+		return static_cast<double>(std::get<int64_t>(value));
+	case 2:
+		return std::get<double>(value);
+	case 3:
+		return std::strtod(std::get<std::string>(value).c_str(), nullptr);
+	default:
+		return 0.0;
+	}
+}
+// -----------------------------------------------------------------------------
+static std::string ToText(const TMyOracleValue& value)
+{
+	switch (value.index())
+	{
+	case 1:
+		return std::to_string(std::get<int64_t>(value));
+	case 2:
+	{
+		char str[32];
+		std::snprintf(str, sizeof(str), "%.15g", std::get<double>(value));
+		return str;
+	}
+	case 3:
+		return std::get<std::string>(value);
+	default:
+		return {};
+	}
+}
+// -----------------------------------------------------------------------------
+// Recursive descent over the tokens of one statement
+class TMyOracleSimParser
+{
+public:
+	TMyOracleSimParser(TMyOracleSimDatabase& database, TMyOracleSimQuery& query, const std::string& sql)
+		: m_database(database), m_query(query)
+	{
+		Tokenize(sql);
+	}
+
+	bool Parse(std::string& error)
+	{
+		bool parsed = false;
+
+		if (Accept("SELECT"))
+		{
+			m_query.m_kind = TMyOracleSimQuery::Kind::Select;
+			parsed = ParseSelect();
+		}
+		else if (Accept("INSERT"))
+		{
+			m_query.m_kind = TMyOracleSimQuery::Kind::Insert;
+			parsed = ParseInsert();
+		}
+		else if (Accept("COMMIT"))
+		{
+			// COMMIT WRITE NOWAIT and friends only change durability
+			m_query.m_kind = TMyOracleSimQuery::Kind::Commit;
+			while (Peek().first == TMyOracleSimToken::Word)
+			{
+				if (Peek().second == "NOWAIT")
+				{
+					m_query.m_nowait = true;
+				}
+				++m_pos;
+			}
+			parsed = true;
+		}
+		else if (Accept("ROLLBACK"))
+		{
+			m_query.m_kind = TMyOracleSimQuery::Kind::Rollback;
+			parsed = true;
+		}
+		else
+		{
+			m_error = "ORA-00900: invalid SQL statement";
+		}
+
+		if (parsed)
+		{
+			Accept(";");
+			if (Peek().first != TMyOracleSimToken::End)
+			{
+				parsed = Fail("ORA-00933: SQL command not properly ended");
+			}
+		}
+
+		error = m_error;
+		return parsed;
+	}
+
+private:
+	using Token = std::pair<TMyOracleSimToken, std::string>;
+
+	void Tokenize(const std::string& sql)
+	{
+		size_t i = 0;
+		while (i < sql.size())
+		{
+			const unsigned char c = sql[i];
+
+			if (std::isspace(c))
+			{
+				++i;
+			}
+			else if (c == '\'')
+			{
+				// '' is a quote inside the string
+				std::string str;
+				for (++i; i < sql.size(); ++i)
+				{
+					if (sql[i] == '\'')
+					{
+						if (i + 1 < sql.size() && sql[i + 1] == '\'')
+						{
+							str += '\'';
+							++i;
+							continue;
+						}
+						++i;
+						break;
+					}
+					str += sql[i];
+				}
+				m_tokens.emplace_back(TMyOracleSimToken::String, str);
+			}
+			else if (c == '"')
+			{
+				const size_t end = sql.find('"', i + 1);
+				m_tokens.emplace_back(TMyOracleSimToken::Word, std::to_upper(sql.substr(i + 1, end - i - 1)));
+				i = end == std::string::npos ? sql.size() : end + 1;
+			}
+			else if (std::isdigit(c) || (c == '-' && i + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i + 1]))))
+			{
+				size_t end = i + 1;
+				while (end < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[end])) || sql[end] == '.'))
+				{
+					++end;
+				}
+				m_tokens.emplace_back(TMyOracleSimToken::Number, sql.substr(i, end - i));
+				i = end;
+			}
+			else if (std::isalpha(c) || c == '_' || (c == ':' && i + 1 < sql.size() && std::isalnum(static_cast<unsigned char>(sql[i + 1]))))
+			{
+				size_t end = i + 1;
+				while (end < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[end])) || sql[end] == '_' || sql[end] == '$' || sql[end] == '#'))
+				{
+					++end;
+				}
+				m_tokens.emplace_back(c == ':' ? TMyOracleSimToken::Bind : TMyOracleSimToken::Word, std::to_upper(sql.substr(i, end - i)));
+				i = end;
+			}
+			else
+			{
+				m_tokens.emplace_back(TMyOracleSimToken::Symbol, std::string(1, static_cast<char>(c)));
+				++i;
+			}
+		}
+	}
+
+	const Token& Peek(size_t ahead = 0) const
+	{
+		static const Token END{ TMyOracleSimToken::End, "" };
+		return m_pos + ahead < m_tokens.size() ? m_tokens[m_pos + ahead] : END;
+	}
+
+	// Consumes the keyword or symbol if it is next
+	bool Accept(const char* text)
+	{
+		const Token& token = Peek();
+		if ((token.first == TMyOracleSimToken::Word || token.first == TMyOracleSimToken::Symbol) && token.second == text)
+		{
+			++m_pos;
+			return true;
+		}
+		return false;
+	}
+
+	bool Expect(const char* text)
+	{
+		return Accept(text) || Fail(std::string("ORA-00936: missing expression near ") + (Peek().second.empty() ? "end of statement" : Peek().second) + ", expected " + text);
+	}
+
+	bool Fail(const std::string& error)
+	{
+		if (m_error.empty())
+		{
+			m_error = error;
+		}
+		return false;
+	}
+
+	bool IsKeyword(const std::string& word) const
+	{
+		static const char* KEYWORDS[] = { "FROM", "WHERE", "INNER", "JOIN", "ON", "AND", "ORDER", "GROUP", "AS", "VALUES", "IN" };
+		for (const char* keyword : KEYWORDS)
+		{
+			if (word == keyword)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Identifier(std::string& name)
+	{
+		const Token& token = Peek();
+		if (token.first != TMyOracleSimToken::Word || IsKeyword(token.second))
+		{
+			return Fail("ORA-00936: missing expression");
+		}
+		name = token.second;
+		++m_pos;
+		return true;
+	}
+
+	// [qualifier.]name
+	bool ColumnName(std::string& qualifier, std::string& name)
+	{
+		qualifier.clear();
+		if (!Identifier(name))
+		{
+			return false;
+		}
+		if (Accept("."))
+		{
+			qualifier = name;
+			return Identifier(name);
+		}
+		return true;
+	}
+
+	// [schema.]table [alias]
+	bool Table(size_t slot)
+	{
+		std::string name;
+		if (!Identifier(name))
+		{
+			return false;
+		}
+		if (Accept(".") && !Identifier(name))
+		{
+			return false;
+		}
+
+		TMyOracleSimTable* table = m_database.FindTable(name);
+		if (!table)
+		{
+			return Fail("ORA-00942: table or view does not exist");
+		}
+
+		m_query.m_tables[slot] = table;
+		m_query.m_aliases[slot] = table->Name();
+		m_query.m_table_count = slot + 1;
+
+		const Token& alias = Peek();
+		if (alias.first == TMyOracleSimToken::Word && !IsKeyword(alias.second))
+		{
+			m_query.m_aliases[slot] = alias.second;
+			++m_pos;
+		}
+		return true;
+	}
+
+	bool Resolve(const std::string& qualifier, const std::string& name, TMyOracleSimQuery::ColumnRef& ref)
+	{
+		bool found = false;
+		for (size_t t = 0; t < m_query.m_table_count; ++t)
+		{
+			if (!qualifier.empty() && qualifier != m_query.m_aliases[t] && qualifier != m_query.m_tables[t]->Name())
+			{
+				continue;
+			}
+
+			const size_t column = m_query.m_tables[t]->FindColumn(name);
+			if (column < m_query.m_tables[t]->Columns())
+			{
+				if (found)
+				{
+					return Fail("ORA-00918: column ambiguously defined");
+				}
+				ref.table = t;
+				ref.column = column;
+				found = true;
+			}
+		}
+
+		return found || Fail("ORA-00904: \"" + (qualifier.empty() ? name : qualifier + "\".\"" + name) + "\": invalid identifier");
+	}
+
+	bool Operand(TMyOracleSimQuery::Operand& operand)
+	{
+		const Token token = Peek();
+		++m_pos;
+
+		switch (token.first)
+		{
+		case TMyOracleSimToken::Number:
+			if (token.second.find('.') == std::string::npos)
+			{
+				operand.value = static_cast<int64_t>(std::strtoll(token.second.c_str(), nullptr, 10));
+			}
+			else
+			{
+				operand.value = std::strtod(token.second.c_str(), nullptr);
+			}
+			return true;
+		case TMyOracleSimToken::String:
+			// '' is NULL in Oracle
+			operand.value = token.second.empty() ? TMyOracleValue(nullptr) : TMyOracleValue(token.second);
+			return true;
+		case TMyOracleSimToken::Bind:
+			operand.bind = m_query.m_binds.size();
+			m_query.m_binds.push_back(token.second);
+			return true;
+		case TMyOracleSimToken::Word:
+			if (token.second == "NULL")
+			{
+				operand.value = nullptr;
+				return true;
+			}
+			if (token.second == "TO_DATE")
+			{
+				const Token& text = Peek(1);
+				const Token& format = Peek(3);
+				std::string date;
+				if (!Expect("(") || (text.first != TMyOracleSimToken::String && text.first != TMyOracleSimToken::Bind))
+				{
+					return Fail("ORA-00936: missing expression");
+				}
+				++m_pos;
+				if (!Expect(",") || format.first != TMyOracleSimToken::String)
+				{
+					return Fail("ORA-00936: missing expression");
+				}
+				++m_pos;
+				if (!Expect(")"))
+				{
+					return false;
+				}
+				if (text.first == TMyOracleSimToken::Bind)
+				{
+					// Converted by Execute() once the value is known
+					operand.bind = m_query.m_binds.size();
+					m_query.m_binds.push_back(text.second);
+					m_query.m_date_binds.emplace_back(operand.bind, format.second);
+					return true;
+				}
+				if (!ParseDate(text.second, format.second, date))
+				{
+					return Fail("ORA-01858: a non-numeric character was found where a numeric was expected");
+				}
+				operand.value = date;
+				return true;
+			}
+			break;
+		default:
+			break;
+		}
+
+		return Fail("ORA-00936: missing expression");
+	}
+
+	bool ParseSelect()
+	{
+		struct Item
+		{
+			std::string qualifier;
+			std::string name;
+			std::string alias;
+		};
+		std::vector<Item> items;
+		bool star = false;
+
+		if (Accept("*"))
+		{
+			star = true;
+		}
+		else if (Peek().second == "COUNT" && Peek(1).second == "(")
+		{
+			m_pos += 2;
+			if (!Expect("*") || !Expect(")"))
+			{
+				return false;
+			}
+			m_query.m_count = true;
+			items.push_back({ "", "", "COUNT(*)" });
+			Accept("AS");
+			if (Peek().first == TMyOracleSimToken::Word && !IsKeyword(Peek().second))
+			{
+				items.back().alias = Peek().second;
+				++m_pos;
+			}
+		}
+		else
+		{
+			do
+			{
+				Item item;
+				if (!ColumnName(item.qualifier, item.name))
+				{
+					return false;
+				}
+				item.alias = item.name;
+
+				const bool as = Accept("AS");
+				if (Peek().first == TMyOracleSimToken::Word && !IsKeyword(Peek().second))
+				{
+					item.alias = Peek().second;
+					++m_pos;
+				}
+				else if (as)
+				{
+					return Fail("ORA-00923: FROM keyword not found where expected");
+				}
+				items.push_back(item);
+			} while (Accept(","));
+		}
+
+		if (!Accept("FROM"))
+		{
+			return Fail("ORA-00923: FROM keyword not found where expected");
+		}
+		if (!Table(0))
+		{
+			return false;
+		}
+
+		const bool inner = Accept("INNER");
+		if (Accept("JOIN"))
+		{
+			std::string lq, ln, rq, rn;
+			TMyOracleSimQuery::ColumnRef left, right;
+			if (!Table(1) || !Expect("ON") || !ColumnName(lq, ln) || !Expect("=") || !ColumnName(rq, rn)
+				|| !Resolve(lq, ln, left) || !Resolve(rq, rn, right))
+			{
+				return false;
+			}
+			if (left.table == right.table)
+			{
+				return Fail("ORA-00904: join condition must compare the two tables");
+			}
+			m_query.m_join_left = left.table == 0 ? left : right;
+			m_query.m_join_right = left.table == 0 ? right : left;
+		}
+		else if (inner)
+		{
+			return Fail("ORA-00905: missing keyword");
+		}
+
+		if (m_query.m_count)
+		{
+			m_query.m_outputs.push_back({ {}, items.front().alias });
+		}
+		else if (star)
+		{
+			for (size_t t = 0; t < m_query.m_table_count; ++t)
+			{
+				const TMyOracleSimTable* table = m_query.m_tables[t];
+				for (size_t c = 0; c < table->Columns(); ++c)
+				{
+					m_query.m_outputs.push_back({ { t, c }, table->GetColumnName(c) });
+				}
+			}
+		}
+		else
+		{
+			for (const Item& item : items)
+			{
+				TMyOracleSimQuery::Output output;
+				if (!Resolve(item.qualifier, item.name, output.ref))
+				{
+					return false;
+				}
+				output.name = item.alias;
+				m_query.m_outputs.push_back(output);
+			}
+		}
+
+		if (Accept("WHERE"))
+		{
+			do
+			{
+				std::string qualifier, name;
+				TMyOracleSimQuery::Predicate predicate;
+				if (!ColumnName(qualifier, name) || !Resolve(qualifier, name, predicate.column))
+				{
+					return false;
+				}
+
+				if (Accept("="))
+				{
+					predicate.values.emplace_back();
+					if (!Operand(predicate.values.back()))
+					{
+						return false;
+					}
+				}
+				else if (Accept("IN"))
+				{
+					if (!Expect("("))
+					{
+						return false;
+					}
+					do
+					{
+						predicate.values.emplace_back();
+						if (!Operand(predicate.values.back()))
+						{
+							return false;
+						}
+					} while (Accept(","));
+					if (!Expect(")"))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					return Fail("ORA-00920: invalid relational operator");
+				}
+
+				m_query.m_where.push_back(predicate);
+			} while (Accept("AND"));
+		}
+
+		return true;
+	}
+
+	bool ParseInsert()
+	{
+		if (!Expect("INTO") || !Table(0))
+		{
+			return false;
+		}
+		const TMyOracleSimTable* table = m_query.m_tables[0];
+
+		if (Accept("("))
+		{
+			do
+			{
+				std::string name;
+				if (!Identifier(name))
+				{
+					return false;
+				}
+				const size_t column = table->FindColumn(name);
+				if (column >= table->Columns())
+				{
+					return Fail("ORA-00904: \"" + name + "\": invalid identifier");
+				}
+				m_query.m_insert_columns.push_back(column);
+			} while (Accept(","));
+			if (!Expect(")"))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			for (size_t c = 0; c < table->Columns(); ++c)
+			{
+				m_query.m_insert_columns.push_back(c);
+			}
+		}
+
+		if (!Expect("VALUES") || !Expect("("))
+		{
+			return false;
+		}
+		do
+		{
+			m_query.m_insert_values.emplace_back();
+			if (!Operand(m_query.m_insert_values.back()))
+			{
+				return false;
+			}
+		} while (Accept(","));
+		if (!Expect(")"))
+		{
+			return false;
+		}
+
+		if (m_query.m_insert_values.size() < m_query.m_insert_columns.size())
+		{
+			return Fail("ORA-00947: not enough values");
+		}
+		if (m_query.m_insert_values.size() > m_query.m_insert_columns.size())
+		{
+			return Fail("ORA-00913: too many values");
+		}
+		return true;
+	}
+
+	TMyOracleSimDatabase& m_database;
+	TMyOracleSimQuery& m_query;
+	std::vector<Token> m_tokens;
+	size_t m_pos = 0;
+	std::string m_error;
+};
+// -----------------------------------------------------------------------------
+bool TMyOracleSimQuery::Parse(TMyOracleSimDatabase& database, const std::string& sql, std::string& error)
+{
+	*this = TMyOracleSimQuery();
+
+	TMyOracleSimParser parser(database, *this, sql);
+	return parser.Parse(error);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimQuery::Execute(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result, size_t& affected, std::string& error) const
+{
+	affected = 0;
+
+	if (binds.size() < m_binds.size())
+	{
+		error = "ORA-01008: not all variables bound";
+		return false;
+	}
+
+	if (!m_date_binds.empty())
+	{
+		// TO_DATE(:bind, 'format')
+		std::vector<TMyOracleValue> converted(binds);
+		for (const auto& [bind, format] : m_date_binds)
+		{
+			TMyOracleValue& value = converted[bind];
+			std::string date;
+			if (value.index() == 3)
+			{
+				if (!ParseDate(std::get<std::string>(value), format, date))
+				{
+					error = "ORA-01858: a non-numeric character was found where a numeric was expected";
+					return false;
+				}
+				value = date;
+			}
+			else if (value.index() != 0)
+			{
+				error = "ORA-01858: a non-numeric character was found where a numeric was expected";
+				return false;
+			}
+		}
+		return Run(converted, result, affected, error);
+	}
+	return Run(binds, result, affected, error);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimQuery::Run(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result, size_t& affected, std::string& error) const
+{
+	switch (m_kind)
+	{
+	case Kind::Select:
+		return ExecuteSelect(binds, result);
+	case Kind::Insert:
+		return ExecuteInsert(binds, affected, error);
+	default:
+		return true;
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimQuery::ExecuteSelect(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result) const
+{
+	auto Value = [&binds](const Operand& operand) -> const TMyOracleValue&
+	{
+		return operand.bind == std::string::npos ? operand.value : binds[operand.bind];
+	};
+
+	auto Matches = [this, &Value](const Predicate& predicate, size_t row) -> bool
+	{
+		const TMyOracleColumn& column = m_tables[predicate.column.table]->m_data.m_columns[predicate.column.column];
+		if (column.IsNull(row))
+		{
+			return false;
+		}
+
+		for (const Operand& operand : predicate.values)
+		{
+			const TMyOracleValue& value = Value(operand);
+			if (value.index() == 0)
+			{
+				continue;
+			}
+
+			switch (column.Type())
+			{
+			case TMyOracleColumnType::Int64:
+				if (column.GetInt64(row) == ToInt64(value))
+				{
+					return true;
+				}
+				break;
+			case TMyOracleColumnType::Double:
+				if (column.GetDouble(row) == ToDouble(value))
+				{
+					return true;
+				}
+				break;
+			default:
+			{
+				TMyOracleTextBuffer buffer;
+				if (column.GetView(row, buffer) == ToText(value))
+				{
+					return true;
+				}
+				break;
+			}
+			}
+		}
+		return false;
+	};
+
+	const TMyOracleSimTable* left = m_tables[0];
+	const TMyOracleSimTable* right = m_table_count > 1 ? m_tables[1] : nullptr;
+
+	std::shared_lock<std::shared_mutex> left_lock(left->m_mutex);
+	std::shared_lock<std::shared_mutex> right_lock;
+	if (right && right != left)
+	{
+		right_lock = std::shared_lock<std::shared_mutex>(right->m_mutex);
+	}
+
+	// Rows of the first table: through the index of a NUMBER(p,0) column
+	// compared in the WHERE clause, or a full scan
+	std::vector<size_t> rows;
+	bool indexed = false;
+	for (const Predicate& predicate : m_where)
+	{
+		if (predicate.column.table != 0 || left->m_data.GetColumnType(predicate.column.column) != TMyOracleColumnType::Int64)
+		{
+			continue;
+		}
+
+		const auto& index = left->m_indexes[predicate.column.column];
+		for (const Operand& operand : predicate.values)
+		{
+			const TMyOracleValue& value = Value(operand);
+			if (value.index() == 0)
+			{
+				continue;
+			}
+			const auto range = index.equal_range(ToInt64(value));
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				rows.push_back(it->second);
+			}
+		}
+
+		// IN lists may repeat a value, rows may not
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+		indexed = true;
+		break;
+	}
+	if (!indexed)
+	{
+		rows.resize(left->m_data.Rows());
+		for (size_t row = 0; row < rows.size(); ++row)
+		{
+			rows[row] = row;
+		}
+	}
+
+	std::vector<std::pair<size_t, size_t>> matches;
+	std::vector<size_t> joined;
+
+	for (const size_t row : rows)
+	{
+		bool match = true;
+		for (const Predicate& predicate : m_where)
+		{
+			if (predicate.column.table == 0 && !Matches(predicate, row))
+			{
+				match = false;
+				break;
+			}
+		}
+		if (!match)
+		{
+			continue;
+		}
+
+		if (!right)
+		{
+			matches.emplace_back(row, 0);
+			continue;
+		}
+
+		// Rows of the second table with the join key of this row
+		const TMyOracleColumn& key = left->m_data.m_columns[m_join_left.column];
+		if (key.IsNull(row))
+		{
+			continue;
+		}
+
+		joined.clear();
+		const TMyOracleColumn& other = right->m_data.m_columns[m_join_right.column];
+		if (other.Type() == TMyOracleColumnType::Int64)
+		{
+			const auto range = right->m_indexes[m_join_right.column].equal_range(key.GetInt64(row));
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				joined.push_back(it->second);
+			}
+			std::sort(joined.begin(), joined.end());
+		}
+		else
+		{
+			const std::string value = key.GetString(row);
+			TMyOracleTextBuffer buffer;
+			for (size_t r = 0; r < right->m_data.Rows(); ++r)
+			{
+				if (!other.IsNull(r) && other.GetView(r, buffer) == value)
+				{
+					joined.push_back(r);
+				}
+			}
+		}
+
+		for (const size_t r : joined)
+		{
+			bool right_match = true;
+			for (const Predicate& predicate : m_where)
+			{
+				if (predicate.column.table == 1 && !Matches(predicate, r))
+				{
+					right_match = false;
+					break;
+				}
+			}
+			if (right_match)
+			{
+				matches.emplace_back(row, r);
+			}
+		}
+	}
+
+	result.m_columns.clear();
+	result.m_rowCount = 0;
+	result.m_currentRow = 0;
+
+	if (m_count)
+	{
+		result.m_columns.emplace_back(m_outputs.front().name, TMyOracleColumnType::Int64);
+		result.m_columns.front().AppendInt64(static_cast<int64_t>(matches.size()));
+		result.m_rowCount = 1;
+		return true;
+	}
+
+	result.m_columns.reserve(m_outputs.size());
+	for (const Output& output : m_outputs)
+	{
+		result.m_columns.emplace_back(output.name, m_tables[output.ref.table]->m_data.GetColumnType(output.ref.column));
+	}
+	result.Reserve(matches.size());
+
+	for (const auto& match : matches)
+	{
+		for (size_t i = 0; i < m_outputs.size(); ++i)
+		{
+			const ColumnRef& ref = m_outputs[i].ref;
+			result.m_columns[i].AppendFrom(m_tables[ref.table]->m_data.m_columns[ref.column], ref.table == 0 ? match.first : match.second);
+		}
+		++result.m_rowCount;
+	}
+
+	return true;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleSimQuery::ExecuteInsert(const std::vector<TMyOracleValue>& binds, size_t& affected, std::string& error) const
+{
+	std::vector<TMyOracleValue> values(m_tables[0]->Columns(), nullptr);
+	for (size_t i = 0; i < m_insert_columns.size(); ++i)
+	{
+		const Operand& operand = m_insert_values[i];
+		values[m_insert_columns[i]] = operand.bind == std::string::npos ? operand.value : binds[operand.bind];
+	}
+
+	if (!m_tables[0]->Insert(values, error))
+	{
+		return false;
+	}
+	affected = 1;
+	return true;
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,101 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLESIMQUERY_H__
+#define __TMYORACLESIMQUERY_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracleSimDatabase.h"
+// -----------------------------------------------------------------------------
+
+// A statement of the simulated database, parsed once and executed with
+// new bind values any number of times. The supported SQL is what this
+// project sends:
+//
+//	SELECT * | COUNT(*) | col [[AS] alias], ...
+//	  FROM table [alias] [[INNER] JOIN table [alias] ON col = col]
+//	  [WHERE col = value | col IN (value, ...) [AND ...]]
+//	INSERT INTO table [(col, ...)] VALUES (value, ...)
+//	COMMIT [WRITE ...] | ROLLBACK
+//
+// where a value is a number, a 'string', NULL, TO_DATE('text', 'format'),
+// TO_DATE(:bind, 'format') or a :bind. Errors use the ORA codes and messages of the real server.
+class TMyOracleSimQuery
+{
+	friend class TMyOracleSimParser;
+
+public:
+	enum class Kind
+	{
+		Select = 1,
+		Insert = 2,
+		Commit = 3,
+		Rollback = 4
+	};
+
+	bool Parse(TMyOracleSimDatabase& database, const std::string& sql, std::string& error);
+
+	Kind GetKind() const { return m_kind; }
+	// COMMIT that does not wait for the redo to be written
+	bool IsNoWait() const { return m_nowait; }
+	// Bind placeholders in order of appearance, upper case with the colon.
+	// A name used twice appears twice, as it takes two positions.
+	const std::vector<std::string>& Binds() const { return m_binds; }
+
+	// binds holds one value per Binds() entry. A query replaces the content
+	// of result, DML sets affected.
+	bool Execute(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result, size_t& affected, std::string& error) const;
+
+private:
+	// A literal, or the value of m_binds[bind]
+	struct Operand
+	{
+		TMyOracleValue value;
+		size_t bind = std::string::npos;
+	};
+
+	// Column of m_tables[table]
+	struct ColumnRef
+	{
+		size_t table = 0;
+		size_t column = 0;
+	};
+
+	struct Output
+	{
+		ColumnRef ref;
+		std::string name;
+	};
+
+	struct Predicate
+	{
+		ColumnRef column;
+		std::vector<Operand> values;
+	};
+
+	// Execute() once the binds are converted
+	bool Run(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result, size_t& affected, std::string& error) const;
+	bool ExecuteSelect(const std::vector<TMyOracleValue>& binds, TMyOracleResultSet& result) const;
+	bool ExecuteInsert(const std::vector<TMyOracleValue>& binds, size_t& affected, std::string& error) const;
+
+	Kind m_kind = Kind::Select;
+	bool m_nowait = false;
+
+	TMyOracleSimTable* m_tables[2] = { nullptr, nullptr };
+	std::string m_aliases[2];
+	size_t m_table_count = 0;
+
+	std::vector<Output> m_outputs;
+	bool m_count = false;
+	ColumnRef m_join_left;	// in m_tables[0]
+	ColumnRef m_join_right;	// in m_tables[1]
+	std::vector<Predicate> m_where;
+
+	std::vector<size_t> m_insert_columns;
+	std::vector<Operand> m_insert_values;
+
+	std::vector<std::string> m_binds;
+	// Binds read through TO_DATE, with their format
+	std::vector<std::pair<size_t, std::string>> m_date_binds;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,143 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLETASK_H__
+#define __TMYORACLETASK_H__
+// -----------------------------------------------------------------------------
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+// -----------------------------------------------------------------------------
+template<typename T> class TMyOracleTask;
+// -----------------------------------------------------------------------------
+struct TMyOracleTaskPromiseBase
+{
+	// Resumes whoever awaits the task once it finishes
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			std::coroutine_handle<> continuation = handle.promise().continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	// Tasks are lazy, they start when awaited or spawned
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() { exception = std::current_exception(); }
+
+	std::coroutine_handle<> continuation;
+	std::exception_ptr exception;
+};
+// -----------------------------------------------------------------------------
+template<typename T>
+struct TMyOracleTaskPromise : TMyOracleTaskPromiseBase
+{
+	TMyOracleTask<T> get_return_object();
+	void return_value(T value) { result.emplace(std::move(value)); }
+
+	std::optional<T> result;
+};
+// -----------------------------------------------------------------------------
+template<>
+struct TMyOracleTaskPromise<void> : TMyOracleTaskPromiseBase
+{
+	TMyOracleTask<void> get_return_object();
+	void return_void() const noexcept {}
+};
+// -----------------------------------------------------------------------------
+
+// Coroutine returning T, e.g.
+//
+//	TMyOracleTask<int> CountEmployees(TMyOracleScheduler& scheduler)
+//	{
+//		auto rs = co_await scheduler.ExecuteQuery("SELECT COUNT(*) AS N FROM employee");
+//		co_return rs ? static_cast<int>(rs->GetInt64("N")) : -1;
+//	}
+//
+// A task owns its coroutine frame. It starts running when it is awaited, or
+// when it is handed to TMyOracleScheduler::Spawn().
+template<typename T>
+class TMyOracleTask
+{
+public:
+	using promise_type = TMyOracleTaskPromise<T>;
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	TMyOracleTask() = default;
+	explicit TMyOracleTask(handle_type handle) : m_handle(handle) {}
+	~TMyOracleTask()
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+		}
+	}
+
+	// Prevent copying
+	TMyOracleTask(const TMyOracleTask&) = delete;
+	TMyOracleTask& operator=(const TMyOracleTask&) = delete;
+
+	// Allow moving
+	TMyOracleTask(TMyOracleTask&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+	TMyOracleTask& operator=(TMyOracleTask&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+			}
+			m_handle = std::exchange(other.m_handle, {});
+		}
+		return *this;
+	}
+
+	bool Done() const { return !m_handle || m_handle.done(); }
+	handle_type Handle() const { return m_handle; }
+
+	// Awaiting a task runs it and resumes the caller when it finishes
+	bool await_ready() const noexcept { return Done(); }
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		m_handle.promise().continuation = awaiting;
+		return m_handle;
+	}
+
+	T await_resume()
+	{
+		if (m_handle.promise().exception)
+		{
+			std::rethrow_exception(m_handle.promise().exception);
+		}
+		if constexpr (!std::is_void_v<T>)
+		{
+			return std::move(*m_handle.promise().result);
+		}
+	}
+
+private:
+	handle_type m_handle;
+};
+// -----------------------------------------------------------------------------
+template<typename T>
+TMyOracleTask<T> TMyOracleTaskPromise<T>::get_return_object()
+{
+	return TMyOracleTask<T>(std::coroutine_handle<TMyOracleTaskPromise<T>>::from_promise(*this));
+}
+// -----------------------------------------------------------------------------
+inline TMyOracleTask<void> TMyOracleTaskPromise<void>::get_return_object()
+{
+	return TMyOracleTask<void>(std::coroutine_handle<TMyOracleTaskPromise<void>>::from_promise(*this));
+}
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+#include "TMyOracleTransaction.h"
+#include "TMyOracleLog.h"
+#include <iostream>
+// -----------------------------------------------------------------------------
+TMyOracleTransaction::TMyOracleTransaction(TMyOracle* sql, TMyOracleCommitMode mode)
+	: m_sql{ sql }, m_mode{ mode }, m_active{ sql && sql->BeginTransaction() }
+{
+}
+// -----------------------------------------------------------------------------
+TMyOracleTransaction::~TMyOracleTransaction()
+{
+	if (m_active)
+	{
+		Rollback();
+	}
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleTransaction::Commit()
+{
+	if (!m_active)
+	{
+		return false;
+	}
+	m_active = false;
+	return m_sql->EndTransaction(true, m_mode);
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleTransaction::Rollback()
+{
+	if (!m_active)
+	{
+		return false;
+	}
+	m_active = false;
+	return m_sql->EndTransaction(false, m_mode);
+}
+// -----------------------------------------------------------------------------
+TMyOracleGroupCommit::TMyOracleGroupCommit(TMyOracle* sql, size_t max_statements, std::chrono::microseconds max_delay, TMyOracleCommitMode mode)
+	: m_sql{ sql }, m_max_statements{ max_statements > 0 ? max_statements : 1 }, m_max_delay{ max_delay }, m_mode{ mode }
+{
+}
+// -----------------------------------------------------------------------------
+TMyOracleGroupCommit::~TMyOracleGroupCommit()
+{
+	Flush();
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleGroupCommit::Execute(const std::string& query, const TMyOracleBinds& binds, size_t* affected)
+{
+	if (!m_transaction)
+	{
+		m_transaction = std::make_unique<TMyOracleTransaction>(m_sql, m_mode);
+		if (!m_transaction->IsActive())
+		{
+			TMYORACLE_LOG_ERROR("TMyOracleGroupCommit::Execute: Failed to open a transaction");
+			m_transaction.reset();
+			return false;
+		}
+		m_first = std::chrono::steady_clock::now();
+	}
+
+	const bool executed = m_sql->ExecuteStatement(query, binds, affected);
+	if (executed)
+	{
+		++m_pending;
+	}
+
+	if (m_pending >= m_max_statements
+		|| (m_max_delay != std::chrono::microseconds::max() && std::chrono::steady_clock::now() - m_first >= m_max_delay))
+	{
+		return Flush() && executed;
+	}
+	return executed;
+}
+// -----------------------------------------------------------------------------
+bool TMyOracleGroupCommit::Flush()
+{
+	if (!m_transaction)
+	{
+		return true;
+	}
+
+	const bool committed = m_transaction->Commit();
+	if (m_pending > 0)
+	{
+		++m_commits;
+	}
+	m_transaction.reset();
+	m_pending = 0;
+	return committed;
+}
+// -----------------------------------------------------------------------------
@@ -0,0 +1,94 @@
+// -----------------------------------------------------------------------------
+#ifndef __TMYORACLETRANSACTION_H__
+#define __TMYORACLETRANSACTION_H__
+// -----------------------------------------------------------------------------
+#include "TMyOracle.h"
+#include <chrono>
+#include <memory>
+// -----------------------------------------------------------------------------
+
+// Transaction scope on one connection. The statements run on the connection
+// while it is open are not committed one by one: Commit() commits all of
+// them in one round trip, Rollback() or the destructor undoes them. A
+// statement that fails inside the scope is undone by the server on its own
+// and does not end the transaction.
+//
+//	TMyOracleTransaction transaction(sql);
+//	sql->ExecuteStatement("INSERT ...", binds);
+//	sql->ExecuteStatement("UPDATE ...", binds);
+//	transaction.Commit();
+//
+// There is one transaction per connection, a second scope opened on it is
+// not active. The connection is not reserved: statements of other threads
+// on it join the transaction.
+class TMyOracleTransaction
+{
+public:
+	// NoWait commits do not wait for the redo to be written, see
+	// TMyOracleCommitMode
+	explicit TMyOracleTransaction(TMyOracle* sql, TMyOracleCommitMode mode = TMyOracleCommitMode::Wait);
+	~TMyOracleTransaction();
+
+	// Prevent copying
+	TMyOracleTransaction(const TMyOracleTransaction&) = delete;
+	TMyOracleTransaction& operator=(const TMyOracleTransaction&) = delete;
+
+	// Until Commit() or Rollback()
+	bool IsActive() const { return m_active; }
+
+	// Both end the transaction, also when they fail. False when it was not
+	// active.
+	bool Commit();
+	bool Rollback();
+
+private:
+	TMyOracle* m_sql;
+	TMyOracleCommitMode m_mode;
+	bool m_active;
+};
+
+// Group commit: DML statements are run in transactions of up to
+// max_statements statements, or max_delay from the first one, committed in
+// one round trip each, instead of a commit per statement. The delay is
+// checked when a statement is run, there is no timer: Flush() commits what
+// is pending, as does the destructor.
+//
+// A NoWait mode makes every commit asynchronous (COMMIT WRITE NOWAIT): the
+// rows are visible to the other sessions at once but a crash of the server
+// may lose the last groups.
+class TMyOracleGroupCommit
+{
+public:
+	TMyOracleGroupCommit(TMyOracle* sql, size_t max_statements, std::chrono::microseconds max_delay = std::chrono::microseconds::max(), TMyOracleCommitMode mode = TMyOracleCommitMode::Wait);
+	~TMyOracleGroupCommit();
+
+	// Prevent copying
+	TMyOracleGroupCommit(const TMyOracleGroupCommit&) = delete;
+	TMyOracleGroupCommit& operator=(const TMyOracleGroupCommit&) = delete;
+
+	// See TMyOracle::ExecuteStatement(). False if the statement failed, or
+	// the commit of the group it completed did.
+	bool Execute(const std::string& query, const TMyOracleBinds& binds = {}, size_t* affected = nullptr);
+
+	// Commits the pending statements, true when there are none
+	bool Flush();
+
+	// Statements run since the last commit
+	size_t Pending() const { return m_pending; }
+	size_t Commits() const { return m_commits; }
+
+private:
+	TMyOracle* m_sql;
+	size_t m_max_statements;
+	std::chrono::microseconds m_max_delay;
+	TMyOracleCommitMode m_mode;
+
+	std::unique_ptr<TMyOracleTransaction> m_transaction;
+	std::chrono::steady_clock::time_point m_first;
+	size_t m_pending = 0;
+	size_t m_commits = 0;
+};
+
+// -----------------------------------------------------------------------------
+#endif
+// -----------------------------------------------------------------------------
@@ -1,22 +1,69 @@
 // -----------------------------------------------------------------------------
-#include "ocilib.hpp"
 #include "TMyOracle.h"
 #include "TMyOracleResultSet.h"
+#include "TMyOracleSimDatabase.h"
 #include "SqlConnection.h"
+#include "TMyOracleBenchmark.h"
+#include "TMyOracleCursor.h"
+#include "TMyOracleResultCache.h"
+#include "TMyOracleReferenceCache.h"
+#include "TMyOracleLoader.h"
+#include "TMyOracleDirectPathLoader.h"
+#include "TMyOracleExecutor.h"
+#include "TMyOracleTransaction.h"
+#include "TMyOracleLog.h"
 #include <thread>
 #include <chrono>
+#include <fstream>
 // -----------------------------------------------------------------------------
 static std::unique_ptr<SqlConnection> g_sql_conn = nullptr;
 static auto g_oci_type = OCI_TYPE::OCI_C_API;
+// Replicated reference tables. Once DEPARTMENT is loaded the employee
+// queries no longer join it, the department is looked up here.
+static TMyOracleReferenceCache g_reference_data;
+// How often the replicated tables are read again
+static constexpr std::chrono::seconds REFERENCE_REFRESH_INTERVAL{ 60 };
 
 // -----------------------------------------------------------------------------
 
+// Typed rows of the employee queries, decoded by TMyOracle::ExecuteAs()
+struct EmployeeRow
+{
+    std::string first_name;
+    std::string last_name;
+    TMyOracleDate dob;
+    std::string address;
+    int64_t dept_id = 0;
+
+    static constexpr auto Fields()
+    {
+        return std::make_tuple(
+            TMyOracleField{ "FIRSTNAME", &EmployeeRow::first_name },
+            TMyOracleField{ "LASTNAME", &EmployeeRow::last_name },
+            TMyOracleField{ "DOB", &EmployeeRow::dob },
+            TMyOracleField{ "ADDRESS", &EmployeeRow::address },
+            TMyOracleField{ "DEPT_ID", &EmployeeRow::dept_id });
+    }
+};
+
+// With the department joined on the server
+struct EmployeeDepartmentRow : EmployeeRow
+{
+    std::string dept_desc;
+
+    static constexpr auto Fields()
+    {
+        return std::tuple_cat(EmployeeRow::Fields(), std::make_tuple(
+            TMyOracleField{ "DEPT_DESC", &EmployeeDepartmentRow::dept_desc }));
+    }
+};
+
 class Employee
 {
 public:
 
     explicit Employee(TMyOracle* sql, int id)
-        : sql(sql), m_id(id), m_dept_id(0), m_first_name(""), m_last_name(""), m_dob(""), m_address(""), m_department("")
+        : sql(sql), m_id(id), m_dept_id(0), m_first_name(""), m_last_name(""), m_dob(), m_address(""), m_department("")
     {
     }
 
@@ -26,39 +73,83 @@ public:
     {
         if (!sql)
         {
-            std::cerr << "[ERROR] Employee::Build(): SQL connection is null" << std::endl;
+            TMYORACLE_LOG_ERROR("Employee::Build(): SQL connection is null");
             return false;
         }
 
         if (m_id <= 0)
         {
-            std::cerr << "[ERROR] Employee::Build(): Invalid emoloyee id" << std::endl;
+            TMYORACLE_LOG_ERROR("Employee::Build(): Invalid emoloyee id");
             return false;
         }
 
-        std::string id = std::to_string(m_id);
+        const TMyOracleReferenceCache::Table departments = g_reference_data.Get("DEPARTMENT");
+        const std::string query = departments
+            ? "SELECT FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID FROM employee WHERE id = :id"
+            : "SELECT FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID, DEPT_DESC FROM employee e INNER JOIN department d ON d.id = e.dept_id WHERE e.id = :id";
 
-        const std::string query = "SELECT FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID, DEPT_DESC FROM employee e INNER JOIN department d ON d.id = e.dept_id WHERE e.id =  " + id;
+        // Without a result cache the row is decoded straight into typed
+        // fields, the statement stays prepared on the connection
+        if (!sql->GetResultCache())
+        {
+            return departments ? BuildAs<EmployeeRow>(query, departments.get()) : BuildAs<EmployeeDepartmentRow>(query, nullptr);
+        }
 
-        // Execute a query
-        std::unique_ptr<TMyOracleResultSet> rs(sql->ExecuteQuery(query));
+        // With a result cache attached the rows may be shared with other
+        // readers.
+        std::shared_ptr<const TMyOracleResultSet> rs = sql->ExecuteCachedQuery(query, { TMyOracleBind(":id", m_id) });
         if (!rs || !rs->Rows())
         {
-            std::cerr << "[WARN] Employee::Build(): Unable to execute the query" << std::endl;
+            TMYORACLE_LOG_WARN("Employee::Build(): Unable to execute the query");
             return false;
         }
 
-        // Fetch the result
-        m_first_name = rs->Get("FIRSTNAME");
-        m_last_name = rs->Get("LASTNAME");
-        m_dob = rs->Get("DOB");
-        m_address = rs->Get("ADDRESS");
-        m_dept_id = std::atoi(rs->Get("DEPT_ID").c_str());
-        m_department = rs->Get("DEPT_DESC");
+        // The shared result is read by row, its current row is not moved
+        Load(*rs, 0, departments.get());
 
         return true;
     }
 
+    // Builds the employees of all ids with one query per chunk of ids
+    // instead of one query per id. Ids that are not found are skipped.
+    static std::vector<std::unique_ptr<Employee>> BuildMany(TMyOracle* sql, const std::vector<int64_t>& ids)
+    {
+        std::vector<std::unique_ptr<Employee>> employees;
+
+        if (!sql)
+        {
+            TMYORACLE_LOG_ERROR("Employee::BuildMany(): SQL connection is null");
+            return employees;
+        }
+
+        const TMyOracleReferenceCache::Table departments = g_reference_data.Get("DEPARTMENT");
+        const std::string query = departments
+            ? "SELECT ID, FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID FROM employee WHERE id IN (:KEYS)"
+            : "SELECT e.ID, FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID, DEPT_DESC FROM employee e INNER JOIN department d ON d.id = e.dept_id WHERE e.id IN (:KEYS)";
+
+        TMyOracleBatchResult results;
+        if (!sql->ExecuteBatch(query, "ID", ids, results))
+        {
+            TMYORACLE_LOG_WARN("Employee::BuildMany(): Unable to execute the query");
+        }
+
+        employees.reserve(ids.size());
+        for (const auto id : ids)
+        {
+            auto it = results.find(id);
+            if (it == results.end() || !it->second->Rows())
+            {
+                continue;
+            }
+
+            auto emp = std::make_unique<Employee>(sql, static_cast<int>(id));
+            emp->Load(*it->second, 0, departments.get());
+            employees.push_back(std::move(emp));
+        }
+
+        return employees;
+    }
+
     std::string ToString() const
     {
         std::ostringstream out;
@@ -71,117 +162,409 @@ public:
     }
 
 private:
+    template<typename Row>
+    bool BuildAs(const std::string& query, const TMyOracleReferenceTable* departments)
+    {
+        std::vector<Row> rows;
+        if (!sql->ExecuteAs(query, { TMyOracleBind(":id", m_id) }, rows) || rows.empty())
+        {
+            TMYORACLE_LOG_WARN("Employee::Build(): Unable to execute the query");
+            return false;
+        }
+
+        Row& row = rows.front();
+        m_first_name = std::move(row.first_name);
+        m_last_name = std::move(row.last_name);
+        m_dob = row.dob;
+        m_address = std::move(row.address);
+        m_dept_id = static_cast<int>(row.dept_id);
+        if constexpr (std::is_same_v<Row, EmployeeDepartmentRow>)
+        {
+            m_department = std::move(row.dept_desc);
+        }
+        else
+        {
+            m_department = departments ? departments->GetString(m_dept_id, "DEPT_DESC") : std::string();
+        }
+        return true;
+    }
+
+    // Without departments the rows carry DEPT_DESC from the server join
+    void Load(const TMyOracleResultSet& rs, size_t row, const TMyOracleReferenceTable* departments)
+    {
+        m_first_name = rs.Get(row, "FIRSTNAME");
+        m_last_name = rs.Get(row, "LASTNAME");
+        m_dob = rs.GetDate(row, "DOB");
+        m_address = rs.Get(row, "ADDRESS");
+        m_dept_id = static_cast<int>(rs.GetInt64(row, "DEPT_ID"));
+        m_department = departments ? departments->GetString(m_dept_id, "DEPT_DESC") : rs.Get(row, "DEPT_DESC");
+    }
+
     int m_id;
     int m_dept_id;
     std::string m_first_name;
     std::string m_last_name;
-    std::string m_dob;
+    TMyOracleDate m_dob;
     std::string m_address;
     std::string m_department;
 
     TMyOracle* sql;
 };
 //----------------------------------------------------------------------------
- int ocitest(TMyOracle* sql, int thread_id)  
- {   
-    if (!sql)  
-    {  
-        std::cerr << "[ERROR] ocitest: Failed to get SQL connection" << std::endl;  
-        return EXIT_FAILURE;  
-    }  
-    if (!sql->IsConnected())  
-    {  
-        std::cerr << "[ERROR] ocitest: SQL connection is not connected" << std::endl;  
-        return EXIT_FAILURE;  
-    }  
-
-    int loops = 100;  
-
-    const auto start = std::chrono::high_resolution_clock::now();  
-
-    auto tries = 0;  
-    while (tries++ < loops)  
-    {  
-        std::vector<std::unique_ptr<Employee>> employees;  
-        for (int i = 1; i <= 1000; ++i)  
-        {  
-            auto emp = std::make_unique<Employee>(sql, i);  
-            if (!emp->Build())  
-            {  
-                std::cerr << "[WARN] Main: Failed to build employee for id=" + std::to_string(i) << std::endl;  
-                continue;  
-            }  
-            employees.push_back(std::move(emp));  
-        }          
-        
-        std::cout << "Thread ID: " << thread_id << " | [Loop ID: " << tries << "] Total Employees Records build: " << employees.size() << std::endl;
-        employees.clear();  
-    }  
+// The benchmark operations on the EMPLOYEE / DEPARTMENT tables
+static void AddEmployeeOperations(TMyOracleBenchmark& benchmark, size_t batch_size, TMyOracleCommitPolicy commit, TMyOracleExecutor* hedger)
+{
+    // One employee by id, the statement stays prepared on the connection
+    benchmark.AddOperation("point", [](TMyOracle* sql, TMyOracleKeyGenerator& keys)
+    {
+        Employee employee(sql, static_cast<int>(keys.Next()));
+        return employee.Build();
+    });
+
+    // batch_size employees with one query per chunk of ids
+    benchmark.AddOperation("batch", [batch_size](TMyOracle* sql, TMyOracleKeyGenerator& keys)
+    {
+        const std::vector<int64_t> ids = keys.Next(batch_size);
+        return !Employee::BuildMany(sql, ids).empty();
+    });
+
+    // Every employee, streamed through a cursor. The values are read in
+    // place from the fetch buffer, the way a serializer forwards them.
+    benchmark.AddOperation("scan", [](TMyOracle* sql, TMyOracleKeyGenerator&)
+    {
+        std::unique_ptr<TMyOracleCursor> cursor = sql->OpenCursor("SELECT * FROM employee");
+        if (!cursor)
+        {
+            return false;
+        }
 
-    const auto end = std::chrono::high_resolution_clock::now();  
-    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();  
+        size_t bytes = 0;
+        while (cursor->NextView())
+        {
+            for (size_t column = 0; column < cursor->Columns(); ++column)
+            {
+                bytes += cursor->GetView(column).size();
+            }
+        }
+        return cursor->Rows() > 0 && bytes > 0;
+    });
 
-    std::cout << "Thread ID : " << thread_id << " completed in " << duration << " ms" << std::endl;  
+    // batch_size new employees, each committed on its own or all of them in
+    // one group commit
+    benchmark.AddOperation("write", [batch_size, commit](TMyOracle* sql, TMyOracleKeyGenerator& keys)
+    {
+        static const std::string INSERT_EMPLOYEE = "INSERT INTO employee (firstname, lastname, address, dept_id) VALUES (:1, :2, :3, :4)";
 
-    return EXIT_SUCCESS;  
- }
+        std::unique_ptr<TMyOracleGroupCommit> group;
+        if (commit != TMyOracleCommitPolicy::STATEMENT)
+        {
+            group = std::make_unique<TMyOracleGroupCommit>(sql, batch_size, std::chrono::microseconds::max(),
+                commit == TMyOracleCommitPolicy::NOWAIT ? TMyOracleCommitMode::NoWait : TMyOracleCommitMode::Wait);
+        }
+
+        bool success = true;
+        for (size_t row = 0; row < batch_size; ++row)
+        {
+            const int64_t key = keys.Next();
+            const TMyOracleBinds binds{ "Bench", "Writer" + std::to_string(key), "Load Street " + std::to_string(row), key % 3 + 1 };
+            success &= group ? group->Execute(INSERT_EMPLOYEE, binds) : sql->ExecuteStatement(INSERT_EMPLOYEE, binds);
+        }
+        return (!group || group->Flush()) && success;
+    });
+
+    // The point lookup as a hedged read on the workers of hedger, the
+    // connection of the benchmark thread is left alone
+    if (hedger)
+    {
+        benchmark.AddOperation("hedged", [hedger](TMyOracle*, TMyOracleKeyGenerator& keys)
+        {
+            static const std::string QUERY = "SELECT FIRSTNAME, LASTNAME, DOB, ADDRESS, DEPT_ID FROM employee WHERE id = :id";
+
+            std::unique_ptr<TMyOracleResultSet> rs = hedger->ExecuteHedgedQuery(QUERY, { TMyOracleBind(":id", keys.Next()) });
+            return rs && rs->Rows() > 0;
+        });
+    }
+}
+
+// Serves orclpdb from an in-process database loaded with the SQL_Tables
+// exports, so the test runs without a server
+static bool LoadSimulatedDatabase(const std::string& sql_dir, double spike_rate, double disconnect_rate)
+{
+    auto database = std::make_shared<TMyOracleSimDatabase>();
+    if (!database->LoadScript(sql_dir + "/dept.sql") || !database->LoadScript(sql_dir + "/employee.sql"))
+    {
+        return false;
+    }
+
+    TMyOracleSimConfig sim = database->GetConfig();
+    sim.spike_rate = spike_rate;
+    sim.disconnect_rate = disconnect_rate;
+    database->SetConfig(sim);
+
+    TMyOracleSimDatabase::Register("orclpdb", database);
+    return true;
+}
+
+// Loads a CSV in direct path, config.load_streams streams pulling rows from
+// the one reader
+static bool LoadDirectPath(const TMyOracleBenchmarkConfig& config)
+{
+    TMyOracleCsvReader reader;
+    if (!reader.Open(config.load_path))
+    {
+        return false;
+    }
+
+    TMyOracleDirectPathConfig load;
+    load.table = config.load_table;
+    load.array_rows = static_cast<unsigned int>(config.array_size);
+    load.parallel = config.load_streams;
+    for (const auto& column : reader.Columns())
+    {
+        load.columns.push_back({ column, 256, std::string() });
+    }
+
+    // Lines of the wrong width are skipped
+    size_t skipped = 0;
+    std::vector<std::string> fields;
+    std::vector<bool> quoted;
+    auto producer = [&](std::vector<TMyOracleValue>& row)
+    {
+        while (reader.Next(fields, quoted))
+        {
+            if (fields.size() != load.columns.size())
+            {
+                ++skipped;
+                continue;
+            }
+            for (auto& field : fields)
+            {
+                row.emplace_back(field.empty() ? TMyOracleValue(nullptr) : TMyOracleValue(std::move(field)));
+            }
+            return true;
+        }
+        return false;
+    };
+
+    TMyOracleDirectPathLoader loader(load);
+    TMyOracleDirectPathReport report;
+    const bool success = loader.Load(*g_sql_conn, producer, report);
+    TMyOracleLog::Flush();
+    report.Print(std::cout);
+    if (skipped > 0)
+    {
+        TMYORACLE_LOG_WARN("Main: ", skipped, " line(s) of ", config.load_path, " skipped, not ", load.columns.size(), " fields");
+    }
+    return success;
+}
+
+// Bulk loads the --load script or CSV with array DML. Rows the server
+// rejects are reported, only a failed round trip fails the load.
+static bool Load(const TMyOracleBenchmarkConfig& config)
+{
+    const bool csv = config.load_path.size() > 4 && std::to_upper(config.load_path.substr(config.load_path.size() - 4)) == ".CSV";
+    if (csv && config.load_table.empty())
+    {
+        TMYORACLE_LOG_ERROR("Main: --load ", config.load_path, " needs the table to load into, FILE:TABLE");
+        return false;
+    }
+    if (config.direct_path)
+    {
+        if (!csv)
+        {
+            TMYORACLE_LOG_ERROR("Main: --direct loads a CSV only");
+            return false;
+        }
+        return LoadDirectPath(config);
+    }
+
+    SqlConnectionLease sql = g_sql_conn->Acquire();
+    if (!sql)
+    {
+        TMYORACLE_LOG_ERROR("Main: No connection available for the load");
+        return false;
+    }
+
+    TMyOracleLoader loader(sql.get(), config.array_size);
+    TMyOracleLoadReport report;
+    const bool success = csv ? loader.LoadCsv(config.load_path, config.load_table, report) : loader.LoadScript(config.load_path, report);
+    TMyOracleLog::Flush();
+    report.Print(std::cout, config.load_path);
+    std::cout << std::defaultfloat;
+    return success;
+}
 
 int main(int argc, const char* argv[])
 {
-    if (g_oci_type == OCI_TYPE::OCI_CXX_API)
+    TMyOracleBenchmarkConfig config;
+    std::string error;
+    if (!config.Parse(argc, argv, error))
     {
-        ocilib::Environment::Initialize(Environment::Default | Environment::Threaded );
-        ocilib::Environment::EnableWarnings(true);
+        if (!error.empty())
+        {
+            TMYORACLE_LOG_ERROR("Main: ", error);
+        }
+        TMyOracleLog::Flush();
+        std::cerr << TMyOracleBenchmarkConfig::Usage();
+        return error.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    auto res = 0;
+    if (config.simulated)
+    {
+        if (!LoadSimulatedDatabase(config.sql_dir, config.spike_rate, config.disconnect_rate))
+        {
+            TMYORACLE_LOG_ERROR("Main: Failed to load the simulated database");
+            return EXIT_FAILURE;
+        }
+        g_oci_type = OCI_TYPE::OCI_SIMULATED;
+    }
+
+    if (!config.metrics_path.empty())
+    {
+        TMyOracleMetrics::SetEnabled(true);
+    }
+    TMyOracleArena::SetEnabled(config.arena);
+    TMyOracleLog::SetLevel(config.log_level);
+
+    auto res = EXIT_SUCCESS;
 	try
 	{
         // Initialize sql connection
-        g_sql_conn = std::make_unique<SqlConnection>("dev", "123456", "orclpdb", g_oci_type);
+        g_sql_conn = std::make_unique<SqlConnection>("dev", "123456", "orclpdb", g_oci_type,
+            std::min<size_t>(2, config.connections), config.connections, config.pool_type);
+        g_sql_conn->SetCallTimeout(config.call_timeout);
+
+        // One result cache for all the connections of the pool
+        if (config.cache_mb > 0)
+        {
+            g_sql_conn->SetResultCache(std::make_shared<TMyOracleResultCache>(config.cache_mb * 1024 * 1024, config.cache_ttl));
+        }
 
         // Build the connection pool
         if (!g_sql_conn->Build())
         {
-            std::cerr << "[ERROR] Main: Failed to build the SQL connection pool" << std::endl;
+            TMYORACLE_LOG_ERROR("Main: Failed to build the SQL connection pool");
             return EXIT_FAILURE;
         }
+        g_sql_conn->StartHealthCheck(config.health_interval);
 
-        std::vector<std::thread> oci_test_threads;
-		for (int i = 0; i < 20; ++i)
-		{
-            auto sql = g_sql_conn->GetConnection();
-			if (!sql)
-			{
-				std::cerr << "[ERROR] Main: Failed to get SQL connection" << std::endl;
-				return EXIT_FAILURE;
-			}
-			oci_test_threads.emplace_back(ocitest, sql, i);
-		}
-		for (auto& thread : oci_test_threads)
-		{
-			if (thread.joinable())
-			{
-				thread.join();
-			}
-		}
-		std::cout << "All threads completed successfully." << std::endl;
+        if (!config.load_path.empty() && !Load(config))
+        {
+            return EXIT_FAILURE;
+        }
+
+        // Replicate DEPARTMENT so the employee queries join it on the client
+        if (config.client_join)
+        {
+            g_reference_data.AddTable("DEPARTMENT", "ID");
+            if (g_reference_data.Load(*g_sql_conn))
+            {
+                g_reference_data.StartRefresh(*g_sql_conn, REFERENCE_REFRESH_INTERVAL);
+            }
+            else
+            {
+                TMYORACLE_LOG_WARN("Main: DEPARTMENT is not replicated, joining on the server");
+            }
+        }
+
+        // Workers of the hedged reads, on connections of the same pool
+        std::unique_ptr<TMyOracleExecutor> hedger;
+        if (config.hedge_threads > 0)
+        {
+            hedger = std::make_unique<TMyOracleExecutor>(g_sql_conn.get(), config.hedge_threads);
+        }
+
+        TMyOracleBenchmark benchmark(config);
+        AddEmployeeOperations(benchmark, config.batch_size, config.commit, hedger.get());
+
+        TMyOracleBenchmarkReport report;
+        if (benchmark.Run(*g_sql_conn, report))
+        {
+            // The messages of the run go before the report
+            TMyOracleLog::Flush();
+            report.Print(std::cout);
+            if (!config.json_path.empty() && report.WriteJson(config.json_path, config))
+            {
+                TMYORACLE_LOG_INFO("Report written to ", config.json_path);
+            }
+            if (const auto& cache = g_sql_conn->GetResultCache())
+            {
+                const TMyOracleResultCacheStats stats = cache->GetStats();
+                std::cout << "Result cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+                    << std::fixed << std::setprecision(1) << stats.HitRatio() * 100.0 << std::defaultfloat << "% hits), "
+                    << stats.entries << " entries, " << stats.bytes / 1024 << " KiB, "
+                    << stats.evictions << " evicted, " << stats.expirations << " expired" << std::endl;
+            }
+            if (hedger)
+            {
+                const TMyOracleHedgeStats stats = hedger->GetHedgeStats();
+                std::cout << "Hedged reads: " << stats.queries << ", " << stats.hedges << " run twice, " << stats.hedge_wins
+                    << " answered by the second run, delay ";
+                if (stats.delay == std::chrono::microseconds::max())
+                {
+                    std::cout << "none yet" << std::endl;
+                }
+                else
+                {
+                    std::cout << stats.delay.count() << " us" << std::endl;
+                }
+            }
+            if (config.call_timeout.count() > 0)
+            {
+                std::cout << "Call timeouts: " << TMyOracleWatchdog::Timeouts() << std::endl;
+            }
+            if (config.health_interval.count() > 0 || config.disconnect_rate > 0.0)
+            {
+                const SqlConnectionHealthStats stats = g_sql_conn->GetHealthStats();
+                std::cout << "Pool health: " << stats.pings << " pings, " << stats.dead << " lost, " << stats.reconnects << " reconnected, "
+                    << stats.evictions << " dropped, " << stats.failed_opens << " failed logons" << std::endl;
+            }
+            if (!config.metrics_path.empty())
+            {
+                TMyOracleMetrics::Print(std::cout, TMyOracleMetrics::Global().Snapshot());
+
+                std::vector<std::pair<std::string, TMyOracleMetricsSnapshot>> series = g_sql_conn->GetMetrics();
+                series.emplace(series.begin(), std::string(), TMyOracleMetrics::Global().Snapshot());
 
+                std::ofstream metrics(config.metrics_path);
+                TMyOracleMetrics::WritePrometheus(metrics, series);
+                if (metrics)
+                {
+                    TMYORACLE_LOG_INFO("Metrics written to ", config.metrics_path);
+                }
+                else
+                {
+                    TMYORACLE_LOG_ERROR("Main: Cannot write ", config.metrics_path);
+                }
+            }
+        }
+        else
+        {
+            res = EXIT_FAILURE;
+        }
+
+        // The refresh thread and the hedging workers use the pool
+        g_reference_data.StopRefresh();
+        hedger.reset();
         g_sql_conn->Disconnect();
+
+        // Cleans up the client library
+        g_sql_conn.reset();
 	}
 	catch (std::exception& ex)
 	{
-		std::cout << ex.what() << std::endl;
+		TMYORACLE_LOG_ERROR(ex.what());
+        res = EXIT_FAILURE;
 	}
 
-    // Cleanup OCI CXX API
-    if (g_oci_type == OCI_TYPE::OCI_CXX_API)
+	TMYORACLE_LOG_INFO("Exiting main");
+    TMyOracleLog::Stop();
+
+    // Keep the console open when started without options from the IDE
+    if (argc == 1)
     {
-        ocilib::Environment::Cleanup();
+        std::getchar();
     }
-
-	std::cout << "Exiting main" << std::endl;
-    std::getchar();
 	return res;
 }
 